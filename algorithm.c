@@ -117,9 +117,24 @@ void sha256d_midstate(struct work *work)
   endian_flip32(work->midstate, work->midstate);
 }
 
+/* Remember which kernel arguments hold the output buffer, so a pass can be
+ * pointed at another one without setting every argument again */
+static void note_output_arg(_clState *clState, cl_kernel kernel, cl_uint arg)
+{
+  if (clState->n_output_args < MAX_OUTPUT_ARGS) {
+    clState->output_kernels[clState->n_output_args] = kernel;
+    clState->output_args[clState->n_output_args++] = arg;
+  }
+}
+
 #define CL_SET_BLKARG(blkvar) status |= clSetKernelArg(*kernel, num++, sizeof(uint), (void *)&blk->blkvar)
 #define CL_SET_VARG(args, var) status |= clSetKernelArg(*kernel, num++, args * sizeof(uint), (void *)var)
-#define CL_SET_ARG_N(n, var) do { status |= clSetKernelArg(*kernel, n, sizeof(var), (void *)&var); } while (0)
+#define CL_SET_ARG_N(n, var) do { \
+  cl_uint arg_n = (n); \
+  if ((void *)&(var) == (void *)&clState->outputBuffer) \
+    note_output_arg(clState, *kernel, arg_n); \
+  status |= clSetKernelArg(*kernel, arg_n, sizeof(var), (void *)&var); \
+} while (0)
 #define CL_SET_ARG_0(var) CL_SET_ARG_N(0, var)
 #define CL_SET_ARG(var) CL_SET_ARG_N(num++, var)
 #define CL_NEXTKERNEL_SET_ARG_N(n, var) do { kernel++; CL_SET_ARG_N(n, var); } while (0)
@@ -159,6 +174,27 @@ static void append_blake256_compiler_options(struct _build_kernel_data *data, st
   strcat(data->binary_filename, buf);
 }
 
+/* FUSE_n runs stage n of a chain in the kernel of stage n - 1 */
+static void append_fuse_compiler_options(struct _build_kernel_data *data, struct _algorithm_t *algorithm)
+{
+  uint32_t fuse = get_algorithm_fuse_mask(algorithm);
+  char buf[32];
+  unsigned int i;
+
+  if (!fuse)
+    return;
+
+  for (i = 1; i < 32; i++) {
+    if (fuse & (1U << i)) {
+      sprintf(buf, " -D FUSE_%u", i);
+      strcat(data->compiler_options, buf);
+    }
+  }
+
+  sprintf(buf, "f%x", (unsigned int)fuse);
+  strcat(data->binary_filename, buf);
+}
+
 static void append_x11_compiler_options(struct _build_kernel_data *data, struct cgpu_info *cgpu, struct _algorithm_t *algorithm)
 {
   char buf[255];
@@ -168,6 +204,8 @@ static void append_x11_compiler_options(struct _build_kernel_data *data, struct
 
   sprintf(buf, "ku%u%s%s", (unsigned int)opt_keccak_unroll, ((opt_blake_compact) ? "bc" : ""), ((opt_luffa_parallel) ? "lp" : ""));
   strcat(data->binary_filename, buf);
+
+  append_fuse_compiler_options(data, algorithm);
 }
 
 
@@ -195,7 +233,7 @@ static cl_int queue_scrypt_kernel(struct __clState *clState, struct _dev_blk_ctx
 
   le_target = *(cl_uint *)(blk->work->device_target + 28);
   memcpy(clState->cldata, blk->work->data, 80);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -216,7 +254,7 @@ static cl_int queue_pascal_kernel(struct __clState *clState, struct _dev_blk_ctx
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip196(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 196, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 196, clState->cldata, 0, NULL, &clState->header_event);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -239,7 +277,7 @@ static cl_int queue_neoscrypt_kernel(_clState *clState, dev_blk_ctx *blk, __mayb
    * The compiler will get rid of it anyway. */
   le_target = (cl_uint)le32toh(((uint32_t *)blk->work->/*device_*/target)[7]);
   memcpy(clState->cldata, blk->work->data, 80);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -264,7 +302,7 @@ static cl_int queue_credits_kernel(_clState *clState, dev_blk_ctx *blk, __maybe_
 
   memcpy(clState->cldata, blk->work->data, 168);
 //  flip168(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 168, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 168, clState->cldata, 0, NULL, &clState->header_event);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -289,7 +327,7 @@ static cl_int queue_yescrypt_kernel(_clState *clState, dev_blk_ctx *blk, __maybe
 
 //  memcpy(clState->cldata, blk->work->data, 80);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -314,7 +352,7 @@ static cl_int queue_yescrypt_multikernel(_clState *clState, dev_blk_ctx *blk, __
   le_target = (cl_uint)le32toh(((uint32_t *)blk->work->/*device_*/target)[7]);
   memcpy(clState->cldata, blk->work->data, 80);
 //  flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 //pbkdf and initial sha
   kernel = &clState->kernel;
 
@@ -375,7 +413,7 @@ static cl_int queue_maxcoin_kernel(struct __clState *clState, struct _dev_blk_ct
   cl_int status = 0;
 
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -392,7 +430,7 @@ static cl_int queue_sph_kernel(struct __clState *clState, struct _dev_blk_ctx *b
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -401,46 +439,33 @@ static cl_int queue_sph_kernel(struct __clState *clState, struct _dev_blk_ctx *b
   return status;
 }
 
-static cl_int queue_darkcoin_mod_kernel(struct __clState *clState, struct _dev_blk_ctx *blk, __maybe_unused cl_uint threads)
+/* The X11/X13/X14/X15 chains: every stage kernel takes the same arguments,
+ * so --kernel-fuse can fold any stage into the kernel before it. Only the
+ * last kernel reports nonces, the others never touch their output. */
+static cl_int queue_chain_kernel(struct __clState *clState, struct _dev_blk_ctx *blk, __maybe_unused cl_uint threads)
 {
-  cl_kernel *kernel;
+  cl_kernel *kernel = &clState->kernel;
   unsigned int num;
   cl_ulong le_target;
   cl_int status = 0;
+  size_t i;
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
-
-  // blake - search
-  kernel = &clState->kernel;
-  num = 0;
-  CL_SET_ARG(clState->CLbuffer0);
-  CL_SET_ARG(clState->padbuffer8);
-  // bmw - search1
-  kernel = clState->extra_kernels;
-  CL_SET_ARG_0(clState->padbuffer8);
-  // groestl - search2
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // skein - search3
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // jh - search4
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // keccak - search5
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // luffa - search6
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // cubehash - search7
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // shavite - search8
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // simd - search9
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // echo - search10
-  num = 0;
-  CL_NEXTKERNEL_SET_ARG(clState->padbuffer8);
-  CL_SET_ARG(clState->outputBuffer);
-  CL_SET_ARG(le_target);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
+
+  for (i = 0; i <= clState->n_extra_kernels; i++) {
+    if (i > 0)
+      kernel = &clState->extra_kernels[i - 1];
+    num = 0;
+    CL_SET_ARG(clState->CLbuffer0);
+    CL_SET_ARG(clState->padbuffer8);
+    if (i == clState->n_extra_kernels)
+      CL_SET_ARG(clState->outputBuffer);
+    else
+      CL_SET_ARG(clState->padbuffer8);
+    CL_SET_ARG(le_target);
+  }
 
   return status;
 }
@@ -455,7 +480,7 @@ static cl_int queue_sibcoin_mod_kernel(struct __clState *clState, struct _dev_bl
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   // blake - search
   kernel = &clState->kernel;
@@ -493,58 +518,6 @@ static cl_int queue_sibcoin_mod_kernel(struct __clState *clState, struct _dev_bl
 }
 
 
-static cl_int queue_bitblock_kernel(struct __clState *clState, struct _dev_blk_ctx *blk, __maybe_unused cl_uint threads)
-{
-  cl_kernel *kernel;
-  unsigned int num;
-  cl_ulong le_target;
-  cl_int status = 0;
-
-  le_target = *(cl_ulong *)(blk->work->device_target + 24);
-  flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
-
-  // blake - search
-  kernel = &clState->kernel;
-  num = 0;
-  CL_SET_ARG(clState->CLbuffer0);
-  CL_SET_ARG(clState->padbuffer8);
-  // bmw - search1
-  kernel = clState->extra_kernels;
-  CL_SET_ARG_0(clState->padbuffer8);
-  // groestl - search2
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // skein - search3
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // jh - search4
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // keccak - search5
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // luffa - search6
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // cubehash - search7
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // shavite - search8
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // simd - search9
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // echo - search10
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // hamsi - search11
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // fugue - search12
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // hamsi - search11
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // fugue - search12
-  num = 0;
-  CL_NEXTKERNEL_SET_ARG(clState->padbuffer8);
-  CL_SET_ARG(clState->outputBuffer);
-  CL_SET_ARG(le_target);
-
-  return status;
-}
-
 static cl_int queue_bitblockold_kernel(struct __clState *clState, struct _dev_blk_ctx *blk, __maybe_unused cl_uint threads)
 {
   cl_kernel *kernel;
@@ -554,7 +527,7 @@ static cl_int queue_bitblockold_kernel(struct __clState *clState, struct _dev_bl
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   // blake - search
   kernel = &clState->kernel;
@@ -590,54 +563,6 @@ static cl_int queue_bitblockold_kernel(struct __clState *clState, struct _dev_bl
 }
 
 
-static cl_int queue_marucoin_mod_kernel(struct __clState *clState, struct _dev_blk_ctx *blk, __maybe_unused cl_uint threads)
-{
-  cl_kernel *kernel;
-  unsigned int num;
-  cl_ulong le_target;
-  cl_int status = 0;
-
-  le_target = *(cl_ulong *)(blk->work->device_target + 24);
-  flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
-
-  // blake - search
-  kernel = &clState->kernel;
-  num = 0;
-  CL_SET_ARG(clState->CLbuffer0);
-  CL_SET_ARG(clState->padbuffer8);
-  // bmw - search1
-  kernel = clState->extra_kernels;
-  CL_SET_ARG_0(clState->padbuffer8);
-  // groestl - search2
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // skein - search3
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // jh - search4
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // keccak - search5
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // luffa - search6
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // cubehash - search7
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // shavite - search8
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // simd - search9
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // echo - search10
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // hamsi - search11
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // fugue - search12
-  num = 0;
-  CL_NEXTKERNEL_SET_ARG(clState->padbuffer8);
-  CL_SET_ARG(clState->outputBuffer);
-  CL_SET_ARG(le_target);
-
-  return status;
-}
-
 static cl_int queue_marucoin_mod_old_kernel(struct __clState *clState, struct _dev_blk_ctx *blk, __maybe_unused cl_uint threads)
 {
   cl_kernel *kernel;
@@ -647,7 +572,7 @@ static cl_int queue_marucoin_mod_old_kernel(struct __clState *clState, struct _d
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   // blake - search
   kernel = &clState->kernel;
@@ -691,7 +616,7 @@ static cl_int queue_talkcoin_mod_kernel(struct __clState *clState, struct _dev_b
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   // blake - search
   kernel = &clState->kernel;
@@ -714,56 +639,6 @@ static cl_int queue_talkcoin_mod_kernel(struct __clState *clState, struct _dev_b
   return status;
 }
 
-static cl_int queue_x14_kernel(struct __clState *clState, struct _dev_blk_ctx *blk, __maybe_unused cl_uint threads)
-{
-  cl_kernel *kernel;
-  unsigned int num;
-  cl_ulong le_target;
-  cl_int status = 0;
-
-  le_target = *(cl_ulong *)(blk->work->device_target + 24);
-  flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
-
-  // blake - search
-  kernel = &clState->kernel;
-  num = 0;
-  CL_SET_ARG(clState->CLbuffer0);
-  CL_SET_ARG(clState->padbuffer8);
-  // bmw - search1
-  kernel = clState->extra_kernels;
-  CL_SET_ARG_0(clState->padbuffer8);
-  // groestl - search2
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // skein - search3
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // jh - search4
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // keccak - search5
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // luffa - search6
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // cubehash - search7
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // shavite - search8
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // simd - search9
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // echo - search10
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // hamsi - search11
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // fugue - search12
-  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
-  // shabal - search13
-  num = 0;
-  CL_NEXTKERNEL_SET_ARG(clState->padbuffer8);
-  CL_SET_ARG(clState->outputBuffer);
-  CL_SET_ARG(le_target);
-
-  return status;
-}
-
 static cl_int queue_x14_old_kernel(struct __clState *clState, struct _dev_blk_ctx *blk, __maybe_unused cl_uint threads)
 {
   cl_kernel *kernel;
@@ -773,7 +648,7 @@ static cl_int queue_x14_old_kernel(struct __clState *clState, struct _dev_blk_ct
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   // blake - search
   kernel = &clState->kernel;
@@ -817,7 +692,7 @@ static cl_int queue_fresh_kernel(struct __clState *clState, struct _dev_blk_ctx
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   // shavite 1 - search
   kernel = &clState->kernel;
@@ -848,7 +723,7 @@ static cl_int queue_whirlcoin_kernel(struct __clState *clState, struct _dev_blk_
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   //clbuffer, hashes
   kernel = &clState->kernel;
@@ -899,6 +774,7 @@ static cl_int queue_whirlpoolx_kernel(struct __clState *clState, struct _dev_blk
   status |= clSetKernelArg(clState->kernel, 1, sizeof(cl_ulong), (void *)(((uint64_t *)clState->cldata) + 8));
   status |= clSetKernelArg(clState->kernel, 2, sizeof(cl_ulong), (void *)(((uint64_t *)clState->cldata) + 9));
   status |= clSetKernelArg(clState->kernel, 3, sizeof(cl_mem), (void *)&clState->outputBuffer);
+  note_output_arg(clState, clState->kernel, 3);
   status |= clSetKernelArg(clState->kernel, 4, sizeof(cl_ulong), (void *)&le_target);
 
   return status;
@@ -913,7 +789,7 @@ static cl_int queue_lyra2re_kernel(struct __clState *clState, struct _dev_blk_ct
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   // blake - search
   kernel = &clState->kernel;
@@ -958,7 +834,7 @@ static cl_int queue_lyra2rev2_kernel(struct __clState *clState, struct _dev_blk_
   //  le_target = *(cl_uint *)(blk->work->device_target + 28);
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   // blake - search
   kernel = &clState->kernel;
@@ -1011,7 +887,7 @@ static cl_int queue_pluck_kernel(_clState *clState, dev_blk_ctx *blk, __maybe_un
 
   le_target = (cl_uint)le32toh(((uint32_t *)blk->work->/*device_*/target)[7]);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -1030,7 +906,7 @@ static cl_int queue_blake_kernel(_clState *clState, dev_blk_ctx *blk, __maybe_un
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   CL_SET_ARG(clState->outputBuffer);
   CL_SET_ARG(blk->work->blk.ctx_a);
@@ -1058,7 +934,7 @@ static cl_int queue_sia_kernel(struct __clState *clState, struct _dev_blk_ctx *b
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 80, clState->cldata, 0, NULL, &clState->header_event);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -1109,7 +985,7 @@ static cl_int queue_lbry_kernel(struct __clState *clState, struct _dev_blk_ctx *
 
   le_target = *(cl_ulong *)(blk->work->target + 24);
   flip112(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 112, clState->cldata, 0, NULL, NULL);
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, CL_FALSE, 0, 112, clState->cldata, 0, NULL, &clState->header_event);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->padbuffer8);
@@ -1154,7 +1030,7 @@ static algorithm_settings_t algos[] = {
 #undef A_CREDITS
 
 #define A_DECRED(a) \
-  { a, ALGO_DECRED, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, decred_regenhash, decred_midstate, decred_prepare_work, queue_decred_kernel, gen_hash, append_blake256_compiler_options }
+  { a, ALGO_DECRED, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, decred_regenhash, decred_midstate, decred_prepare_work, queue_decred_kernel, gen_hash, append_blake256_compiler_options, NULL, NULL, 4 }
   A_DECRED("decred"),
 #undef A_DECRED
 
@@ -1169,39 +1045,39 @@ static algorithm_settings_t algos[] = {
 #undef A_YESCRYPT_MULTI
 
   // kernels starting from this will have difficulty calculated by using quarkcoin algorithm
-#define A_QUARK(a, b) \
-  { a, ALGO_QUARK, "", 256, 256, 256, 0, 0, 0xFF, 0xFFFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, b, NULL, NULL, queue_sph_kernel, gen_hash, append_x11_compiler_options }
-  A_QUARK("quarkcoin", quarkcoin_regenhash),
-  A_QUARK("qubitcoin", qubitcoin_regenhash),
-  A_QUARK("animecoin", animecoin_regenhash),
-  A_QUARK("sifcoin", sifcoin_regenhash),
+#define A_QUARK(a, b, c) \
+  { a, ALGO_QUARK, "", 256, 256, 256, 0, 0, 0xFF, 0xFFFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, b, NULL, NULL, queue_sph_kernel, gen_hash, append_x11_compiler_options, c }
+  A_QUARK("quarkcoin", quarkcoin_regenhash, quarkcoin_regenhash_batch),
+  A_QUARK("qubitcoin", qubitcoin_regenhash, NULL),
+  A_QUARK("animecoin", animecoin_regenhash, animecoin_regenhash_batch),
+  A_QUARK("sifcoin", sifcoin_regenhash, NULL),
 #undef A_QUARK
 
   // kernels starting from this will have difficulty calculated by using bitcoin algorithm
-#define A_DARK(a, b) \
-  { a, ALGO_X11, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, b, NULL, NULL, queue_sph_kernel, gen_hash, append_x11_compiler_options }
-  A_DARK("darkcoin", darkcoin_regenhash),
-  A_DARK("sibcoin", sibcoin_regenhash),  
-  A_DARK("inkcoin", inkcoin_regenhash),
-  A_DARK("myriadcoin-groestl", myriadcoin_groestl_regenhash),
+#define A_DARK(a, b, c) \
+  { a, ALGO_X11, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, b, NULL, NULL, queue_sph_kernel, gen_hash, append_x11_compiler_options, c }
+  A_DARK("darkcoin", darkcoin_regenhash, darkcoin_regenhash_batch),
+  A_DARK("sibcoin", sibcoin_regenhash, sibcoin_regenhash_batch),
+  A_DARK("inkcoin", inkcoin_regenhash, NULL),
+  A_DARK("myriadcoin-groestl", myriadcoin_groestl_regenhash, NULL),
 #undef A_DARK
 
   { "twecoin", ALGO_TWE, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, twecoin_regenhash, NULL, NULL, queue_sph_kernel, sha256, NULL },
   { "maxcoin", ALGO_KECCAK, "", 1, 256, 1, 4, 15, 0x0F, 0xFFFFULL, 0x000000ffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, maxcoin_regenhash, NULL, NULL, queue_maxcoin_kernel, sha256, NULL },
 
-  { "darkcoin-mod", ALGO_X11, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 8 * 16 * 4194304, 0, darkcoin_regenhash, NULL, NULL, queue_darkcoin_mod_kernel, gen_hash, append_x11_compiler_options },
+  { "darkcoin-mod", ALGO_X11, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 8 * 16 * 4194304, 0, darkcoin_regenhash, NULL, NULL, queue_chain_kernel, gen_hash, append_x11_compiler_options, darkcoin_regenhash_batch, "none" },
 
-  { "sibcoin-mod", ALGO_X11, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 11, 2 * 16 * 4194304, 0, sibcoin_regenhash, NULL, NULL, queue_sibcoin_mod_kernel, gen_hash, append_x11_compiler_options },
+  { "sibcoin-mod", ALGO_X11, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 11, 2 * 16 * 4194304, 0, sibcoin_regenhash, NULL, NULL, queue_sibcoin_mod_kernel, gen_hash, append_x11_compiler_options, sibcoin_regenhash_batch },
   
-  { "marucoin", ALGO_X13, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, marucoin_regenhash, NULL, NULL, queue_sph_kernel, gen_hash, append_x13_compiler_options },
-  { "marucoin-mod", ALGO_X13, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 12, 8 * 16 * 4194304, 0, marucoin_regenhash, NULL, NULL, queue_marucoin_mod_kernel, gen_hash, append_x13_compiler_options },
-  { "marucoin-modold", ALGO_X13, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 8 * 16 * 4194304, 0, marucoin_regenhash, NULL, NULL, queue_marucoin_mod_old_kernel, gen_hash, append_x13_compiler_options },
+  { "marucoin", ALGO_X13, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, marucoin_regenhash, NULL, NULL, queue_sph_kernel, gen_hash, append_x13_compiler_options, marucoin_regenhash_batch },
+  { "marucoin-mod", ALGO_X13, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 12, 8 * 16 * 4194304, 0, marucoin_regenhash, NULL, NULL, queue_chain_kernel, gen_hash, append_x13_compiler_options, marucoin_regenhash_batch, "none" },
+  { "marucoin-modold", ALGO_X13, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 8 * 16 * 4194304, 0, marucoin_regenhash, NULL, NULL, queue_marucoin_mod_old_kernel, gen_hash, append_x13_compiler_options, marucoin_regenhash_batch },
 
-  { "x14", ALGO_X14, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 13, 8 * 16 * 4194304, 0, x14_regenhash, NULL, NULL, queue_x14_kernel, gen_hash, append_x13_compiler_options },
-  { "x14old", ALGO_X14, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 8 * 16 * 4194304, 0, x14_regenhash, NULL, NULL, queue_x14_old_kernel, gen_hash, append_x13_compiler_options },
+  { "x14", ALGO_X14, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 13, 8 * 16 * 4194304, 0, x14_regenhash, NULL, NULL, queue_chain_kernel, gen_hash, append_x13_compiler_options, x14_regenhash_batch, "none" },
+  { "x14old", ALGO_X14, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 8 * 16 * 4194304, 0, x14_regenhash, NULL, NULL, queue_x14_old_kernel, gen_hash, append_x13_compiler_options, x14_regenhash_batch },
 
-  { "bitblock", ALGO_X15, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 14, 4 * 16 * 4194304, 0, bitblock_regenhash, NULL, NULL, queue_bitblock_kernel, gen_hash, append_x13_compiler_options },
-  { "bitblockold", ALGO_X15, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 4 * 16 * 4194304, 0, bitblock_regenhash, NULL, NULL, queue_bitblockold_kernel, gen_hash, append_x13_compiler_options },
+  { "bitblock", ALGO_X15, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 14, 4 * 16 * 4194304, 0, bitblock_regenhash, NULL, NULL, queue_chain_kernel, gen_hash, append_x13_compiler_options, bitblock_regenhash_batch, "none" },
+  { "bitblockold", ALGO_X15, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 4 * 16 * 4194304, 0, bitblock_regenhash, NULL, NULL, queue_bitblockold_kernel, gen_hash, append_x13_compiler_options, bitblock_regenhash_batch },
 
   { "talkcoin-mod", ALGO_NIST, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 4, 8 * 16 * 4194304, 0, talkcoin_regenhash, NULL, NULL, queue_talkcoin_mod_kernel, gen_hash, append_x11_compiler_options },
 
@@ -1221,14 +1097,14 @@ static algorithm_settings_t algos[] = {
   { "whirlcoin", ALGO_WHIRL, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 3, 8 * 16 * 4194304, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, whirlcoin_regenhash, NULL, NULL, queue_whirlcoin_kernel, sha256, NULL },
   { "whirlpoolx", ALGO_WHIRLPOOLX, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000FFFFUL, 0, 0, 0, whirlpoolx_regenhash, NULL, NULL, queue_whirlpoolx_kernel, gen_hash, NULL },
 
-  { "blake256r8",  ALGO_BLAKECOIN, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x000000ffUL, 0, 128, 0, blakecoin_regenhash, blakecoin_midstate, blakecoin_prepare_work, queue_blake_kernel, sha256,   NULL },
-  { "blake256r14", ALGO_BLAKE,     "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x00000000UL, 0, 128, 0, blake256_regenhash, blake256_midstate, blake256_prepare_work, queue_blake_kernel, gen_hash, NULL },
-  { "sia",         ALGO_SIA,       "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000FFFFUL, 0, 128, 0, sia_regenhash, NULL, NULL, queue_sia_kernel, NULL, NULL },
-  { "vanilla",     ALGO_VANILLA,   "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x000000ffUL, 0, 128, 0, blakecoin_regenhash, blakecoin_midstate, blakecoin_prepare_work, queue_blake_kernel, gen_hash, NULL },
+  { "blake256r8",  ALGO_BLAKECOIN, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x000000ffUL, 0, 128, 0, blakecoin_regenhash, blakecoin_midstate, blakecoin_prepare_work, queue_blake_kernel, sha256,   NULL, NULL, NULL, 4 },
+  { "blake256r14", ALGO_BLAKE,     "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x00000000UL, 0, 128, 0, blake256_regenhash, blake256_midstate, blake256_prepare_work, queue_blake_kernel, gen_hash, NULL, NULL, NULL, 4 },
+  { "sia",         ALGO_SIA,       "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000FFFFUL, 0, 128, 0, sia_regenhash, NULL, NULL, queue_sia_kernel, NULL, NULL, NULL, NULL, 4 },
+  { "vanilla",     ALGO_VANILLA,   "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x000000ffUL, 0, 128, 0, blakecoin_regenhash, blakecoin_midstate, blakecoin_prepare_work, queue_blake_kernel, gen_hash, NULL, NULL, NULL, 4 },
 
   { "lbry", ALGO_LBRY, "", 1, 256, 256, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 2, 4 * 8 * 4194304, 0, lbry_regenhash, NULL, NULL, queue_lbry_kernel, gen_hash, NULL },
 
-  { "pascal", ALGO_PASCAL, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, pascal_regenhash, pascal_midstate, NULL, queue_pascal_kernel, NULL, NULL },
+  { "pascal", ALGO_PASCAL, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, pascal_regenhash, pascal_midstate, NULL, queue_pascal_kernel, NULL, NULL, NULL, NULL, 4 },
 
   // Terminator (do not remove)
   { NULL, ALGO_UNK, "", 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, NULL, NULL, NULL, NULL, NULL }
@@ -1264,6 +1140,10 @@ void copy_algorithm_settings(algorithm_t* dest, const char* algo)
       dest->queue_kernel = src->queue_kernel;
       dest->gen_hash = src->gen_hash;
       dest->set_compile_options = src->set_compile_options;
+      dest->regenhash_batch = src->regenhash_batch;
+      dest->fuse_groups = src->fuse_groups;
+      dest->max_vwidth = src->max_vwidth;
+      dest->kernel = NULL;
       break;
     }
   }
@@ -1276,6 +1156,119 @@ void copy_algorithm_settings(algorithm_t* dest, const char* algo)
   }
 }
 
+const char *get_algorithm_name(int idx)
+{
+  if (idx < 0 || idx >= (int)(sizeof(algos) / sizeof(algos[0])))
+    return NULL;
+  return algos[idx].name;
+}
+
+/* Kernels are interchangeable when the host side treats their work, hashes
+ * and shares the same way */
+static bool same_pow(const algorithm_settings_t *a, const algorithm_settings_t *b)
+{
+  return a->type == b->type && a->regenhash == b->regenhash &&
+    a->calc_midstate == b->calc_midstate && a->prepare_work == b->prepare_work &&
+    a->gen_hash == b->gen_hash && a->diff_numerator == b->diff_numerator &&
+    a->diff1targ == b->diff1targ && a->diff_multiplier1 == b->diff_multiplier1 &&
+    a->diff_multiplier2 == b->diff_multiplier2 &&
+    a->share_diff_multiplier == b->share_diff_multiplier;
+}
+
+int get_algorithm_variants(const algorithm_t *algo, const char **names, int max)
+{
+  algorithm_settings_t *own, *src;
+  int n = 0;
+
+  for (own = algos; own->name; own++)
+    if (strcasecmp(own->name, algo->name) == 0)
+      break;
+  if (!own->name)
+    return 0;
+
+  for (src = algos; src->name && n < max; src++)
+    if (same_pow(own, src))
+      names[n++] = src->name;
+
+  return n;
+}
+
+void set_algorithm_kernel(algorithm_t *algo, const char *name)
+{
+  char own[sizeof(algo->name)];
+  const char *kernelfile = algo->kernelfile;
+  algorithm_settings_t *src;
+
+  for (src = algos; src->name; src++)
+    if (strcasecmp(src->name, name) == 0)
+      break;
+  if (!src->name)
+    return;
+
+  strcpy(own, algo->name);
+  copy_algorithm_settings(algo, src->name);
+  strcpy(algo->name, own);
+  algo->kernelfile = kernelfile;
+  if (strcasecmp(src->name, own))
+    algo->kernel = src->name;
+}
+
+const char *get_algorithm_kernel(const algorithm_t *algo)
+{
+  return algo->kernel ? algo->kernel : algo->name;
+}
+
+bool parse_fuse_groups(const char *spec, uint32_t *mask)
+{
+  const char *p = spec;
+  long prev = -1;
+
+  *mask = 0;
+  if (!strcasecmp(spec, "none"))
+    return true;
+  if (!strcasecmp(spec, "all")) {
+    *mask = ~1U;
+    return true;
+  }
+
+  while (*p) {
+    char *end;
+    long first, last, i;
+
+    first = last = strtol(p, &end, 10);
+    if (end == p || first <= prev || first > 31)
+      return false;
+    if (*end == '-') {
+      p = end + 1;
+      last = strtol(p, &end, 10);
+      if (end == p || last < first || last > 31)
+        return false;
+    }
+    for (i = first + 1; i <= last; i++)
+      *mask |= 1U << i;
+    prev = last;
+
+    if (*end == ',')
+      end++;
+    else if (*end)
+      return false;
+    p = end;
+  }
+
+  return prev >= 0;
+}
+
+uint32_t get_algorithm_fuse_mask(const algorithm_t *algo)
+{
+  uint32_t mask;
+
+  if (!algo->fuse_groups || !parse_fuse_groups(opt_kernel_fuse ? opt_kernel_fuse : algo->fuse_groups, &mask))
+    return 0;
+
+  /* Stage 0 always starts a kernel, and the chain has n_extra_kernels + 1 */
+  return mask & ~1U & (uint32_t)((1ULL << (algo->n_extra_kernels + 1)) - 1);
+}
+
 static const char *lookup_algorithm_alias(const char *lookup_alias, uint8_t *nfactor)
 {
 #define ALGO_ALIAS_NF(alias, name, nf) \
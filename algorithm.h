@@ -46,6 +46,7 @@ typedef enum {
 
 extern const char *algorithm_type_str[];
 
+extern void sha256(const unsigned char *message, unsigned int len, unsigned char *digest);
 extern void gen_hash(const unsigned char *data, unsigned int len, unsigned char *hash);
 
 struct __clState;
@@ -80,6 +81,14 @@ typedef struct _algorithm_t {
   cl_int(*queue_kernel)(struct __clState *, struct _dev_blk_ctx *, cl_uint);
   void(*gen_hash)(const unsigned char *, unsigned int, unsigned char *);
   void(*set_compile_options)(struct _build_kernel_data *, struct cgpu_info *, struct _algorithm_t *);
+  /* Optional. Hashes several nonces of the same work, e.g. all the nonces a
+   * GPU reported in one pass, absorbing the header without the nonce only
+   * once. The nonces are in host order, as set_work_nonce takes them, and
+   * each hash must match what regenhash gives for that nonce. */
+  void(*regenhash_batch)(struct work *, const uint32_t *, unsigned char *, int);
+  const char *fuse_groups; /* default --kernel-fuse stage groups, NULL if the chain cannot fuse */
+  cl_uint max_vwidth; /* nonces the kernel can hash per work item (VECTORS), 0 if it is scalar only */
+  const char *kernel; /* kernel of its family that --auto-kernel picked, NULL for its own */
 } algorithm_t;
 
 typedef struct _algorithm_settings_t
@@ -104,11 +113,37 @@ typedef struct _algorithm_settings_t
 	cl_int   (*queue_kernel)(struct __clState *, struct _dev_blk_ctx *, cl_uint);
 	void     (*gen_hash)(const unsigned char *, unsigned int, unsigned char *);
 	void     (*set_compile_options)(build_kernel_data *, struct cgpu_info *, algorithm_t *);
+	void     (*regenhash_batch)(struct work *, const uint32_t *, unsigned char *, int);
+	const char *fuse_groups;
+	cl_uint     max_vwidth;
 } algorithm_settings_t;
 
 /* Set default parameters based on name. */
 void set_algorithm(algorithm_t* algo, const char* name);
 
+/* Name of the algorithm at idx in the settings table, NULL past the end. */
+const char *get_algorithm_name(int idx);
+
+/* Names of the kernels that mine the same PoW as algo, itself included, in
+ * table order so the first is the same for the whole family. Returns how
+ * many of them were stored in names. */
+int get_algorithm_variants(const algorithm_t *algo, const char **names, int max);
+
+/* Run the kernel of name, another algorithm of the same PoW, keeping algo's
+ * name so that it still compares equal to the pools' algorithm. */
+void set_algorithm_kernel(algorithm_t *algo, const char *name);
+
+/* Name of the kernel algo runs: its own or the one picked for its family. */
+const char *get_algorithm_kernel(const algorithm_t *algo);
+
+/* Parse a --kernel-fuse value ("none", "all" or stage ranges such as
+ * "0-1,2-4,5-7") into a mask of the stages that run in the kernel of the
+ * stage before them. Returns false if it is malformed. */
+bool parse_fuse_groups(const char *spec, uint32_t *mask);
+
+/* Fused stage mask for a chain algorithm, 0 for those that cannot fuse. */
+uint32_t get_algorithm_fuse_mask(const algorithm_t *algo);
+
 /* Set to specific N factor. */
 void set_algorithm_nfactor(algorithm_t* algo, const uint8_t nfactor);
 
@@ -38,10 +38,8 @@
 #include "sph/sph_jh.h"
 #include "sph/sph_keccak.h" 
 
-#ifdef __APPLE_CC__
-static
-#endif
-void animehash(void *state, const void *input)
+/* Runs the rest of the chain once bmw has absorbed the whole header */
+static void animehash_chain(sph_bmw512_context *first, void *state)
 {
     sph_blake512_context     ctx_blake;
     sph_bmw512_context       ctx_bmw;
@@ -52,10 +50,7 @@ void animehash(void *state, const void *input)
     
     unsigned char hash[64];
 
-    sph_bmw512_init(&ctx_bmw);
-    // ZBMW;
-    sph_bmw512 (&ctx_bmw, input, 80);
-    sph_bmw512_close(&ctx_bmw, (void*) hash);
+    sph_bmw512_close(first, (void*) hash);
 
     sph_blake512_init(&ctx_blake);
     // ZBLAKE;
@@ -130,6 +125,18 @@ void animehash(void *state, const void *input)
     memcpy(state, hash, 32);
 }
 
+#ifdef __APPLE_CC__
+static
+#endif
+void animehash(void *state, const void *input)
+{
+    sph_bmw512_context ctx_bmw;
+
+    sph_bmw512_init(&ctx_bmw);
+    sph_bmw512 (&ctx_bmw, input, 80);
+    animehash_chain(&ctx_bmw, state);
+}
+
 static const uint32_t diff1targ = 0x0000ffff;
 
 
@@ -166,6 +173,24 @@ void animecoin_regenhash(struct work *work)
         animehash(ohash, data);
 }
 
+void animecoin_regenhash_batch(struct work *work, const uint32_t *nonces, unsigned char *hashes, int count)
+{
+        sph_bmw512_context prefix, ctx;
+        uint32_t data[19], nonce_be;
+        int i;
+
+        be32enc_vect(data, (const uint32_t *)work->data, 19);
+        sph_bmw512_init(&prefix);
+        sph_bmw512 (&prefix, data, 76);
+
+        for (i = 0; i < count; i++) {
+                memcpy(&ctx, &prefix, sizeof(prefix));
+                nonce_be = htobe32(htole32(nonces[i]));
+                sph_bmw512 (&ctx, &nonce_be, 4);
+                animehash_chain(&ctx, hashes + i * 32);
+        }
+}
+
 bool scanhash_animecoin(struct thr_info *thr, const unsigned char __maybe_unused *pmidstate,
 		     unsigned char *pdata, unsigned char __maybe_unused *phash1,
 		     unsigned char __maybe_unused *phash, const unsigned char *ptarget,
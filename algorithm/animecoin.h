@@ -6,5 +6,7 @@
 extern int animecoin_test(unsigned char *pdata, const unsigned char *ptarget,
 			uint32_t nonce);
 extern void animecoin_regenhash(struct work *work);
+extern void animecoin_regenhash_batch(struct work *work, const uint32_t *nonces,
+			unsigned char *hashes, int count);
 
 #endif /* ANIMECOIN_H */
@@ -70,11 +70,15 @@ typedef struct {
     sph_whirlpool_context   whirlpool1;
 } Xhash_context_holder;
 
-static Xhash_context_holder base_contexts;
+static __thread Xhash_context_holder base_contexts;
+static __thread bool base_contexts_ready;
 
 
 void init_Bhash_contexts()
 {
+    if (likely(base_contexts_ready))
+        return;
+
     sph_blake512_init(&base_contexts.blake1);
     sph_bmw512_init(&base_contexts.bmw1);
     sph_groestl512_init(&base_contexts.groestl1);
@@ -90,68 +94,73 @@ void init_Bhash_contexts()
     sph_fugue512_init(&base_contexts.fugue1);
     sph_shabal512_init(&base_contexts.shabal1);
     sph_whirlpool_init(&base_contexts.whirlpool1);
+    base_contexts_ready = true;
 }
 
-#ifdef __APPLE_CC__
-static
-#endif
-void bitblockhash(void *state, const void *input)
+/* Runs the rest of the chain once blake has absorbed the whole header */
+static void bitblockhash_chain(Xhash_context_holder *ctx, void *state)
 {
-    init_Bhash_contexts();
-
-    Xhash_context_holder ctx;
-
     uint32_t hashA[16], hashB[16];
 
-    memcpy(&ctx, &base_contexts, sizeof(base_contexts));
-
-    sph_blake512 (&ctx.blake1, input, 80);
-    sph_blake512_close (&ctx.blake1, hashA);
+    sph_blake512_close (&ctx->blake1, hashA);
 
-    sph_bmw512 (&ctx.bmw1, hashA, 64);
-    sph_bmw512_close(&ctx.bmw1, hashB);
+    sph_bmw512 (&ctx->bmw1, hashA, 64);
+    sph_bmw512_close(&ctx->bmw1, hashB);
 
-    sph_groestl512 (&ctx.groestl1, hashB, 64);
-    sph_groestl512_close(&ctx.groestl1, hashA);
+    sph_groestl512 (&ctx->groestl1, hashB, 64);
+    sph_groestl512_close(&ctx->groestl1, hashA);
 
-    sph_skein512 (&ctx.skein1, hashA, 64);
-    sph_skein512_close(&ctx.skein1, hashB);
+    sph_skein512 (&ctx->skein1, hashA, 64);
+    sph_skein512_close(&ctx->skein1, hashB);
 
-    sph_jh512 (&ctx.jh1, hashB, 64);
-    sph_jh512_close(&ctx.jh1, hashA);
+    sph_jh512 (&ctx->jh1, hashB, 64);
+    sph_jh512_close(&ctx->jh1, hashA);
 
-    sph_keccak512 (&ctx.keccak1, hashA, 64);
-    sph_keccak512_close(&ctx.keccak1, hashB);
+    sph_keccak512 (&ctx->keccak1, hashA, 64);
+    sph_keccak512_close(&ctx->keccak1, hashB);
 
-    sph_luffa512 (&ctx.luffa1, hashB, 64);
-    sph_luffa512_close (&ctx.luffa1, hashA);
+    sph_luffa512 (&ctx->luffa1, hashB, 64);
+    sph_luffa512_close (&ctx->luffa1, hashA);
 
-    sph_cubehash512 (&ctx.cubehash1, hashA, 64);
-    sph_cubehash512_close(&ctx.cubehash1, hashB);
+    sph_cubehash512 (&ctx->cubehash1, hashA, 64);
+    sph_cubehash512_close(&ctx->cubehash1, hashB);
 
-    sph_shavite512 (&ctx.shavite1, hashB, 64);
-    sph_shavite512_close(&ctx.shavite1, hashA);
+    sph_shavite512 (&ctx->shavite1, hashB, 64);
+    sph_shavite512_close(&ctx->shavite1, hashA);
 
-    sph_simd512 (&ctx.simd1, hashA, 64);
-    sph_simd512_close(&ctx.simd1, hashB);
+    sph_simd512 (&ctx->simd1, hashA, 64);
+    sph_simd512_close(&ctx->simd1, hashB);
 
-    sph_echo512 (&ctx.echo1, hashB, 64);
-    sph_echo512_close(&ctx.echo1, hashA);
+    sph_echo512 (&ctx->echo1, hashB, 64);
+    sph_echo512_close(&ctx->echo1, hashA);
 
-    sph_hamsi512 (&ctx.hamsi1, hashA, 64);
-    sph_hamsi512_close(&ctx.hamsi1, hashB);
+    sph_hamsi512 (&ctx->hamsi1, hashA, 64);
+    sph_hamsi512_close(&ctx->hamsi1, hashB);
 
-    sph_fugue512 (&ctx.fugue1, hashB, 64);
-    sph_fugue512_close(&ctx.fugue1, hashA);
+    sph_fugue512 (&ctx->fugue1, hashB, 64);
+    sph_fugue512_close(&ctx->fugue1, hashA);
 
-    sph_shabal512 (&ctx.shabal1, (const unsigned char*)hashA, 64);
-    sph_shabal512_close(&ctx.shabal1, hashB);
+    sph_shabal512 (&ctx->shabal1, (const unsigned char*)hashA, 64);
+    sph_shabal512_close(&ctx->shabal1, hashB);
 
-    sph_whirlpool (&ctx.whirlpool1, hashB, 64);
-    sph_whirlpool_close(&ctx.whirlpool1, hashA);
+    sph_whirlpool (&ctx->whirlpool1, hashB, 64);
+    sph_whirlpool_close(&ctx->whirlpool1, hashA);
 
     memcpy(state, hashA, 32);
+}
+
+#ifdef __APPLE_CC__
+static
+#endif
+void bitblockhash(void *state, const void *input)
+{
+    Xhash_context_holder ctx;
+
+    init_Bhash_contexts();
+    memcpy(&ctx, &base_contexts, sizeof(base_contexts));
 
+    sph_blake512 (&ctx.blake1, input, 80);
+    bitblockhash_chain(&ctx, state);
 }
 
 static const uint32_t diff1targ = 0x0000ffff;
@@ -190,6 +199,25 @@ void bitblock_regenhash(struct work *work)
   bitblockhash(ohash, data);
 }
 
+void bitblock_regenhash_batch(struct work *work, const uint32_t *nonces, unsigned char *hashes, int count)
+{
+  Xhash_context_holder prefix, ctx;
+  uint32_t data[19], nonce_be;
+  int i;
+
+  init_Bhash_contexts();
+  be32enc_vect(data, (const uint32_t *)work->data, 19);
+  memcpy(&prefix, &base_contexts, sizeof(base_contexts));
+  sph_blake512 (&prefix.blake1, data, 76);
+
+  for (i = 0; i < count; i++) {
+    memcpy(&ctx, &prefix, sizeof(prefix));
+    nonce_be = htobe32(htole32(nonces[i]));
+    sph_blake512 (&ctx.blake1, &nonce_be, 4);
+    bitblockhash_chain(&ctx, hashes + i * 32);
+  }
+}
+
 bool scanhash_bitblock(struct thr_info *thr, const unsigned char __maybe_unused *pmidstate,
          unsigned char *pdata, unsigned char __maybe_unused *phash1,
          unsigned char __maybe_unused *phash, const unsigned char *ptarget,
@@ -6,5 +6,7 @@
 extern int darkcoin_test(unsigned char *pdata, const unsigned char *ptarget,
 			uint32_t nonce);
 extern void darkcoin_regenhash(struct work *work);
+extern void darkcoin_regenhash_batch(struct work *work, const uint32_t *nonces,
+			unsigned char *hashes, int count);
 
 #endif /* DARKCOIN_H */
@@ -24,6 +24,52 @@
 #include "lyra2.h"
 #include "sponge.h"
 
+/* Per-thread memory matrix, kept between calls and only reallocated when a
+ * hash of a different (nRows, nCols) shape comes along */
+static __thread uint64_t *arena_matrix;
+static __thread uint64_t **arena_rows;
+static __thread uint64_t arena_nRows, arena_nCols;
+
+/**
+ * Returns the row pointers of the calling thread's memory matrix, sized for
+ * nRows x nCols. The contents are left over from the previous call.
+ *
+ * @return The row pointers, or NULL if the matrix could not be allocated
+ */
+static uint64_t **lyra2_arena(uint64_t nRows, uint64_t nCols) {
+    const int64_t ROW_LEN_INT64 = BLOCK_LEN_INT64 * nCols;
+    uint64_t *ptrWord;
+    uint64_t i;
+
+    if (arena_rows != NULL && arena_nRows == nRows && arena_nCols == nCols)
+      return arena_rows;
+
+    free(arena_rows);
+    free(arena_matrix);
+    arena_nRows = arena_nCols = 0;
+
+    arena_matrix = (uint64_t*)malloc(nRows * ROW_LEN_INT64 * sizeof (uint64_t));
+    arena_rows = (uint64_t**)malloc(nRows * sizeof (uint64_t*));
+    if (arena_matrix == NULL || arena_rows == NULL) {
+      free(arena_rows);
+      free(arena_matrix);
+      arena_rows = NULL;
+      arena_matrix = NULL;
+      return NULL;
+    }
+
+    //Places the pointers in the correct positions
+    ptrWord = arena_matrix;
+    for (i = 0; i < nRows; i++) {
+      arena_rows[i] = ptrWord;
+      ptrWord += ROW_LEN_INT64;
+    }
+
+    arena_nRows = nRows;
+    arena_nCols = nCols;
+    return arena_rows;
+}
+
 /**
  * Executes Lyra2 based on the G function from Blake2b. This version supports salts and passwords
  * whose combined length is smaller than the size of the memory matrix, (i.e., (nRows x nCols x b) bits,
@@ -57,31 +103,18 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
     //==========================================================================/
 
     //========== Initializing the Memory Matrix and pointers to it =============//
-    //Tries to allocate enough space for the whole memory matrix
+    //The matrix is taken from the calling thread's arena, so repeated hashes of
+    //the same shape don't allocate
 
-    const int64_t ROW_LEN_INT64 = BLOCK_LEN_INT64 * nCols;
-    const int64_t ROW_LEN_BYTES = ROW_LEN_INT64 * 8;
     // for Lyra2REv2, nCols = 4, v1 was using 8
     const int64_t BLOCK_LEN = (nCols == 4) ? BLOCK_LEN_BLAKE2_SAFE_INT64 : BLOCK_LEN_BLAKE2_SAFE_BYTES;
 
-    i = (int64_t) ((int64_t) nRows * (int64_t) ROW_LEN_BYTES);
-	uint64_t *wholeMatrix = (uint64_t*)malloc(i);
-    if (wholeMatrix == NULL) {
-      return -1;
-    }
-	memset(wholeMatrix, 0, i);
-
-    //Allocates pointers to each row of the matrix
-	uint64_t **memMatrix = (uint64_t**)malloc(nRows * sizeof (uint64_t*));
+    uint64_t **memMatrix = lyra2_arena(nRows, nCols);
     if (memMatrix == NULL) {
       return -1;
     }
-    //Places the pointers in the correct positions
-    uint64_t *ptrWord = wholeMatrix;
-    for (i = 0; i < nRows; i++) {
-      memMatrix[i] = ptrWord;
-      ptrWord += ROW_LEN_INT64;
-    }
+    uint64_t *wholeMatrix = memMatrix[0];
+    uint64_t *ptrWord;
     //==========================================================================/
 
     //============= Getting the password + salt + basil padded with 10*1 ===============//
@@ -91,7 +124,9 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
     //First, we clean enough blocks for the password, salt, basil and padding
     uint64_t nBlocksInput = ((saltlen + pwdlen + 6 * sizeof (uint64_t)) / BLOCK_LEN_BLAKE2_SAFE_BYTES) + 1;
     byte *ptrByte = (byte*) wholeMatrix;
-    memset(ptrByte, 0, nBlocksInput * BLOCK_LEN_BLAKE2_SAFE_BYTES);
+    //The absorb loop below steps BLOCK_LEN words per block, which for nCols != 4
+    //reaches past the padded input, so everything it reads has to be cleared
+    memset(ptrByte, 0, ((nBlocksInput - 1) * BLOCK_LEN + BLOCK_LEN_BLAKE2_SAFE_INT64) * sizeof (uint64_t));
 
     //Prepends the password
     memcpy(ptrByte, pwd, pwdlen);
@@ -124,10 +159,7 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
 
     //======================= Initializing the Sponge State ====================//
     //Sponge state: 16 uint64_t, BLOCK_LEN_INT64 words of them for the bitrate (b) and the remainder for the capacity (c)
-	uint64_t *state = (uint64_t*)malloc(16 * sizeof (uint64_t));
-    if (state == NULL) {
-      return -1;
-    }
+    uint64_t state[16] ALIGN;
     initState(state);
     //==========================================================================/
 
@@ -201,13 +233,9 @@ int LYRA2(void *K, uint64_t kLen, const void *pwd, uint64_t pwdlen, const void *
     squeeze(state, (unsigned char*)K, kLen);
     //==========================================================================/
 
-    //========================= Freeing the memory =============================//
-    free(memMatrix);
-    free(wholeMatrix);
-
-    //Wiping out the sponge's internal state before freeing it
+    //========================= Wiping the state ===============================//
+    //The matrix stays in the arena for the next call
     memset(state, 0, 16 * sizeof (uint64_t));
-    free(state);
     //==========================================================================/
 
     return 0;
@@ -38,10 +38,8 @@
 #include "sph/sph_jh.h"
 #include "sph/sph_keccak.h" 
 
-#ifdef __APPLE_CC__
-static
-#endif
-void quarkhash(void *state, const void *input)
+/* Runs the rest of the chain once blake has absorbed the whole header */
+static void quarkhash_chain(sph_blake512_context *first, void *state)
 {
     sph_blake512_context     ctx_blake;
     sph_bmw512_context       ctx_bmw;
@@ -52,10 +50,7 @@ void quarkhash(void *state, const void *input)
     
     unsigned char hash[64];
 
-    sph_blake512_init(&ctx_blake);
-    // ZBLAKE;
-    sph_blake512 (&ctx_blake, input, 80);
-    sph_blake512_close(&ctx_blake, (void*) hash);
+    sph_blake512_close(first, (void*) hash);
     
     sph_bmw512_init(&ctx_bmw);
     // ZBMW;
@@ -130,6 +125,18 @@ void quarkhash(void *state, const void *input)
     memcpy(state, hash, 32);
 }
 
+#ifdef __APPLE_CC__
+static
+#endif
+void quarkhash(void *state, const void *input)
+{
+    sph_blake512_context ctx_blake;
+
+    sph_blake512_init(&ctx_blake);
+    sph_blake512 (&ctx_blake, input, 80);
+    quarkhash_chain(&ctx_blake, state);
+}
+
 static const uint32_t diff1targ = 0x0000ffff;
 
 
@@ -166,6 +173,24 @@ void quarkcoin_regenhash(struct work *work)
         quarkhash(ohash, data);
 }
 
+void quarkcoin_regenhash_batch(struct work *work, const uint32_t *nonces, unsigned char *hashes, int count)
+{
+        sph_blake512_context prefix, ctx;
+        uint32_t data[19], nonce_be;
+        int i;
+
+        be32enc_vect(data, (const uint32_t *)work->data, 19);
+        sph_blake512_init(&prefix);
+        sph_blake512 (&prefix, data, 76);
+
+        for (i = 0; i < count; i++) {
+                memcpy(&ctx, &prefix, sizeof(prefix));
+                nonce_be = htobe32(htole32(nonces[i]));
+                sph_blake512 (&ctx, &nonce_be, 4);
+                quarkhash_chain(&ctx, hashes + i * 32);
+        }
+}
+
 bool scanhash_quarkcoin(struct thr_info *thr, const unsigned char __maybe_unused *pmidstate,
 		     unsigned char *pdata, unsigned char __maybe_unused *phash1,
 		     unsigned char __maybe_unused *phash, const unsigned char *ptarget,
@@ -51,24 +51,153 @@ void initState(uint64_t state[/*16*/]) {
     state[15] = blake2b_IV[7];
 }
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+/* Blake2b rounds with each row of the state in one 256-bit register */
+#define G_AVX2(a, b, c, d) \
+  do { \
+    a = _mm256_add_epi64(a, b); \
+    d = _mm256_shuffle_epi32(_mm256_xor_si256(d, a), _MM_SHUFFLE(2,3,0,1)); \
+    c = _mm256_add_epi64(c, d); \
+    b = _mm256_shuffle_epi8(_mm256_xor_si256(b, c), r24); \
+    a = _mm256_add_epi64(a, b); \
+    d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), r16); \
+    c = _mm256_add_epi64(c, d); \
+    b = _mm256_xor_si256(b, c); \
+    b = _mm256_xor_si256(_mm256_srli_epi64(b, 63), _mm256_add_epi64(b, b)); \
+  } while(0)
+
+#define LOAD_ROTATIONS_AVX2 \
+    const __m256i r16 = _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, \
+                                         2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9); \
+    const __m256i r24 = _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, \
+                                         3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10)
+
+//Diagonal step: lane i works on v[i], v[4+(i+1)%4], v[8+(i+2)%4], v[12+(i+3)%4]
+#define ROUND_LYRA_AVX2(a, b, c, d) \
+  do { \
+    G_AVX2(a, b, c, d); \
+    b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(0,3,2,1)); \
+    c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1,0,3,2)); \
+    d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(2,1,0,3)); \
+    G_AVX2(a, b, c, d); \
+    b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2,1,0,3)); \
+    c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1,0,3,2)); \
+    d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(0,3,2,1)); \
+  } while(0)
+
+static inline void blake2bLyraRounds(uint64_t *v, int rounds) {
+    LOAD_ROTATIONS_AVX2;
+    __m256i a = _mm256_loadu_si256((__m256i *)&v[0]);
+    __m256i b = _mm256_loadu_si256((__m256i *)&v[4]);
+    __m256i c = _mm256_loadu_si256((__m256i *)&v[8]);
+    __m256i d = _mm256_loadu_si256((__m256i *)&v[12]);
+    int r;
+
+    for (r = 0; r < rounds; r++)
+	ROUND_LYRA_AVX2(a, b, c, d);
+
+    _mm256_storeu_si256((__m256i *)&v[0], a);
+    _mm256_storeu_si256((__m256i *)&v[4], b);
+    _mm256_storeu_si256((__m256i *)&v[8], c);
+    _mm256_storeu_si256((__m256i *)&v[12], d);
+}
+
+/* rotW(rand) as used by the duplexing: (s11, s0, s1, ..., s10) */
+#define ROTW_AVX2(a, b, c, ra, rb, rc) \
+  do { \
+    __m256i ta = _mm256_permute4x64_epi64(a, _MM_SHUFFLE(2,1,0,3)); \
+    __m256i tb = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2,1,0,3)); \
+    __m256i tc = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(2,1,0,3)); \
+    ra = _mm256_blend_epi32(ta, tc, 0x03); \
+    rb = _mm256_blend_epi32(tb, ta, 0x03); \
+    rc = _mm256_blend_epi32(tc, tb, 0x03); \
+  } while(0)
+
+#define LOAD_BLOCK_AVX2(p, x, y, z) \
+  do { \
+    x = _mm256_loadu_si256((__m256i *)&(p)[0]); \
+    y = _mm256_loadu_si256((__m256i *)&(p)[4]); \
+    z = _mm256_loadu_si256((__m256i *)&(p)[8]); \
+  } while(0)
+
+#define STORE_BLOCK_AVX2(p, x, y, z) \
+  do { \
+    _mm256_storeu_si256((__m256i *)&(p)[0], x); \
+    _mm256_storeu_si256((__m256i *)&(p)[4], y); \
+    _mm256_storeu_si256((__m256i *)&(p)[8], z); \
+  } while(0)
+
+/* The duplexing row operations with the sponge state kept in registers across
+ * all the columns. "setup" selects reducedDuplexRowSetup, which writes
+ * M[prev] XOR rand to the output row walking backwards, over the plain
+ * reducedDuplexRow, which XORs rand into it. The output row is written before
+ * the row* one, as rowOut and rowInOut may be the same row. */
+static inline void reducedDuplexRowAVX2(uint64_t *state, const uint64_t *ptrWordIn, uint64_t *ptrWordInOut,
+                                        uint64_t *ptrWordOut, int64_t outStep, uint64_t nCols, int setup) {
+    LOAD_ROTATIONS_AVX2;
+    __m256i a = _mm256_loadu_si256((__m256i *)&state[0]);
+    __m256i b = _mm256_loadu_si256((__m256i *)&state[4]);
+    __m256i c = _mm256_loadu_si256((__m256i *)&state[8]);
+    __m256i d = _mm256_loadu_si256((__m256i *)&state[12]);
+    __m256i i0, i1, i2, x0, x1, x2, o0, o1, o2;
+    uint64_t i;
+
+    for (i = 0; i < nCols; i++) {
+	//Absorbing "M[prev] [+] M[row*]"
+	LOAD_BLOCK_AVX2(ptrWordIn, i0, i1, i2);
+	LOAD_BLOCK_AVX2(ptrWordInOut, x0, x1, x2);
+	a = _mm256_xor_si256(a, _mm256_add_epi64(i0, x0));
+	b = _mm256_xor_si256(b, _mm256_add_epi64(i1, x1));
+	c = _mm256_xor_si256(c, _mm256_add_epi64(i2, x2));
+
+	ROUND_LYRA_AVX2(a, b, c, d);
+
+	if (setup) {
+	    //M[row][col] = M[prev][col] XOR rand
+	    STORE_BLOCK_AVX2(ptrWordOut, _mm256_xor_si256(i0, a), _mm256_xor_si256(i1, b), _mm256_xor_si256(i2, c));
+	} else {
+	    //M[rowOut][col] = M[rowOut][col] XOR rand
+	    LOAD_BLOCK_AVX2(ptrWordOut, o0, o1, o2);
+	    STORE_BLOCK_AVX2(ptrWordOut, _mm256_xor_si256(o0, a), _mm256_xor_si256(o1, b), _mm256_xor_si256(o2, c));
+	}
+
+	//M[rowInOut][col] = M[rowInOut][col] XOR rotW(rand)
+	ROTW_AVX2(a, b, c, o0, o1, o2);
+	LOAD_BLOCK_AVX2(ptrWordInOut, x0, x1, x2);
+	STORE_BLOCK_AVX2(ptrWordInOut, _mm256_xor_si256(x0, o0), _mm256_xor_si256(x1, o1), _mm256_xor_si256(x2, o2));
+
+	ptrWordIn += BLOCK_LEN_INT64;
+	ptrWordInOut += BLOCK_LEN_INT64;
+	ptrWordOut += outStep;
+    }
+
+    _mm256_storeu_si256((__m256i *)&state[0], a);
+    _mm256_storeu_si256((__m256i *)&state[4], b);
+    _mm256_storeu_si256((__m256i *)&state[8], c);
+    _mm256_storeu_si256((__m256i *)&state[12], d);
+}
+
+#else
+
+static inline void blake2bLyraRounds(uint64_t *v, int rounds) {
+    int r;
+
+    for (r = 0; r < rounds; r++) {
+	ROUND_LYRA(r);
+    }
+}
+
+#endif
+
 /**
  * Execute Blake2b's G function, with all 12 rounds.
  * 
  * @param v     A 1024-bit (16 uint64_t) array to be processed by Blake2b's G function
  */
 static void blake2bLyra(uint64_t *v) {
-    ROUND_LYRA(0);
-    ROUND_LYRA(1);
-    ROUND_LYRA(2);
-    ROUND_LYRA(3);
-    ROUND_LYRA(4);
-    ROUND_LYRA(5);
-    ROUND_LYRA(6);
-    ROUND_LYRA(7);
-    ROUND_LYRA(8);
-    ROUND_LYRA(9);
-    ROUND_LYRA(10);
-    ROUND_LYRA(11);
+    blake2bLyraRounds(v, 12);
 }
 
 /**
@@ -76,7 +205,7 @@ static void blake2bLyra(uint64_t *v) {
  * @param v     A 1024-bit (16 uint64_t) array to be processed by Blake2b's G function
  */
 static void reducedBlake2bLyra(uint64_t *v) {
-    ROUND_LYRA(0);
+    blake2bLyraRounds(v, 1);
 }
 
 /**
@@ -254,6 +383,9 @@ void reducedDuplexRow1(uint64_t *state, uint64_t *rowIn, uint64_t *rowOut, uint6
  *
  */
 void reducedDuplexRowSetup(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+#if defined(__AVX2__)
+    reducedDuplexRowAVX2(state, rowIn, rowInOut, rowOut + (nCols-1)*BLOCK_LEN_INT64, -BLOCK_LEN_INT64, nCols, 1);
+#else
     uint64_t* ptrWordIn = rowIn;				//In Lyra2: pointer to prev
     uint64_t* ptrWordInOut = rowInOut;				//In Lyra2: pointer to row*
     uint64_t* ptrWordOut = rowOut + (nCols-1)*BLOCK_LEN_INT64; //In Lyra2: pointer to row
@@ -311,6 +443,7 @@ void reducedDuplexRowSetup(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut,
 	//Output: goes to previous column
 	ptrWordOut -= BLOCK_LEN_INT64;
     }
+#endif
 }
 
 /**
@@ -328,6 +461,9 @@ void reducedDuplexRowSetup(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut,
  *
  */
 void reducedDuplexRow(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+#if defined(__AVX2__)
+    reducedDuplexRowAVX2(state, rowIn, rowInOut, rowOut, BLOCK_LEN_INT64, nCols, 0);
+#else
     uint64_t* ptrWordInOut = rowInOut; //In Lyra2: pointer to row*
     uint64_t* ptrWordIn = rowIn; //In Lyra2: pointer to prev
     uint64_t* ptrWordOut = rowOut; //In Lyra2: pointer to row
@@ -385,6 +521,7 @@ void reducedDuplexRow(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint
 	ptrWordInOut += BLOCK_LEN_INT64;
 	ptrWordIn += BLOCK_LEN_INT64;
     }
+#endif
 }
 
 
@@ -47,15 +47,20 @@ typedef struct
   sph_skein512_context    skein1;
 } Xhash_context_holder;
 
-static Xhash_context_holder base_contexts;
+static __thread Xhash_context_holder base_contexts;
+static __thread bool base_contexts_ready;
 
 void init_Nhash_contexts()
 {
+  if (likely(base_contexts_ready))
+    return;
+
   sph_blake512_init(&base_contexts.blake1);
   sph_groestl512_init(&base_contexts.groestl1);
   sph_jh512_init(&base_contexts.jh1);
   sph_keccak512_init(&base_contexts.keccak1);
   sph_skein512_init(&base_contexts.skein1);
+  base_contexts_ready = true;
 }
 
 #ifdef __APPLE_CC__
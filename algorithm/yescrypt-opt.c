@@ -37,12 +37,18 @@
 #include <errno.h>
 #include <stdint.h>
 #include <stdlib.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 #include "algorithm/yescrypt_core.h"
 #include "sph/sha256_Y.h"
 #include "algorithm/sysendian.h"
 
 // #include "sph/yescrypt-platform.c"
-#define HUGEPAGE_THRESHOLD		(12 * 1024 * 1024)
+/* The miner keeps one region per thread for its whole lifetime (see
+ * yescrypt_bsty), so it is worth backing with huge pages even at the 2 MiB
+ * that N = 2048, r = 8 needs */
+#define HUGEPAGE_THRESHOLD		(2 * 1024 * 1024)
 
 #ifdef __x86_64__
 #define HUGEPAGE_SIZE			(2 * 1024 * 1024)
@@ -80,8 +86,13 @@ alloc_region(yescrypt_region_t * region, size_t size)
 	}
 	else
 		if (flags & MAP_HUGETLB) {
+		/* No huge pages reserved, ask for transparent ones instead */
 		flags &= ~MAP_HUGETLB;
 		base = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+#ifdef MADV_HUGEPAGE
+		if (base != MAP_FAILED)
+			madvise(base, size, MADV_HUGEPAGE);
+#endif
 		}
 
 #else
@@ -320,41 +320,61 @@ yescrypt_gensalt(uint32_t N_log2, uint32_t r, uint32_t p,
 	    buf, sizeof(buf));
 }
 
+/* Per-thread yescrypt memory, reused by every hash the thread verifies. The
+ * local region is only rebuilt when a hash with different parameters comes
+ * along, so it stays sized for the parameters in use. */
+struct yescrypt_regions {
+	int initialized;
+	uint64_t N;
+	uint32_t r, p;
+	yescrypt_flags_t flags;
+	yescrypt_shared_t shared;
+	yescrypt_local_t local;
+};
+
+static __thread struct yescrypt_regions regions;
+
 static int
 yescrypt_bsty(const uint8_t * passwd, size_t passwdlen,
     const uint8_t * salt, size_t saltlen, uint64_t N, uint32_t r, uint32_t p,
-    uint8_t * buf, size_t buflen)
+    yescrypt_flags_t flags, uint8_t * buf, size_t buflen)
 {
-	static __thread int initialized = 0;
-	static __thread yescrypt_shared_t shared;
-	static __thread yescrypt_local_t local;
-
-//		static __declspec(thread) int initialized = 0;
-//		static __declspec(thread) yescrypt_shared_t shared;
-//		static  __declspec(thread) yescrypt_local_t local;
-
-	int retval;
-	if (!initialized) {
+	if (!regions.initialized) {
 /* "shared" could in fact be shared, but it's simpler to keep it private
  * along with "local".  It's dummy and tiny anyway. */
-		if (yescrypt_init_shared(&shared, NULL, 0,
+		if (yescrypt_init_shared(&regions.shared, NULL, 0,
 		    0, 0, 0, YESCRYPT_SHARED_DEFAULTS, 0, NULL, 0))
 			return -1;
-		if (yescrypt_init_local(&local)) {
-			yescrypt_free_shared(&shared);
+		if (yescrypt_init_local(&regions.local)) {
+			yescrypt_free_shared(&regions.shared);
 			return -1;
 		}
-		initialized = 1;
- 	}
-	retval = yescrypt_kdf(&shared, &local,
-	    passwd, passwdlen, salt, saltlen, N, r, p, 0, YESCRYPT_FLAGS,
-	    buf, buflen);		
-
-	return retval;
+		regions.initialized = 1;
+	}
+	else if (regions.N != N || regions.r != r || regions.p != p ||
+	    regions.flags != flags) {
+		/* Start over from scratch next time if the region is lost */
+		if (yescrypt_free_local(&regions.local) ||
+		    yescrypt_init_local(&regions.local)) {
+			yescrypt_free_shared(&regions.shared);
+			regions.initialized = 0;
+			return -1;
+		}
+	}
+	regions.N = N;
+	regions.r = r;
+	regions.p = p;
+	regions.flags = flags;
+
+	return yescrypt_kdf(&regions.shared, &regions.local,
+	    passwd, passwdlen, salt, saltlen, N, r, p, 0, flags,
+	    buf, buflen);
 }
 
 void yescrypt_hash(const unsigned char *input, unsigned char *output)
 {
-
-   yescrypt_bsty((const uint8_t *)input, 80, (const uint8_t *) input, 80, 2048, 8, 1, (uint8_t *)output, 32);
+   /* A hash that meets no target, so the nonce is never taken as valid */
+   if (yescrypt_bsty((const uint8_t *)input, 80, (const uint8_t *) input, 80, 2048, 8, 1, YESCRYPT_FLAGS, (uint8_t *)output, 32)) {
+      memset(output, 0xff, 32);
+   }
 }
@@ -32,6 +32,7 @@
 #include "util.h"
 #include "pool.h"
 #include "algorithm.h"
+#include "findnonce.h"
 
 #include "config_parser.h"
 
@@ -1495,6 +1496,68 @@ static void gpustatus(struct io_data *io_data, int gpu, bool isjson, bool precom
   }
 }
 
+/* The devs entry of a device that is not a GPU, with the fields that make
+ * sense without ADL */
+static void drvstatus(struct io_data *io_data, struct cgpu_info *cgpu, bool isjson, bool precom)
+{
+  struct api_data *root = NULL;
+  char buf[TMPBUFSIZ];
+  char *enabled;
+  char *status;
+  double dev_runtime;
+
+  dev_runtime = cgpu_runtime(cgpu);
+  cgpu->utility = cgpu->accepted / dev_runtime * 60;
+
+  if (cgpu->deven != DEV_DISABLED)
+    enabled = (char *)YES;
+  else
+    enabled = (char *)NO;
+
+  status = (char *)status2str(cgpu->status);
+
+  root = api_add_int(root, cgpu->drv->name, &(cgpu->device_id), false);
+  root = api_add_string(root, "Enabled", enabled, false);
+  root = api_add_string(root, "Status", status, false);
+  root = api_add_temp(root, "Temperature", &(cgpu->temp), false);
+  root = api_add_int(root, "Threads", &(cgpu->threads), false);
+  double mhs = cgpu->total_mhashes / total_secs;
+  root = api_add_mhs(root, "MHS av", &mhs, false);
+  char mhsname[27];
+  sprintf(mhsname, "MHS %ds", opt_log_interval);
+  root = api_add_mhs(root, mhsname, &(cgpu->rolling), false);
+  double khs_avg = mhs * 1000.0;
+  double khs_rolling = cgpu->rolling * 1000.0;
+  root = api_add_khs(root, "KHS av", &khs_avg, false);
+  char khsname[27];
+  sprintf(khsname, "KHS %ds", opt_log_interval);
+  root = api_add_khs(root, khsname, &khs_rolling, false);
+  root = api_add_int(root, "Accepted", &(cgpu->accepted), false);
+  root = api_add_int(root, "Rejected", &(cgpu->rejected), false);
+  root = api_add_int(root, "Hardware Errors", &(cgpu->hw_errors), false);
+  root = api_add_utility(root, "Utility", &(cgpu->utility), false);
+  int last_share_pool = cgpu->last_share_pool_time > 0 ?
+        cgpu->last_share_pool : -1;
+  root = api_add_int(root, "Last Share Pool", &last_share_pool, false);
+  root = api_add_time(root, "Last Share Time", &(cgpu->last_share_pool_time), false);
+  root = api_add_mhtotal(root, "Total MH", &(cgpu->total_mhashes), false);
+  root = api_add_double(root, "Diff1 Work", &(cgpu->diff1), false);
+  root = api_add_diff(root, "Difficulty Accepted", &(cgpu->diff_accepted), false);
+  root = api_add_diff(root, "Difficulty Rejected", &(cgpu->diff_rejected), false);
+  root = api_add_diff(root, "Last Share Difficulty", &(cgpu->last_share_diff), false);
+  root = api_add_time(root, "Last Valid Work", &(cgpu->last_device_valid_work), false);
+  double hwp = (cgpu->hw_errors + cgpu->diff1) ?
+      (double)(cgpu->hw_errors) / (double)(cgpu->hw_errors + cgpu->diff1) : 0;
+  root = api_add_percent(root, "Device Hardware%", &hwp, false);
+  double rejp = cgpu->diff1 ?
+      (double)(cgpu->diff_rejected) / (double)(cgpu->diff1) : 0;
+  root = api_add_percent(root, "Device Rejected%", &rejp, false);
+  root = api_add_elapsed(root, "Device Elapsed", &(total_secs), true);
+
+  root = print_data(root, buf, isjson, precom);
+  io_add(io_data, buf);
+}
+
 static void devstatus(struct io_data *io_data, __maybe_unused SOCKETTYPE c, __maybe_unused char *param, bool isjson, __maybe_unused char group)
 {
   bool io_open = false;
@@ -1503,7 +1566,7 @@ static void devstatus(struct io_data *io_data, __maybe_unused SOCKETTYPE c, __ma
   int i;
   numgpu = nDevs;
 
-  if (numgpu == 0) {
+  if (numgpu == 0 && total_devices == 0) {
     message(io_data, MSG_NODEVS, 0, NULL, isjson);
     return;
   }
@@ -1518,6 +1581,15 @@ static void devstatus(struct io_data *io_data, __maybe_unused SOCKETTYPE c, __ma
 
     devcount++;
   }
+  for (i = 0; i < total_devices; i++) {
+    struct cgpu_info *cgpu = get_devices(i);
+
+    if (cgpu->drv->drv_id == DRIVER_opencl)
+      continue;
+    drvstatus(io_data, cgpu, isjson, isjson && devcount > 0);
+
+    devcount++;
+  }
   if (isjson && io_open)
     io_close(io_data);
 }
@@ -2623,7 +2695,7 @@ static void devdetails(struct io_data *io_data, __maybe_unused SOCKETTYPE c, __m
     root = api_add_string(root, "Name", cgpu->drv->name, false);
     root = api_add_int(root, "ID", &(cgpu->device_id), false);
     root = api_add_string(root, "Driver", cgpu->drv->dname, false);
-    root = api_add_const(root, "Kernel", cgpu->algorithm.name, false);
+    root = api_add_const(root, "Kernel", get_algorithm_kernel(&cgpu->algorithm), false);
     root = api_add_const(root, "Model", cgpu->name ? cgpu->name : BLANK, false);
     root = api_add_const(root, "Device Path", cgpu->device_path ? cgpu->device_path : BLANK, false);
 
@@ -2713,6 +2785,88 @@ static int itemstats(struct io_data *io_data, int i, char *id, struct sgminer_st
   return ++i;
 }
 
+static int verifystats(struct io_data *io_data, int i, bool isjson)
+{
+  struct api_data *root = NULL;
+  struct verify_stats stats;
+  char buf[TMPBUFSIZ];
+  double avg;
+
+  get_verify_stats(&stats);
+  avg = stats.jobs ? stats.latency_total / stats.jobs : 0;
+
+  root = api_add_int(root, "STATS", &i, false);
+  root = api_add_const(root, "ID", "VERIFY", false);
+  root = api_add_elapsed(root, "Elapsed", &(total_secs), false);
+  root = api_add_int(root, "Verify Threads", &opt_verify_threads, false);
+  root = api_add_uint(root, "Queue Depth", &(stats.depth), true);
+  root = api_add_uint(root, "Queue Depth Max", &(stats.depth_max), true);
+  root = api_add_uint64(root, "Jobs", &(stats.jobs), true);
+  root = api_add_uint64(root, "Inline Jobs", &(stats.inline_jobs), true);
+  root = api_add_uint64(root, "Late Jobs", &(stats.late_jobs), true);
+  root = api_add_double(root, "Latency Av", &avg, true);
+  root = api_add_double(root, "Latency Max", &(stats.latency_max), true);
+
+  root = print_data(root, buf, isjson, isjson && (i > 0));
+  io_add(io_data, buf);
+
+  return ++i;
+}
+
+static int stagedstats(struct io_data *io_data, int i, bool isjson)
+{
+  struct api_data *root = NULL;
+  struct staged_stats stats;
+  char buf[TMPBUFSIZ];
+
+  get_staged_stats(&stats);
+
+  root = api_add_int(root, "STATS", &i, false);
+  root = api_add_const(root, "ID", "STAGED", false);
+  root = api_add_elapsed(root, "Elapsed", &(total_secs), false);
+  root = api_add_int(root, "Staged", &(stats.staged), true);
+  root = api_add_int(root, "Rollable", &(stats.rollable), true);
+  root = api_add_uint64(root, "Pushes", &(stats.pushes), true);
+  root = api_add_uint64(root, "Pops", &(stats.pops), true);
+  root = api_add_uint64(root, "Pop Waits", &(stats.pop_waits), true);
+  root = api_add_uint64(root, "Locks", &(stats.locks), true);
+  root = api_add_uint64(root, "Contended", &(stats.contended), true);
+
+  root = print_data(root, buf, isjson, isjson && (i > 0));
+  io_add(io_data, buf);
+
+  return ++i;
+}
+
+static int workslabstats(struct io_data *io_data, int i, bool isjson)
+{
+  struct api_data *root = NULL;
+  struct work_slab_stats stats;
+  char buf[TMPBUFSIZ];
+  double hit_rate;
+
+  get_work_slab_stats(&stats);
+  hit_rate = stats.allocs ? (double)stats.cache_hits / (double)stats.allocs : 0;
+
+  root = api_add_int(root, "STATS", &i, false);
+  root = api_add_const(root, "ID", "WORK", false);
+  root = api_add_elapsed(root, "Elapsed", &(total_secs), false);
+  root = api_add_int(root, "Live", &(stats.live), true);
+  root = api_add_int(root, "Peak", &(stats.peak), true);
+  root = api_add_int(root, "Depot", &(stats.depot), true);
+  root = api_add_uint64(root, "Allocated", &(stats.allocated), true);
+  root = api_add_uint64(root, "Slabs", &(stats.slabs), true);
+  root = api_add_uint64(root, "Allocs", &(stats.allocs), true);
+  root = api_add_uint64(root, "Cache Hits", &(stats.cache_hits), true);
+  root = api_add_uint64(root, "Depot Hits", &(stats.depot_hits), true);
+  root = api_add_percent(root, "Cache Hit Rate", &hit_rate, true);
+
+  root = print_data(root, buf, isjson, isjson && (i > 0));
+  io_add(io_data, buf);
+
+  return ++i;
+}
+
 static void minerstats(struct io_data *io_data, __maybe_unused SOCKETTYPE c, __maybe_unused char *param, bool isjson, __maybe_unused char group)
 {
   struct cgpu_info *cgpu;
@@ -2748,6 +2902,10 @@ static void minerstats(struct io_data *io_data, __maybe_unused SOCKETTYPE c, __m
     i = itemstats(io_data, i, id, &(pool->sgminer_stats), &(pool->sgminer_pool_stats), NULL, NULL, isjson);
   }
 
+  i = stagedstats(io_data, i, isjson);
+  i = workslabstats(io_data, i, isjson);
+  i = verifystats(io_data, i, isjson);
+
   if (isjson && io_open)
     io_close(io_data);
 }
@@ -0,0 +1,304 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.  See COPYING for more details.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#ifdef __linux
+#include <sched.h>
+#endif
+
+#include "compat.h"
+#include "miner.h"
+#include "config_parser.h"
+#include "driver-cpu.h"
+#include "api.h"
+
+/* Nonces hashed per call for algorithms with a regenhash_batch, which
+ * absorb the header prefix once for all of them */
+#define CPU_LANES 8
+
+struct cpu_thread_data {
+  bool pinned;
+  unsigned char hashes[CPU_LANES * 32];
+};
+
+int opt_cpu_threads;
+bool opt_cpu_affinity;
+
+static struct cgpu_info cpu_device;
+static int cpu_cores;
+
+int cpu_core_count(void)
+{
+#ifdef WIN32
+  SYSTEM_INFO sysinfo;
+
+  GetSystemInfo(&sysinfo);
+  return sysinfo.dwNumberOfProcessors;
+#else
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return n > 0 ? n : 1;
+#endif
+}
+
+char *set_cpu_threads(const char *arg)
+{
+  int val;
+
+  if (!strcasecmp(arg, "auto")) {
+    opt_cpu_threads = -1;
+    return NULL;
+  }
+
+  val = atoi(arg);
+  if (val < 0 || val > 9999)
+    return "Invalid value passed to set_cpu_threads";
+  opt_cpu_threads = val;
+  return NULL;
+}
+
+/* Pin the calling thread to one core. Only works from the thread itself. */
+static void pin_thread(struct thr_info *thr)
+{
+  int core = thr->device_thread % cpu_cores;
+
+#if defined(__linux)
+  cpu_set_t set;
+
+  CPU_ZERO(&set);
+  CPU_SET(core, &set);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+    applog(LOG_WARNING, "CPU thread %d: failed to set affinity to core %d", thr->id, core);
+#elif defined(WIN32)
+  if (!SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core))
+    applog(LOG_WARNING, "CPU thread %d: failed to set affinity to core %d", thr->id, core);
+#else
+  applog(LOG_DEBUG, "CPU thread %d: affinity not supported here", thr->id);
+#endif
+  applog(LOG_DEBUG, "CPU thread %d pinned to core %d", thr->id, core);
+}
+
+/* Package temperature from the thermal zones, -1 if there is none */
+static float read_cpu_temp(void)
+{
+#ifdef __linux
+  float fallback = -1;
+  int i;
+
+  for (i = 0; i < 16; i++) {
+    char filename[64], type[32] = "";
+    FILE *fp;
+    int millideg;
+
+    snprintf(filename, sizeof(filename), "/sys/class/thermal/thermal_zone%d/temp", i);
+    fp = fopen(filename, "r");
+    if (!fp)
+      break;
+    if (fscanf(fp, "%d", &millideg) != 1) {
+      fclose(fp);
+      continue;
+    }
+    fclose(fp);
+
+    snprintf(filename, sizeof(filename), "/sys/class/thermal/thermal_zone%d/type", i);
+    fp = fopen(filename, "r");
+    if (fp) {
+      if (!fgets(type, sizeof(type), fp))
+        type[0] = '\0';
+      fclose(fp);
+    }
+    if (strstr(type, "pkg") || strstr(type, "cpu"))
+      return millideg / 1000.0;
+    if (fallback < 0)
+      fallback = millideg / 1000.0;
+  }
+  return fallback;
+#else
+  return -1;
+#endif
+}
+
+static void cpu_detect(void)
+{
+  if (!opt_cpu_threads)
+    return;
+
+  cpu_cores = cpu_core_count();
+  if (opt_cpu_threads < 0)
+    opt_cpu_threads = cpu_cores;
+
+  cpu_device.drv = &cpu_drv;
+  cpu_device.deven = DEV_ENABLED;
+  cpu_device.threads = opt_cpu_threads;
+  cpu_device.algorithm = default_profile.algorithm;
+  cpu_device.temp = read_cpu_temp();
+  cpu_device.name = strdup("CPU");
+  add_cgpu(&cpu_device);
+
+  applog(LOG_INFO, "CPU %d: %d mining threads on %d cores%s", cpu_device.device_id,
+    opt_cpu_threads, cpu_cores, opt_cpu_affinity ? ", pinned" : "");
+}
+
+static bool cpu_get_stats(struct cgpu_info *cpu)
+{
+  cpu->temp = read_cpu_temp();
+  return true;
+}
+
+static void get_cpu_statline_before(char *buf, size_t bufsiz, struct cgpu_info *cpu)
+{
+  if (cpu->temp >= 0)
+    tailsprintf(buf, bufsiz, "%5.1fC         | ", cpu->temp);
+  else
+    tailsprintf(buf, bufsiz, "               | ");
+}
+
+static void get_cpu_statline(char *buf, size_t bufsiz, struct cgpu_info *cpu)
+{
+  tailsprintf(buf, bufsiz, " T:%2d", cpu->threads);
+}
+
+static struct api_data *cpu_api_stats(struct cgpu_info *cpu)
+{
+  struct api_data *root = NULL;
+  int lanes = CPU_LANES;
+
+  root = api_add_int(root, "Threads", &(cpu->threads), false);
+  root = api_add_int(root, "Cores", &cpu_cores, false);
+  root = api_add_int(root, "Lanes", &lanes, true);
+  root = api_add_bool(root, "Affinity", &opt_cpu_affinity, false);
+  root = api_add_temp(root, "Temperature", &(cpu->temp), false);
+
+  return root;
+}
+
+static bool cpu_thread_prepare(struct thr_info *thr)
+{
+  struct timeval now;
+
+  thr->cgpu_data = calloc(1, sizeof(struct cpu_thread_data));
+  if (!thr->cgpu_data) {
+    applog(LOG_ERR, "Failed to calloc in cpu_thread_prepare");
+    return false;
+  }
+
+  cgtime(&now);
+  get_datestamp(thr->cgpu->init, sizeof(thr->cgpu->init), &now);
+  return true;
+}
+
+static bool cpu_thread_init(struct thr_info *thr)
+{
+  struct cgpu_info *cpu = thr->cgpu;
+
+  cpu->status = LIFE_WELL;
+  cpu->device_last_well = time(NULL);
+  return true;
+}
+
+static bool cpu_prepare_work(struct thr_info *thr, struct work *work)
+{
+  thr->pool_no = work->pool->pool_no;
+  return true;
+}
+
+/* Start small; hash_sole_work grows the range to a few seconds per call */
+static uint64_t cpu_can_limit_work(struct thr_info __maybe_unused *thr)
+{
+  return 0xffff;
+}
+
+/* Hash the nonces from work->blk.nonce up to max_nonce, or until the work is
+ * restarted. Candidates under the device target are verified and submitted
+ * the same way as nonces found by a GPU. */
+static int64_t cpu_scanhash(struct thr_info *thr, struct work *work, int64_t max_nonce)
+{
+  struct cpu_thread_data *thrdata = (struct cpu_thread_data *)thr->cgpu_data;
+  algorithm_t *algorithm = &work->pool->algorithm;
+  const uint32_t target = le32toh(((uint32_t *)work->device_target)[7]);
+  const uint32_t first = work->blk.nonce;
+  uint32_t end = (max_nonce > 0xffffffffLL) ? 0xffffffff : (uint32_t)max_nonce;
+  uint32_t nonce = first;
+
+  if (unlikely(opt_cpu_affinity && !thrdata->pinned)) {
+    pin_thread(thr);
+    thrdata->pinned = true;
+  }
+
+  while (nonce < end && !thr->work_restart) {
+    uint32_t nonces[CPU_LANES];
+    int i, n = MIN(CPU_LANES, end - nonce);
+
+    for (i = 0; i < n; i++)
+      nonces[i] = nonce + i;
+
+    if (algorithm->regenhash_batch) {
+      algorithm->regenhash_batch(work, nonces, thrdata->hashes, n);
+      for (i = 0; i < n; i++) {
+        if (le32toh(*(uint32_t *)(thrdata->hashes + i * 32 + 28)) <= target)
+          submit_nonce(thr, work, nonces[i]);
+      }
+    }
+    else {
+      for (i = 0; i < n; i++) {
+        if (test_nonce(work, nonces[i]) && le32toh(*(uint32_t *)(work->hash + 28)) <= target)
+          submit_tested_work(thr, work);
+      }
+    }
+    nonce += n;
+  }
+
+  work->blk.nonce = nonce;
+  return nonce - first;
+}
+
+static void cpu_thread_shutdown(struct thr_info *thr)
+{
+  free(thr->cgpu_data);
+  thr->cgpu_data = NULL;
+}
+
+struct device_drv cpu_drv = {
+  /*.drv_id = */      DRIVER_cpu,
+  /*.dname = */     "cpu",
+  /*.name = */      "CPU",
+  /*.drv_detect = */    cpu_detect,
+  /*.reinit_device = */   NULL,
+  /*.get_statline_before = */ get_cpu_statline_before,
+  /*.get_statline = */    get_cpu_statline,
+  /*.api_data = */    cpu_api_stats,
+  /*.get_stats = */   cpu_get_stats,
+  /*.identify_device = */ NULL,
+  /*.set_device = */    NULL,
+
+  /*.thread_prepare = */  cpu_thread_prepare,
+  /*.can_limit_work = */  cpu_can_limit_work,
+  /*.thread_init = */   cpu_thread_init,
+  /*.prepare_work = */    cpu_prepare_work,
+  /*.hash_work = */   NULL,
+  /*.scanhash = */    cpu_scanhash,
+  /*.scanwork = */    NULL,
+  /*.queue_full = */    NULL,
+  /*.flush_work = */    NULL,
+  /*.update_work = */   NULL,
+  /*.hw_error = */      NULL,
+  /*.thread_shutdown = */ cpu_thread_shutdown,
+  /*.thread_enable =*/    NULL,
+  /*.zero_stats = */    NULL,
+  /*.copy = */      false,
+  /*.max_diff = */    65536,
+  /*.working_diff = */  1,
+};
@@ -0,0 +1,14 @@
+#ifndef DEVICE_CPU_H
+#define DEVICE_CPU_H
+
+#include "miner.h"
+
+extern char *set_cpu_threads(const char *arg);
+extern int cpu_core_count(void);
+
+extern int opt_cpu_threads;
+extern bool opt_cpu_affinity;
+
+extern struct device_drv cpu_drv;
+
+#endif /* DEVICE_CPU_H */
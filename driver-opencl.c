@@ -32,6 +32,9 @@
 #include "driver-opencl.h"
 #include "findnonce.h"
 #include "ocl.h"
+#include "ocl/autotune.h"
+#include "ocl/kernel_select.h"
+#include "bench_block.h"
 #include "adl.h"
 #include "util.h"
 
@@ -91,6 +94,30 @@ char *set_vector(char *arg)
   return NULL;
 }
 
+char *set_device_type(char *arg)
+{
+  cl_device_type type = 0;
+  char *nextptr;
+
+  for (nextptr = strtok(arg, ","); nextptr; nextptr = strtok(NULL, ",")) {
+    if (!strcasecmp(nextptr, "gpu"))
+      type |= CL_DEVICE_TYPE_GPU;
+    else if (!strcasecmp(nextptr, "cpu"))
+      type |= CL_DEVICE_TYPE_CPU;
+    else if (!strcasecmp(nextptr, "accelerator"))
+      type |= CL_DEVICE_TYPE_ACCELERATOR;
+    else if (!strcasecmp(nextptr, "all"))
+      type |= CL_DEVICE_TYPE_GPU | CL_DEVICE_TYPE_CPU | CL_DEVICE_TYPE_ACCELERATOR;
+    else
+      return "Invalid device type: use gpu, cpu, accelerator or all";
+  }
+  if (!type)
+    return "Invalid parameters for set device type";
+
+  opt_device_type = type;
+  return NULL;
+}
+
 char *set_worksize(const char *arg)
 {
   int i, val = 0, device = 0;
@@ -1033,9 +1060,9 @@ void manage_gpu(void)
 
 static _clState *clStates[MAX_GPUDEVICES];
 
-static void set_threads_hashes(unsigned int vectors, unsigned int compute_shaders, int64_t *hashes, size_t *globalThreads,
-  unsigned int minthreads, __maybe_unused int *intensity, __maybe_unused int *xintensity,
-  __maybe_unused int *rawintensity, algorithm_t *algorithm)
+static void set_threads_hashes(unsigned int vectors, unsigned int compute_shaders, unsigned int intensity_rshift,
+  int64_t *hashes, size_t *globalThreads, unsigned int minthreads, __maybe_unused int *intensity,
+  __maybe_unused int *xintensity, __maybe_unused int *rawintensity, algorithm_t *algorithm)
 {
   unsigned int threads = 0;
   while (threads < minthreads) {
@@ -1047,7 +1074,7 @@ static void set_threads_hashes(unsigned int vectors, unsigned int compute_shader
       threads = compute_shaders * ((algorithm->xintensity_shift) ? (1 << (algorithm->xintensity_shift + *xintensity)) : *xintensity);
     }
     else {
-      threads = 1 << (algorithm->intensity_shift + *intensity);
+      threads = (1U << (algorithm->intensity_shift + *intensity)) >> intensity_rshift;
     }
 
     if (threads < minthreads) {
@@ -1138,6 +1165,9 @@ select_cgpu:
     //free(clState);
 
     applog(LOG_INFO, "Reinit GPU thread %d", thr_id);
+    /* Don't hand the wedged device's old context back to it */
+    if (thr == cgpu->thr[0])
+      clear_device_share(virtual_gpu);
     clStates[thr_id] = initCl(virtual_gpu, name, sizeof(name), &cgpu->algorithm);
     if (!clStates[thr_id]) {
       applog(LOG_ERR, "Failed to reinit GPU thread %d", thr_id);
@@ -1176,7 +1206,7 @@ out:
 
 static void opencl_detect(void)
 {
-  int i;
+  int i, gpu_devs;
 
   nDevs = clDevicesNum();
   if (nDevs < 0) {
@@ -1212,8 +1242,10 @@ static void opencl_detect(void)
     add_cgpu(cgpu);
   }
 
-  if (!opt_noadl)
-    init_adl(nDevs);
+  /* Only the GPUs, which are numbered first, can have an ADL adapter */
+  gpu_devs = clGPUsNum();
+  if (!opt_noadl && gpu_devs)
+    init_adl(gpu_devs);
 }
 
 static void reinit_opencl_device(struct cgpu_info *gpu)
@@ -1258,12 +1290,167 @@ static void get_opencl_statline(char *buf, size_t bufsiz, struct cgpu_info *gpu)
     tailsprintf(buf, bufsiz, " I:%2d", gpu->intensity);
 }
 
+/* One kernel pass in flight when pipelining */
+struct opencl_pass {
+  cl_mem buffer;
+  uint32_t *res;
+  cl_event event;         /* Completion of the result read */
+  struct work *work;      /* Copy of the work the pass was queued with */
+  struct timeval tv_done;
+  int done;               /* Set by the event callback */
+};
+
 struct opencl_thread_data {
   cl_int(*queue_kernel_parameters)(_clState *, dev_blk_ctx *, cl_uint);
   uint32_t *res;
+  struct opencl_pass pass[2];
+  int cur;
+  struct timeval tv_done; /* When the last unpipelined pass finished */
 };
 
-static uint32_t *blank_res;
+bool opt_gpu_pipeline;
+
+static pthread_mutex_t idle_gap_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Account the time the device sat idle between one pass finishing and the
+ * next being queued, in ms. A NULL tv_done means it was still busy. */
+static void add_idle_gap(struct cgpu_info *gpu, struct timeval *tv_done)
+{
+  struct timeval now;
+  double gap = 0;
+
+  if (tv_done) {
+    cgtime(&now);
+    gap = tdiff(&now, tv_done) * 1000.0;
+    if (gap < 0)
+      gap = 0;
+  }
+
+  mutex_lock(&idle_gap_lock);
+  gpu->gpu_passes++;
+  gpu->gpu_idle_total += gap;
+  if (gap > gpu->gpu_idle_max)
+    gpu->gpu_idle_max = gap;
+  mutex_unlock(&idle_gap_lock);
+}
+
+static void CL_CALLBACK pass_done(cl_event __maybe_unused event, cl_int __maybe_unused status, void *data)
+{
+  struct opencl_pass *pass = (struct opencl_pass *)data;
+
+  cgtime(&pass->tv_done);
+  __atomic_store_n(&pass->done, 1, __ATOMIC_RELEASE);
+}
+
+static struct api_data *opencl_api_stats(struct cgpu_info *gpu)
+{
+  struct api_data *root = NULL;
+  double avg;
+
+  mutex_lock(&idle_gap_lock);
+  avg = gpu->gpu_passes ? gpu->gpu_idle_total / gpu->gpu_passes : 0;
+  root = api_add_bool(root, "Pipelined", &opt_gpu_pipeline, false);
+  root = api_add_uint64(root, "Passes", &(gpu->gpu_passes), true);
+  root = api_add_double(root, "Idle Gap Total", &(gpu->gpu_idle_total), true);
+  root = api_add_double(root, "Idle Gap Avg", &avg, true);
+  root = api_add_double(root, "Idle Gap Max", &(gpu->gpu_idle_max), true);
+  mutex_unlock(&idle_gap_lock);
+  root = api_add_bool(root, "Mapped Results", &opt_gpu_mapped, false);
+  root = api_add_uint64(root, "Result Overflows", &(gpu->gpu_result_overflows), true);
+
+  return root;
+}
+
+/* An out of order queue runs a command as soon as the events it waits on
+ * are done. The passes of a thread share the header, hash and output
+ * buffers, so there every command waits on the one queued before it. These
+ * give the wait list and the event for the next command, and make that
+ * event the one to wait on. In order queues need none of it. */
+static cl_uint chain_wait(_clState *clState, const cl_event **wait)
+{
+  *wait = clState->tail_event ? &clState->tail_event : NULL;
+  return clState->tail_event ? 1 : 0;
+}
+
+static cl_event *chain_event(_clState *clState, cl_event *event)
+{
+  return clState->out_of_order ? event : NULL;
+}
+
+static void chain_to(_clState *clState, cl_event event)
+{
+  if (!clState->out_of_order)
+    return;
+  if (clState->tail_event)
+    clReleaseEvent(clState->tail_event);
+  clState->tail_event = event;
+}
+
+static const uint32_t blank_res[1];
+
+/* Zero the found counter of an output buffer. The entries behind it need no
+ * clearing as the counter says how many of them are valid. */
+static cl_int reset_found(_clState *clState, cl_mem buffer, int found)
+{
+  const cl_event *wait;
+  cl_uint num_wait = chain_wait(clState, &wait);
+  cl_event event = NULL;
+  cl_int status;
+
+#ifdef CL_VERSION_1_2
+  if (clState->opencl_version >= 1.2) {
+    const cl_uint zero = 0;
+
+    status = clEnqueueFillBuffer(clState->commandQueue, buffer, &zero, sizeof(zero),
+      found * sizeof(uint32_t), sizeof(uint32_t), num_wait, wait, chain_event(clState, &event));
+  }
+  else
+#endif
+  status = clEnqueueWriteBuffer(clState->commandQueue, buffer, CL_FALSE,
+    found * sizeof(uint32_t), sizeof(uint32_t), blank_res, num_wait, wait, chain_event(clState, &event));
+  if (likely(status == CL_SUCCESS))
+    chain_to(clState, event);
+  return status;
+}
+
+/* Only the counter word is read back after each pass. When it is non-zero
+ * fetch the entries it covers into res and clear the counter. */
+static cl_int fetch_results(struct thr_info *thr, cl_mem buffer, uint32_t *res)
+{
+  _clState *clState = clStates[thr->id];
+  int found = thr->cgpu->algorithm.found_idx;
+  size_t size = MIN(res[found], (uint32_t)found) * sizeof(uint32_t);
+  cl_int status;
+
+  if (opt_gpu_mapped) {
+    uint32_t *map;
+
+    map = (uint32_t *)clEnqueueMapBuffer(clState->commandQueue, buffer, CL_TRUE, CL_MAP_READ,
+      0, size, 0, NULL, NULL, &status);
+    if (unlikely(status != CL_SUCCESS)) {
+      applog(LOG_ERR, "Error %d: clEnqueueMapBuffer failed.", status);
+      return status;
+    }
+    memcpy(res, map, size);
+    status = clEnqueueUnmapMemObject(clState->commandQueue, buffer, map, 0, NULL, NULL);
+  }
+  else
+    status = clEnqueueReadBuffer(clState->commandQueue, buffer, CL_TRUE, 0,
+      size, res, 0, NULL, NULL);
+  if (unlikely(status != CL_SUCCESS)) {
+    applog(LOG_ERR, "Error %d: Reading back results failed.", status);
+    return status;
+  }
+
+  status = reset_found(clState, buffer, found);
+  if (unlikely(status != CL_SUCCESS))
+    applog(LOG_ERR, "Error %d: Clearing the result counter failed.", status);
+
+  return status;
+}
+
+static bool lookup_kernel(struct cgpu_info *cgpu);
+static void select_kernel(struct thr_info *thr, char *name, size_t nameSize);
 
 static bool opencl_thread_prepare(struct thr_info *thr)
 {
@@ -1274,25 +1461,34 @@ static bool opencl_thread_prepare(struct thr_info *thr)
   int virtual_gpu = cgpu->virtual_gpu;
   int i = thr->id;
   static bool failmessage = false;
-  int buffersize = BUFFERSIZE;
-
-  if (!blank_res)
-    blank_res = (uint32_t *)calloc(buffersize, 1);
-  if (!blank_res) {
-    applog(LOG_ERR, "Failed to calloc in opencl_thread_init");
-    return false;
-  }
+  static pthread_mutex_t failmessage_lock = PTHREAD_MUTEX_INITIALIZER;
+  bool benchmark = false;
 
   strcpy(name, "");
   applog(LOG_INFO, "Init GPU thread %i GPU %i virtual GPU %i", i, gpu, virtual_gpu);
 
+  /* The device's other threads build whatever its first one picked */
+  if (opt_auto_kernel && thr == cgpu->thr[0])
+    benchmark = !lookup_kernel(cgpu);
+
   clStates[i] = initCl(virtual_gpu, name, sizeof(name), &cgpu->algorithm);
+  /* Parked hot switch states may hold the memory this one needs */
+  if (!clStates[i] && opencl_warm_clear()) {
+    applog(LOG_INFO, "Released the warm GPU states, retrying GPU thread %d", i);
+    clStates[i] = initCl(virtual_gpu, name, sizeof(name), &cgpu->algorithm);
+  }
+  if (clStates[i] && !cgpu->name)
+    cgpu->name = strdup(name);
+  if (clStates[i] && benchmark)
+    select_kernel(thr, name, sizeof(name));
   if (!clStates[i]) {
 #ifdef HAVE_CURSES
     if (use_curses)
       enable_curses();
 #endif
     applog(LOG_ERR, "Failed to init GPU thread %d, disabling device %d", i, gpu);
+    /* Devices are prepared in parallel so only one gets to prompt */
+    mutex_lock(&failmessage_lock);
     if (!failmessage) {
       applog(LOG_ERR, "Restarting the GPU from the menu will not fix this.");
       applog(LOG_ERR, "Re-check your configuration and try restarting.");
@@ -1306,6 +1502,7 @@ static bool opencl_thread_prepare(struct thr_info *thr)
       }
 #endif
     }
+    mutex_unlock(&failmessage_lock);
     cgpu->deven = DEV_DISABLED;
     cgpu->status = LIFE_NOSTART;
 
@@ -1313,8 +1510,6 @@ static bool opencl_thread_prepare(struct thr_info *thr)
 
     return false;
   }
-  if (!cgpu->name)
-    cgpu->name = strdup(name);
 
   applog(LOG_INFO, "initCl() finished. Found %s", name);
   cgtime(&now);
@@ -1348,8 +1543,9 @@ static bool opencl_thread_init(struct thr_info *thr)
     return false;
   }
 
-  status |= clEnqueueWriteBuffer(clState->commandQueue, clState->outputBuffer, CL_TRUE, 0,
-    buffersize, blank_res, 0, NULL, NULL);
+  status = reset_found(clState, clState->outputBuffer, gpu->algorithm.found_idx);
+  if (likely(status == CL_SUCCESS))
+    status = clFinish(clState->commandQueue);
   if (unlikely(status != CL_SUCCESS)) {
     free(thrdata->res);
     free(thrdata);
@@ -1357,6 +1553,28 @@ static bool opencl_thread_init(struct thr_info *thr)
     return false;
   }
 
+  if (opt_gpu_pipeline) {
+    /* Second output buffer so one pass can run while the last is drained */
+    thrdata->pass[0].buffer = clState->outputBuffer;
+    thrdata->pass[0].res = thrdata->res;
+    thrdata->pass[1].buffer = clCreateBuffer(clState->context,
+      CL_MEM_WRITE_ONLY | (opt_gpu_mapped ? CL_MEM_ALLOC_HOST_PTR : 0), OUTPUTBUFSIZE, NULL, &status);
+    thrdata->pass[1].res = (uint32_t *)calloc(buffersize, 1);
+    if (status == CL_SUCCESS)
+      status = reset_found(clState, thrdata->pass[1].buffer, gpu->algorithm.found_idx);
+    if (status == CL_SUCCESS)
+      status = clFinish(clState->commandQueue);
+    if (unlikely(status != CL_SUCCESS || !thrdata->pass[1].res)) {
+      applog(LOG_ERR, "Error %d: Creating second output buffer for pipelining.", status);
+      if (thrdata->pass[1].buffer)
+        clReleaseMemObject(thrdata->pass[1].buffer);
+      free(thrdata->pass[1].res);
+      free(thrdata->res);
+      free(thrdata);
+      return false;
+    }
+  }
+
   gpu->status = LIFE_WELL;
 
   gpu->device_last_well = time(NULL);
@@ -1372,81 +1590,251 @@ static bool opencl_prepare_work(struct thr_info __maybe_unused *thr, struct work
   return true;
 }
 
-extern int opt_dynamic_interval;
+/* Most threads a pass can run without outgrowing the buffers that were
+ * sized for the device at init */
+static size_t autotune_max_threads(struct cgpu_info *gpu)
+{
+  /* Scratchpad algorithms size per thread for thread concurrency */
+  if (gpu->algorithm.rw_buffer_size < 0)
+    return gpu->thread_concurrency ? gpu->thread_concurrency : MAX_RAWINTENSITY;
+  /* The rest keep a 64 byte hash per thread when they need a buffer */
+  if (gpu->algorithm.rw_buffer_size > 0)
+    return gpu->algorithm.rw_buffer_size / 64;
+  return MAX_RAWINTENSITY;
+}
 
-static int64_t opencl_scanhash(struct thr_info *thr, struct work *work,
-  int64_t __maybe_unused max_nonce)
+/* Upload the header and set every kernel argument for a new work item. The
+ * upload is not waited for here: the passes wait on its event instead, and
+ * cldata is only reused once the upload is done. */
+static cl_int bind_work(struct thr_info *thr, struct work *work, size_t *globalThreads)
 {
-  const int thr_id = thr->id;
   struct opencl_thread_data *thrdata = (struct opencl_thread_data *)thr->cgpu_data;
-  struct cgpu_info *gpu = thr->cgpu;
-  _clState *clState = clStates[thr_id];
-  const int dynamic_us = opt_dynamic_interval * 1000;
-
+  _clState *clState = clStates[thr->id];
   cl_int status;
-  size_t globalThreads[1];
-  size_t localThreads[1] = { clState->wsize };
-  size_t *p_global_work_offset = NULL;
-  int64_t hashes;
-  int found = gpu->algorithm.found_idx;
-  int buffersize = BUFFERSIZE;
-  unsigned int i;
 
-  /* Windows' timer resolution is only 15ms so oversample 5x */
-  if (gpu->dynamic && (++gpu->intervals * dynamic_us) > 70000) {
-    struct timeval tv_gpuend;
-    double gpu_us;
+  if (clState->header_event) {
+    clWaitForEvents(1, &clState->header_event);
+    clReleaseEvent(clState->header_event);
+    clState->header_event = NULL;
+  }
 
-    cgtime(&tv_gpuend);
-    gpu_us = us_tdiff(&tv_gpuend, &gpu->tv_gpustart) / gpu->intervals;
-    if (gpu_us > dynamic_us) {
-      if (gpu->intensity > MIN_INTENSITY)
-        --gpu->intensity;
-    }
-    else if (gpu_us < dynamic_us / 2) {
-      if (gpu->intensity < MAX_INTENSITY)
-        ++gpu->intensity;
+  /* The header write must not overtake the passes still reading the old
+   * header, which an out of order queue would let it do */
+  if (clState->tail_event) {
+#ifdef CL_VERSION_1_2
+    if (clState->opencl_version >= 1.2)
+      status = clEnqueueBarrierWithWaitList(clState->commandQueue, 1, &clState->tail_event, NULL);
+    else
+#endif
+    status = clEnqueueWaitForEvents(clState->commandQueue, 1, &clState->tail_event);
+    if (unlikely(status != CL_SUCCESS)) {
+      applog(LOG_ERR, "Error %d: Ordering the header upload. (clEnqueueBarrier)", status);
+      return status;
     }
-    memcpy(&(gpu->tv_gpustart), &tv_gpuend, sizeof(struct timeval));
-    gpu->intervals = 0;
   }
 
-  set_threads_hashes(clState->vwidth, clState->compute_shaders, &hashes, globalThreads, localThreads[0],
-    &gpu->intensity, &gpu->xintensity, &gpu->rawintensity, &gpu->algorithm);
-  if (hashes > gpu->max_hashes)
-    gpu->max_hashes = hashes;
-
+  clState->bound = false;
+  clState->n_output_args = 0;
   status = thrdata->queue_kernel_parameters(clState, &work->blk, globalThreads[0]);
   if (unlikely(status != CL_SUCCESS)) {
     applog(LOG_ERR, "Error: clSetKernelArg of all params failed.");
-    return -1;
+    return status;
+  }
+  if (clState->out_of_order && clState->header_event) {
+    clRetainEvent(clState->header_event);
+    chain_to(clState, clState->header_event);
   }
 
+  clState->bound = true;
+  clState->bound_work = work->id;
+  clState->bound_output = clState->outputBuffer;
+  return CL_SUCCESS;
+}
+
+/* Point the kernels at the current output buffer, for the pipeline which
+ * alternates between two */
+static cl_int bind_output(_clState *clState)
+{
+  cl_int status = CL_SUCCESS;
+  unsigned int i;
+
+  for (i = 0; i < clState->n_output_args; i++)
+    status |= clSetKernelArg(clState->output_kernels[i], clState->output_args[i], sizeof(cl_mem),
+      (void *)&clState->outputBuffer);
+  if (unlikely(status != CL_SUCCESS))
+    applog(LOG_ERR, "Error %d: Setting the output buffer. (clSetKernelArg)", status);
+  else
+    clState->bound_output = clState->outputBuffer;
+  return status;
+}
+
+/* Queue the kernel chain followed by a non-blocking read of the current
+ * output buffer's found counter into res. A pipelined pass, one that asks
+ * for an event, reads the entries along with the counter: on an in order
+ * queue a read queued later would wait for the pass queued behind this one.
+ * The kernel arguments are only set when the work changes, a pass on the
+ * same work just moves the offset. */
+static cl_int enqueue_pass(struct thr_info *thr, struct work *work, size_t *globalThreads,
+  size_t *localThreads, uint32_t *res, cl_event *event)
+{
+  _clState *clState = clStates[thr->id];
+  size_t *p_global_work_offset = NULL;
+  int found = thr->cgpu->algorithm.found_idx;
+  const cl_event *wait;
+  cl_event chained = NULL, *read_event;
+  cl_int status;
+  unsigned int i;
+
+  if (!clState->bound || clState->bound_work != work->id)
+    status = bind_work(thr, work, globalThreads);
+  else if (clState->bound_output != clState->outputBuffer)
+    status = bind_output(clState);
+  else
+    status = CL_SUCCESS;
+  if (unlikely(status != CL_SUCCESS))
+    return status;
+
   if (clState->goffset)
     p_global_work_offset = (size_t *)&work->blk.nonce;
 
-  status = clEnqueueNDRangeKernel(clState->commandQueue, clState->kernel, 1, p_global_work_offset,
-    globalThreads, localThreads, 0, NULL, NULL);
-  if (unlikely(status != CL_SUCCESS)) {
-    applog(LOG_ERR, "Error %d: Enqueueing kernel onto command queue. (clEnqueueNDRangeKernel)", status);
-    return -1;
-  }
+  for (i = 0; i <= clState->n_extra_kernels; i++) {
+    cl_kernel kernel = i ? clState->extra_kernels[i - 1] : clState->kernel;
+    cl_uint num_wait = chain_wait(clState, &wait);
 
-  for (i = 0; i < clState->n_extra_kernels; i++) {
-    status = clEnqueueNDRangeKernel(clState->commandQueue, clState->extra_kernels[i], 1, p_global_work_offset,
-      globalThreads, localThreads, 0, NULL, NULL);
+    status = clEnqueueNDRangeKernel(clState->commandQueue, kernel, 1, p_global_work_offset,
+      globalThreads, localThreads, num_wait, wait, chain_event(clState, &chained));
     if (unlikely(status != CL_SUCCESS)) {
       applog(LOG_ERR, "Error %d: Enqueueing kernel onto command queue. (clEnqueueNDRangeKernel)", status);
-      return -1;
+      return status;
     }
+    chain_to(clState, chained);
   }
 
-  status = clEnqueueReadBuffer(clState->commandQueue, clState->outputBuffer, CL_FALSE, 0,
-    buffersize, thrdata->res, 0, NULL, NULL);
+  read_event = event ? event : chain_event(clState, &chained);
+  if (event)
+    status = clEnqueueReadBuffer(clState->commandQueue, clState->outputBuffer, CL_FALSE,
+      0, (found + 1) * sizeof(uint32_t), res, chain_wait(clState, &wait), wait, read_event);
+  else
+    status = clEnqueueReadBuffer(clState->commandQueue, clState->outputBuffer, CL_FALSE,
+      found * sizeof(uint32_t), sizeof(uint32_t), res + found, chain_wait(clState, &wait), wait, read_event);
   if (unlikely(status != CL_SUCCESS)) {
     applog(LOG_ERR, "Error: clEnqueueReadBuffer failed error %d. (clEnqueueReadBuffer)", status);
+    return status;
+  }
+  if (clState->out_of_order) {
+    if (event)
+      clRetainEvent(*event);
+    chain_to(clState, *read_event);
+  }
+
+  return status;
+}
+
+/* Wait for a queued pass to be read back and hand any nonces it found to
+ * verification. Its entries came back with the counter, so nothing waits on
+ * the pass queued behind it; the counter is cleared behind that pass. */
+static cl_int drain_pass(struct thr_info *thr, struct opencl_pass *pass)
+{
+  struct cgpu_info *gpu = thr->cgpu;
+  int found = gpu->algorithm.found_idx;
+  cl_int status = CL_SUCCESS;
+
+  if (!pass->event)
+    return CL_SUCCESS;
+
+  status = clWaitForEvents(1, &pass->event);
+  clReleaseEvent(pass->event);
+  pass->event = NULL;
+  if (unlikely(status != CL_SUCCESS))
+    applog(LOG_ERR, "Error %d: Waiting for kernel pass. (clWaitForEvents)", status);
+  else if (pass->res[found]) {
+    status = reset_found(clStates[thr->id], pass->buffer, found);
+    if (unlikely(status != CL_SUCCESS))
+      applog(LOG_ERR, "Error %d: Clearing the result counter failed.", status);
+    applog(LOG_DEBUG, "GPU %d found something?", gpu->device_id);
+    postcalc_hash_async(thr, pass->work, pass->res);
+  }
+  free_work(pass->work);
+  pass->work = NULL;
+
+  return status;
+}
+
+/* Queue pass N+1 into the spare output buffer before draining pass N, so the
+ * device has work while the host reads results and sets up the next pass */
+static int64_t opencl_scanhash_pipelined(struct thr_info *thr, struct work *work,
+  size_t *globalThreads, size_t *localThreads, int64_t hashes)
+{
+  struct opencl_thread_data *thrdata = (struct opencl_thread_data *)thr->cgpu_data;
+  struct opencl_pass *cur = &thrdata->pass[thrdata->cur];
+  struct opencl_pass *prev = &thrdata->pass[thrdata->cur ^ 1];
+  _clState *clState = clStates[thr->id];
+  struct cgpu_info *gpu = thr->cgpu;
+  cl_int status;
+
+  /* If the last pass already finished the device has been idle since */
+  if (prev->event) {
+    if (__atomic_load_n(&prev->done, __ATOMIC_ACQUIRE))
+      add_idle_gap(gpu, &prev->tv_done);
+    else
+      add_idle_gap(gpu, NULL);
+  }
+
+  clState->outputBuffer = cur->buffer;
+  cur->done = 0;
+  status = enqueue_pass(thr, work, globalThreads, localThreads, cur->res, &cur->event);
+  clState->outputBuffer = thrdata->pass[0].buffer;
+  if (unlikely(status != CL_SUCCESS)) {
+    cur->event = NULL;
     return -1;
   }
+  clSetEventCallback(cur->event, CL_COMPLETE, pass_done, cur);
+  clFlush(clState->commandQueue);
+  cur->work = copy_work(work);
+
+  /* The amount of work scanned can fluctuate when intensity changes
+   * and since we do this one cycle behind, we increment the work more
+   * than enough to prevent repeating work */
+  work->blk.nonce += gpu->max_hashes;
+
+  status = drain_pass(thr, prev);
+  thrdata->cur ^= 1;
+  if (unlikely(status != CL_SUCCESS))
+    return -1;
+
+  return hashes;
+}
+
+static int64_t opencl_scanhash(struct thr_info *thr, struct work *work,
+  int64_t __maybe_unused max_nonce)
+{
+  const int thr_id = thr->id;
+  struct opencl_thread_data *thrdata = (struct opencl_thread_data *)thr->cgpu_data;
+  struct cgpu_info *gpu = thr->cgpu;
+  _clState *clState = clStates[thr_id];
+
+  cl_int status;
+  size_t globalThreads[1];
+  size_t localThreads[1] = { clState->wsize };
+  int64_t hashes;
+  int found = gpu->algorithm.found_idx;
+
+  set_threads_hashes(clState->vwidth, clState->compute_shaders, clState->intensity_rshift, &hashes, globalThreads, localThreads[0],
+    &gpu->intensity, &gpu->xintensity, &gpu->rawintensity, &gpu->algorithm);
+  if (hashes > gpu->max_hashes)
+    gpu->max_hashes = hashes;
+  if (gpu->dynamic)
+    autotune_update(gpu, globalThreads[0], localThreads[0], autotune_max_threads(gpu));
+
+  if (opt_gpu_pipeline)
+    return opencl_scanhash_pipelined(thr, work, globalThreads, localThreads, hashes);
+
+  if (thrdata->tv_done.tv_sec)
+    add_idle_gap(gpu, &thrdata->tv_done);
+
+  status = enqueue_pass(thr, work, globalThreads, localThreads, thrdata->res, NULL);
+  if (unlikely(status != CL_SUCCESS))
+    return -1;
 
   /* The amount of work scanned can fluctuate when intensity changes
    * and since we do this one cycle behind, we increment the work more
@@ -1455,40 +1843,50 @@ static int64_t opencl_scanhash(struct thr_info *thr, struct work *work,
 
   /* This finish flushes the readbuffer set with CL_FALSE in clEnqueueReadBuffer */
   clFinish(clState->commandQueue);
+  cgtime(&thrdata->tv_done);
 
   /* found entry is used as a counter to say how many nonces exist */
   if (thrdata->res[found]) {
-    /* Clear the buffer again */
-    status = clEnqueueWriteBuffer(clState->commandQueue, clState->outputBuffer, CL_FALSE, 0,
-      buffersize, blank_res, 0, NULL, NULL);
-    if (unlikely(status != CL_SUCCESS)) {
-      applog(LOG_ERR, "Error: clEnqueueWriteBuffer failed.");
+    /* Fetch what was found and clear the counter again */
+    status = fetch_results(thr, clState->outputBuffer, thrdata->res);
+    if (unlikely(status != CL_SUCCESS))
       return -1;
-    }
     applog(LOG_DEBUG, "GPU %d found something?", gpu->device_id);
     postcalc_hash_async(thr, work, thrdata->res);
 //	postcalc_hash(thr);
 //	submit_tested_work(thr, work);
 //	submit_work_async(work);
-    memset(thrdata->res, 0, buffersize);
-    /* This finish flushes the writebuffer set with CL_FALSE in clEnqueueWriteBuffer */
+    /* This finish flushes the counter reset queued by fetch_results */
     clFinish(clState->commandQueue);
+    cgtime(&thrdata->tv_done);
   }
 
   return hashes;
 }
 
 // Cleanup OpenCL memory on the GPU
-// Note: This function is not thread-safe (clStates modification not atomic)
-static void opencl_thread_shutdown(struct thr_info *thr)
+static void release_opencl_state(_clState *clState, struct opencl_thread_data *thrdata)
 {
-  const int thr_id = thr->id;
-  _clState *clState = clStates[thr_id];
-  clStates[thr_id] = NULL;
   unsigned int i;
 
   if (clState) {
     clFinish(clState->commandQueue);
+    for (i = 0; thrdata && i < 2; i++) {
+      struct opencl_pass *pass = &thrdata->pass[i];
+
+      if (pass->event)
+        clReleaseEvent(pass->event);
+      if (pass->work)
+        free_work(pass->work);
+      if (i && pass->buffer) {
+        clReleaseMemObject(pass->buffer);
+        free(pass->res);
+      }
+    }
+    if (clState->header_event)
+      clReleaseEvent(clState->header_event);
+    if (clState->tail_event)
+      clReleaseEvent(clState->tail_event);
     clReleaseMemObject(clState->outputBuffer);
     clReleaseMemObject(clState->CLbuffer0);
 	if (clState->buffer1)
@@ -1509,11 +1907,370 @@ static void opencl_thread_shutdown(struct thr_info *thr)
       free(clState->extra_kernels);
     free(clState);
   }
-  free(((struct opencl_thread_data *)thr->cgpu_data)->res);
-  free(thr->cgpu_data);
+  if (thrdata) {
+    free(thrdata->res);
+    free(thrdata);
+  }
+}
+
+static const unsigned char select_block[] = { SGMINER_BENCHMARK_BLOCK };
+
+/* Kernels report a hash whose top 16 bits are clear, about one in 65536,
+ * so even a slow device verifies plenty of nonces in a benchmark while the
+ * result buffer rarely fills. Diff 1 is one in 2^32 for most chains. */
+#define SELECT_TARGET_TOP 0x0000FFFFU
+
+/* Mine the benchmark block against SELECT_TARGET_TOP with the kernel
+ * clStates[thr->id] was built for, for KERNEL_SELECT_SECONDS, and check
+ * every nonce it reports with the CPU hash. Returns hashes per second, or 0
+ * if the kernel failed, found nothing or reported a nonce the CPU does not
+ * agree with. */
+static double time_kernel(struct thr_info *thr, struct pool *pool)
+{
+  struct cgpu_info *gpu = thr->cgpu;
+  _clState *clState = clStates[thr->id];
+  struct opencl_thread_data thrdata;
+  int found = gpu->algorithm.found_idx;
+  size_t globalThreads[1];
+  size_t localThreads[1] = { clState->wsize };
+  struct timeval start, now;
+  struct work work;
+  int64_t hashes, total = 0;
+  int good = 0, bad = 0;
+  uint32_t i, count;
+  cl_int status;
+  double secs;
+
+  memset(&thrdata, 0, sizeof(thrdata));
+  thrdata.queue_kernel_parameters = gpu->algorithm.queue_kernel;
+  thrdata.res = (uint32_t *)calloc(BUFFERSIZE, 1);
+  if (unlikely(!thrdata.res))
+    quit(1, "Failed to calloc in time_kernel");
+  thr->cgpu_data = &thrdata;
+
+  memset(&work, 0, sizeof(work));
+  memcpy(work.data, select_block, MIN(sizeof(work.data), sizeof(select_block)));
+  work.pool = pool;
+  work.thr_id = thr->id;
+  if (pool->algorithm.calc_midstate)
+    pool->algorithm.calc_midstate(&work);
+  work.blk.work = &work;
+  if (pool->algorithm.prepare_work)
+    pool->algorithm.prepare_work(&work.blk, (uint32_t *)work.midstate, (uint32_t *)work.data);
+  memset(work.device_target, 0xff, sizeof(work.device_target));
+  ((uint32_t *)work.device_target)[7] = htole32(SELECT_TARGET_TOP);
+
+  set_threads_hashes(clState->vwidth, clState->compute_shaders, clState->intensity_rshift, &hashes, globalThreads, localThreads[0],
+    &gpu->intensity, &gpu->xintensity, &gpu->rawintensity, &gpu->algorithm);
+
+  status = reset_found(clState, clState->outputBuffer, found);
+  cgtime(&start);
+  do {
+    if (likely(status == CL_SUCCESS))
+      status = enqueue_pass(thr, &work, globalThreads, localThreads, thrdata.res, NULL);
+    if (likely(status == CL_SUCCESS))
+      status = clFinish(clState->commandQueue);
+    if (likely(status == CL_SUCCESS) && thrdata.res[found]) {
+      count = MIN(thrdata.res[found], (uint32_t)found);
+      status = fetch_results(thr, clState->outputBuffer, thrdata.res);
+      if (likely(status == CL_SUCCESS))
+        status = clFinish(clState->commandQueue);
+      for (i = 0; status == CL_SUCCESS && i < count; i++) {
+        uint32_t nonce = thrdata.res[i];
+
+        if (found == 0x0F)
+          nonce = swab32(nonce);
+        set_work_nonce(&work, nonce);
+        pool->algorithm.regenhash(&work);
+        if (fulltest(work.hash, work.device_target))
+          good++;
+        else
+          bad++;
+      }
+    }
+    if (unlikely(status != CL_SUCCESS))
+      break;
+    work.blk.nonce += hashes;
+    total += hashes;
+    cgtime(&now);
+  } while (tdiff(&now, &start) < KERNEL_SELECT_SECONDS);
+
+  /* The stack work's id means nothing to the next real work */
+  clState->bound = false;
+  thr->cgpu_data = NULL;
+  free(thrdata.res);
+
+  if (status != CL_SUCCESS) {
+    applog(LOG_WARNING, "GPU %d: kernel %s failed the benchmark (error %d)", gpu->device_id,
+      get_algorithm_kernel(&gpu->algorithm), status);
+    return 0;
+  }
+  secs = tdiff(&now, &start);
+  applog(LOG_NOTICE, "GPU %d: kernel %s %.1f kH/s, %d of %d nonces verified", gpu->device_id,
+    get_algorithm_kernel(&gpu->algorithm), total / secs / 1000.0, good, good + bad);
+  if (bad || !good)
+    return 0;
+  return total / secs;
+}
+
+/* --auto-kernel. Switch the device to the kernel the selection database has
+ * for its PoW, before anything is built. Returns false if the kernels still
+ * need benchmarking by select_kernel. */
+static bool lookup_kernel(struct cgpu_info *cgpu)
+{
+  const char *variants[KERNEL_SELECT_MAX];
+  char winner[sizeof(cgpu->algorithm.name)];
+  int n, k;
+
+  /* A kernel file given by hand is what the user wants to run */
+  if (!empty_string(cgpu->algorithm.kernelfile))
+    return true;
+  n = get_algorithm_variants(&cgpu->algorithm, variants, KERNEL_SELECT_MAX);
+  if (n < 2)
+    return true;
+
+  if (!kernel_select_lookup(cgpu, variants[0], winner, sizeof(winner)))
+    return false;
+  for (k = 0; k < n; k++) {
+    if (!strcmp(winner, variants[k])) {
+      applog(LOG_INFO, "GPU %d: kernel %s from the kernel selection database", cgpu->device_id, winner);
+      set_algorithm_kernel(&cgpu->algorithm, winner);
+      return true;
+    }
+  }
+  return false;
+}
+
+/* --auto-kernel. The first time a device mines a PoW more than one kernel
+ * can mine, time each of them and keep the fastest whose nonces all pass
+ * the CPU hash. The winner is saved per device, so later runs only build
+ * that one. Leaves clStates[thr->id] built for cgpu->algorithm, or NULL. */
+static void select_kernel(struct thr_info *thr, char *name, size_t nameSize)
+{
+  struct cgpu_info *cgpu = thr->cgpu;
+  const char *variants[KERNEL_SELECT_MAX];
+  const char *winner = NULL;
+  algorithm_t configured = cgpu->algorithm;
+  int intensity = cgpu->intensity;
+  int xintensity = cgpu->xintensity;
+  int rawintensity = cgpu->rawintensity;
+  struct pool *pool;
+  double rate, best = 0;
+  int n, k;
+
+  n = get_algorithm_variants(&cgpu->algorithm, variants, KERNEL_SELECT_MAX);
+
+  pool = (struct pool *)calloc(1, sizeof(*pool));
+  if (unlikely(!pool))
+    quit(1, "Failed to calloc in select_kernel");
+
+  applog(LOG_NOTICE, "GPU %d: benchmarking %d %s kernels", cgpu->device_id, n, variants[0]);
+  for (k = 0; k < n; k++) {
+    /* The configured kernel is already built */
+    if (strcmp(variants[k], get_algorithm_kernel(&cgpu->algorithm))) {
+      release_opencl_state(clStates[thr->id], NULL);
+      cgpu->algorithm = configured;
+      set_algorithm_kernel(&cgpu->algorithm, variants[k]);
+      clStates[thr->id] = initCl(cgpu->virtual_gpu, name, nameSize, &cgpu->algorithm);
+      if (!clStates[thr->id]) {
+        applog(LOG_WARNING, "GPU %d: kernel %s failed to build, skipping it", cgpu->device_id, variants[k]);
+        continue;
+      }
+    }
+
+    pool->algorithm = cgpu->algorithm;
+    rate = time_kernel(thr, pool);
+    cgpu->intensity = intensity;
+    cgpu->xintensity = xintensity;
+    cgpu->rawintensity = rawintensity;
+    if (rate > best) {
+      best = rate;
+      winner = variants[k];
+    }
+  }
+  free(pool);
+
+  if (winner) {
+    applog(LOG_NOTICE, "GPU %d: %s is the fastest %s kernel", cgpu->device_id, winner, variants[0]);
+    kernel_select_save(cgpu, variants[0], winner);
+  }
+  else {
+    winner = get_algorithm_kernel(&configured);
+    applog(LOG_WARNING, "GPU %d: no %s kernel passed the benchmark, keeping %s", cgpu->device_id,
+      variants[0], winner);
+  }
+
+  if (!clStates[thr->id] || strcmp(winner, get_algorithm_kernel(&cgpu->algorithm))) {
+    release_opencl_state(clStates[thr->id], NULL);
+    cgpu->algorithm = configured;
+    set_algorithm_kernel(&cgpu->algorithm, winner);
+    clStates[thr->id] = initCl(cgpu->virtual_gpu, name, nameSize, &cgpu->algorithm);
+  }
+}
+
+// Note: This function is not thread-safe (clStates modification not atomic)
+static void opencl_thread_shutdown(struct thr_info *thr)
+{
+  const int thr_id = thr->id;
+  _clState *clState = clStates[thr_id];
+  clStates[thr_id] = NULL;
+
+  release_opencl_state(clState, (struct opencl_thread_data *)thr->cgpu_data);
   thr->cgpu_data = NULL;
 }
 
+/* Hot switching. The OpenCL state of every thread, and the GPU settings it
+ * was built for, are parked in a slot when the pool settings change and
+ * swapped back in when they change back, so only the first switch to a set
+ * of settings has to build anything. */
+struct opencl_warm_thread {
+  _clState *clState;
+  struct opencl_thread_data *thrdata;
+};
+
+struct opencl_warm_settings {
+  bool valid;
+  algorithm_t algorithm;
+  int intensity;
+  int xintensity;
+  int rawintensity;
+  bool dynamic;
+  size_t work_size;
+  int opt_lg, lookup_gap;
+  size_t opt_tc, thread_concurrency;
+  size_t shaders;
+  int64_t max_hashes;
+  int tune_stable;
+  bool tune_saved;
+};
+
+bool opt_hot_switch;
+
+static struct opencl_warm_thread warm_threads[OPENCL_WARM_SLOTS][MAX_GPUDEVICES];
+static struct opencl_warm_settings warm_settings[OPENCL_WARM_SLOTS][MAX_GPUDEVICES];
+static pthread_mutex_t warm_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Must be called with every mining thread held between passes */
+void opencl_warm_park(struct thr_info **thr, int count, int slot)
+{
+  int i;
+
+  for (i = 0; i < count; i++) {
+    struct opencl_warm_thread *warm = &warm_threads[slot][thr[i]->id];
+    struct opencl_thread_data *thrdata = (struct opencl_thread_data *)thr[i]->cgpu_data;
+
+    if (thr[i]->cgpu->drv->drv_id != DRIVER_opencl)
+      continue;
+
+    /* Results of a pipelined pass still belong to the old pool */
+    if (thrdata && opt_gpu_pipeline) {
+      drain_pass(thr[i], &thrdata->pass[thrdata->cur ^ 1]);
+      drain_pass(thr[i], &thrdata->pass[thrdata->cur]);
+    }
+    release_opencl_state(warm->clState, warm->thrdata);
+    warm->clState = clStates[thr[i]->id];
+    warm->thrdata = thrdata;
+    clStates[thr[i]->id] = NULL;
+    thr[i]->cgpu_data = NULL;
+  }
+
+  for (i = 0; i < nDevs; i++) {
+    struct opencl_warm_settings *settings = &warm_settings[slot][i];
+    struct cgpu_info *gpu = &gpus[i];
+
+    settings->valid = true;
+    settings->algorithm = gpu->algorithm;
+    settings->intensity = gpu->intensity;
+    settings->xintensity = gpu->xintensity;
+    settings->rawintensity = gpu->rawintensity;
+    settings->dynamic = gpu->dynamic;
+    settings->work_size = gpu->work_size;
+    settings->opt_lg = gpu->opt_lg;
+    settings->lookup_gap = gpu->lookup_gap;
+    settings->opt_tc = gpu->opt_tc;
+    settings->thread_concurrency = gpu->thread_concurrency;
+    settings->shaders = gpu->shaders;
+    settings->max_hashes = gpu->max_hashes;
+    settings->tune_stable = gpu->tune_stable;
+    settings->tune_saved = gpu->tune_saved;
+  }
+}
+
+/* Swap in what was parked in slot. Returns false, and changes nothing, if
+ * the slot is empty. */
+bool opencl_warm_resume(struct thr_info **thr, int count, int slot)
+{
+  int i;
+
+  if (!warm_settings[slot][0].valid)
+    return false;
+
+  for (i = 0; i < nDevs; i++) {
+    struct opencl_warm_settings *settings = &warm_settings[slot][i];
+    struct cgpu_info *gpu = &gpus[i];
+
+    gpu->algorithm = settings->algorithm;
+    gpu->intensity = settings->intensity;
+    gpu->xintensity = settings->xintensity;
+    gpu->rawintensity = settings->rawintensity;
+    gpu->dynamic = settings->dynamic;
+    gpu->work_size = settings->work_size;
+    gpu->opt_lg = settings->opt_lg;
+    gpu->lookup_gap = settings->lookup_gap;
+    gpu->opt_tc = settings->opt_tc;
+    gpu->thread_concurrency = settings->thread_concurrency;
+    gpu->shaders = settings->shaders;
+    gpu->max_hashes = settings->max_hashes;
+    gpu->tune_stable = settings->tune_stable;
+    gpu->tune_saved = settings->tune_saved;
+    /* Kernel times from the other algorithm mean nothing here */
+    gpu->tv_gpustart.tv_sec = 0;
+    settings->valid = false;
+  }
+
+  for (i = 0; i < count; i++) {
+    struct opencl_warm_thread *warm = &warm_threads[slot][thr[i]->id];
+
+    if (thr[i]->cgpu->drv->drv_id != DRIVER_opencl)
+      continue;
+
+    clStates[thr[i]->id] = warm->clState;
+    thr[i]->cgpu_data = warm->thrdata;
+    if (warm->thrdata)
+      warm->thrdata->tv_done.tv_sec = 0;
+    warm->clState = NULL;
+    warm->thrdata = NULL;
+  }
+
+  return true;
+}
+
+/* Release everything parked, e.g. before the mining threads are rebuilt or
+ * when a new state does not fit beside them. Returns whether anything was
+ * released. Threads are prepared in parallel, hence the lock. */
+bool opencl_warm_clear(void)
+{
+  bool released = false;
+  int slot, i;
+
+  mutex_lock(&warm_lock);
+  for (slot = 0; slot < OPENCL_WARM_SLOTS; slot++) {
+    for (i = 0; i < MAX_GPUDEVICES; i++) {
+      struct opencl_warm_thread *warm = &warm_threads[slot][i];
+
+      if (warm->clState || warm->thrdata)
+        released = true;
+      release_opencl_state(warm->clState, warm->thrdata);
+      warm->clState = NULL;
+      warm->thrdata = NULL;
+      warm_settings[slot][i].valid = false;
+    }
+  }
+  mutex_unlock(&warm_lock);
+
+  return released;
+}
+
 struct device_drv opencl_drv = {
   /*.drv_id = */      DRIVER_opencl,
   /*.dname = */     "opencl",
@@ -1526,7 +2283,7 @@ struct device_drv opencl_drv = {
   NULL,
 #endif
   /*.get_statline = */    get_opencl_statline,
-  /*.api_data = */    NULL,
+  /*.api_data = */    opencl_api_stats,
   /*.get_stats = */   NULL,
   /*.identify_device = */   NULL,
   /*.set_device = */    NULL,
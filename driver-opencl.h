@@ -20,6 +20,7 @@ extern char *set_intensity(const char *arg);
 extern char *set_xintensity(const char *arg);
 extern char *set_rawintensity(const char *arg);
 extern char *set_vector(char *arg);
+extern char *set_device_type(char *arg);
 extern char *set_worksize(const char *arg);
 extern char *set_shaders(char *arg);
 extern char *set_lookup_gap(char *arg);
@@ -28,6 +29,16 @@ void manage_gpu(void);
 extern void pause_dynamic_threads(int gpu);
 
 extern int opt_platform_id;
+extern bool opt_gpu_pipeline;
+extern bool opt_gpu_mapped;
+extern bool opt_hot_switch;
+
+/* Sets of pool settings whose OpenCL state can be kept warm at once */
+#define OPENCL_WARM_SLOTS 8
+
+extern void opencl_warm_park(struct thr_info **thr, int count, int slot);
+extern bool opencl_warm_resume(struct thr_info **thr, int count, int slot);
+extern bool opencl_warm_clear(void);
 
 extern struct device_drv opencl_drv;
 
@@ -0,0 +1,355 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.  See COPYING for more details.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+#include "compat.h"
+#include "miner.h"
+#include "config_parser.h"
+#include "driver-sim.h"
+#include "util.h"
+#include "api.h"
+
+struct sim_thread_data {
+  double shares_due;          /* Fraction of a share carried between passes */
+  struct timeval tv_notify;   /* Notify of the last job this thread hashed */
+};
+
+/* Shared by all simulated devices, under sim_lock */
+struct sim_stats {
+  struct timeval tv_start;
+  struct timeval tv_notify;   /* Latest notify any device has hashed */
+  int jobs;
+  double first_hash_total;    /* ms from notify to the first device hashing it */
+  double first_hash_max;
+  int switches;
+  double switch_total;        /* ms from notify to each device hashing it */
+  double switch_max;
+  uint64_t shares;
+  double search_cpu;          /* Seconds spent finding the shares */
+  bool reported;
+};
+
+int opt_sim_devices;
+double opt_sim_hashrate = 1000;
+int opt_sim_latency = 10;
+
+static struct cgpu_info *sim_devices;
+static struct sim_stats sim_stats;
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+
+char *set_sim_hashrate(const char *arg)
+{
+  char *end;
+  double val = strtod(arg, &end);
+
+  if (end == arg || *end || val <= 0)
+    return "Invalid value passed to set_sim_hashrate";
+  opt_sim_hashrate = val;
+  return NULL;
+}
+
+static double thread_cpu_time(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec ts;
+
+  if (!clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+  return 0;
+}
+
+/* User and system time of the whole process, -1 where it is not known */
+static double process_cpu_time(void)
+{
+#ifndef WIN32
+  struct rusage ru;
+
+  if (!getrusage(RUSAGE_SELF, &ru))
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+      ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+#endif
+  return -1;
+}
+
+static void sim_detect(void)
+{
+  int i;
+
+  if (!opt_sim_devices)
+    return;
+
+  sim_devices = (struct cgpu_info *)calloc(opt_sim_devices, sizeof(*sim_devices));
+  if (unlikely(!sim_devices))
+    quit(1, "Failed to calloc sim_devices");
+
+  for (i = 0; i < opt_sim_devices; i++) {
+    struct cgpu_info *sim = &sim_devices[i];
+
+    sim->drv = &sim_drv;
+    sim->deven = DEV_ENABLED;
+    sim->threads = 1;
+    sim->algorithm = default_profile.algorithm;
+    sim->name = strdup("Simulator");
+    add_cgpu(sim);
+  }
+
+  cgtime(&sim_stats.tv_start);
+  applog(LOG_WARNING, "Simulating %d devices at %.0f kH/s with %d ms passes",
+    opt_sim_devices, opt_sim_hashrate, opt_sim_latency);
+}
+
+static void get_sim_statline(char *buf, size_t bufsiz, struct cgpu_info __maybe_unused *sim)
+{
+  tailsprintf(buf, bufsiz, " P:%2dms", opt_sim_latency);
+}
+
+/* Every simulated device reports the totals for all of them */
+static struct api_data *sim_api_stats(struct cgpu_info __maybe_unused *sim)
+{
+  struct api_data *root = NULL;
+  struct sim_stats stats;
+  struct timeval now;
+  double elapsed, cpu, first_avg, switch_avg, shares_per_sec, cpu_per_share;
+
+  mutex_lock(&sim_lock);
+  stats = sim_stats;
+  mutex_unlock(&sim_lock);
+
+  cgtime(&now);
+  elapsed = tdiff(&now, &stats.tv_start);
+  cpu = process_cpu_time();
+  first_avg = stats.jobs ? stats.first_hash_total / stats.jobs : 0;
+  switch_avg = stats.switches ? stats.switch_total / stats.switches : 0;
+  shares_per_sec = elapsed > 0 ? stats.shares / elapsed : 0;
+  cpu_per_share = (cpu >= 0 && stats.shares) ? (cpu - stats.search_cpu) * 1000.0 / stats.shares : 0;
+
+  root = api_add_int(root, "Sim Devices", &opt_sim_devices, false);
+  root = api_add_double(root, "Sim Hashrate", &opt_sim_hashrate, false);
+  root = api_add_int(root, "Sim Latency", &opt_sim_latency, false);
+  root = api_add_int(root, "Jobs", &stats.jobs, true);
+  root = api_add_double(root, "First Hash Avg", &first_avg, true);
+  root = api_add_double(root, "First Hash Max", &stats.first_hash_max, true);
+  root = api_add_double(root, "Switch Avg", &switch_avg, true);
+  root = api_add_double(root, "Switch Max", &stats.switch_max, true);
+  root = api_add_uint64(root, "Shares", &stats.shares, true);
+  root = api_add_double(root, "Shares/s", &shares_per_sec, true);
+  root = api_add_double(root, "CPU ms/Share", &cpu_per_share, true);
+
+  return root;
+}
+
+void sim_report(void)
+{
+  struct timeval now;
+  double elapsed, cpu;
+
+  mutex_lock(&sim_lock);
+  if (!opt_sim_devices || sim_stats.reported) {
+    mutex_unlock(&sim_lock);
+    return;
+  }
+  sim_stats.reported = true;
+
+  cgtime(&now);
+  elapsed = tdiff(&now, &sim_stats.tv_start);
+  cpu = process_cpu_time();
+
+  applog(LOG_WARNING, "Simulator: %d devices, %d jobs in %.0fs", opt_sim_devices,
+    sim_stats.jobs, elapsed);
+  if (sim_stats.jobs)
+    applog(LOG_WARNING, "Simulator: notify to first hash %.2f ms avg, %.2f ms max",
+      sim_stats.first_hash_total / sim_stats.jobs, sim_stats.first_hash_max);
+  if (sim_stats.switches)
+    applog(LOG_WARNING, "Simulator: notify to every device %.2f ms avg, %.2f ms max",
+      sim_stats.switch_total / sim_stats.switches, sim_stats.switch_max);
+  if (elapsed > 0)
+    applog(LOG_WARNING, "Simulator: %"PRIu64" shares, %.2f shares/s", sim_stats.shares,
+      sim_stats.shares / elapsed);
+  if (cpu >= 0 && sim_stats.shares)
+    applog(LOG_WARNING, "Simulator: %.3f ms host CPU per share, not counting %.1fs finding them",
+      (cpu - sim_stats.search_cpu) * 1000.0 / sim_stats.shares, sim_stats.search_cpu);
+  mutex_unlock(&sim_lock);
+}
+
+static bool sim_thread_prepare(struct thr_info *thr)
+{
+  struct timeval now;
+
+  thr->cgpu_data = calloc(1, sizeof(struct sim_thread_data));
+  if (!thr->cgpu_data) {
+    applog(LOG_ERR, "Failed to calloc in sim_thread_prepare");
+    return false;
+  }
+
+  cgtime(&now);
+  get_datestamp(thr->cgpu->init, sizeof(thr->cgpu->init), &now);
+  return true;
+}
+
+static bool sim_thread_init(struct thr_info *thr)
+{
+  struct cgpu_info *sim = thr->cgpu;
+
+  sim->status = LIFE_WELL;
+  sim->device_last_well = time(NULL);
+  return true;
+}
+
+static bool sim_prepare_work(struct thr_info *thr, struct work *work)
+{
+  thr->pool_no = work->pool->pool_no;
+  return true;
+}
+
+/* One pass per scanhash call, so the nonce range is set by the pass size */
+static uint64_t sim_can_limit_work(struct thr_info __maybe_unused *thr)
+{
+  return 0xffffffff;
+}
+
+/* Time from the notify of a stratum job to this thread starting on it, and
+ * to the first of all the simulated devices starting on it */
+static void sim_note_job(struct sim_thread_data *thrdata, struct stratum_job *job, struct timeval *now)
+{
+  double ms;
+
+  if (!time_more(&job->tv_notify, &thrdata->tv_notify))
+    return;
+  copy_time(&thrdata->tv_notify, &job->tv_notify);
+  ms = us_tdiff(now, &job->tv_notify) / 1000.0;
+
+  mutex_lock(&sim_lock);
+  sim_stats.switches++;
+  sim_stats.switch_total += ms;
+  if (ms > sim_stats.switch_max)
+    sim_stats.switch_max = ms;
+  if (time_more(&job->tv_notify, &sim_stats.tv_notify)) {
+    copy_time(&sim_stats.tv_notify, &job->tv_notify);
+    sim_stats.jobs++;
+    sim_stats.first_hash_total += ms;
+    if (ms > sim_stats.first_hash_max)
+      sim_stats.first_hash_max = ms;
+  }
+  mutex_unlock(&sim_lock);
+}
+
+/* Chance of one hash meeting the device target. Shares also have to be
+ * diff 1, so a target below that is as good as diff 1. */
+static double target_odds(struct work *work)
+{
+  const uint32_t *target = (const uint32_t *)work->device_target;
+  const uint32_t diff1targ = work->pool->algorithm.diff1targ;
+
+  if (le32toh(target[7]) >= diff1targ)
+    return (diff1targ + 1.0) / 4294967296.0;
+  return (le32toh(target[7]) + le32toh(target[6]) / 4294967296.0) / 4294967296.0;
+}
+
+/* Stand in for one kernel pass over opt_sim_hashrate * opt_sim_latency
+ * nonces. The pass takes opt_sim_latency ms and returns as many shares as
+ * the device would have found on average. They are real shares, found by
+ * hashing the work's nonces on the CPU from the start of the pass until
+ * there are enough of them, and are checked and submitted the same way as
+ * those from a GPU. */
+static int64_t sim_scanhash(struct thr_info *thr, struct work *work, int64_t max_nonce)
+{
+  struct sim_thread_data *thrdata = (struct sim_thread_data *)thr->cgpu_data;
+  const uint32_t first = work->blk.nonce;
+  uint32_t end = (max_nonce > 0xffffffffLL) ? 0xffffffff : (uint32_t)max_nonce;
+  uint64_t pass = opt_sim_hashrate * opt_sim_latency;
+  const uint32_t target = le32toh(((uint32_t *)work->device_target)[7]);
+  struct timeval now;
+  cgtimer_t ts_start;
+  uint32_t nonce;
+  double search_start;
+  uint64_t found = 0;
+
+  cgsleep_prepare_r(&ts_start);
+  if (work->job) {
+    cgtime(&now);
+    sim_note_job(thrdata, work->job, &now);
+  }
+
+  if (pass > end - first)
+    pass = end - first;
+  thrdata->shares_due += pass * target_odds(work);
+
+  /* Shares the pass's range is short of are searched for further into the
+   * work, and whatever the work runs out before is owed to the next pass,
+   * so over time the shares match the hashrate times the odds */
+  search_start = thread_cpu_time();
+  for (nonce = first; thrdata->shares_due >= 1 && nonce < end; nonce++) {
+    if (test_nonce(work, nonce) && le32toh(*(uint32_t *)(work->hash + 28)) <= target) {
+      submit_tested_work(thr, work);
+      thrdata->shares_due--;
+      found++;
+    }
+  }
+
+  mutex_lock(&sim_lock);
+  sim_stats.shares += found;
+  sim_stats.search_cpu += thread_cpu_time() - search_start;
+  mutex_unlock(&sim_lock);
+
+  cgsleep_us_r(&ts_start, opt_sim_latency * 1000);
+
+  /* Nonces searched past the pass are not to be found again */
+  work->blk.nonce = MAX(first + (uint32_t)pass, nonce);
+  return pass;
+}
+
+static void sim_thread_shutdown(struct thr_info *thr)
+{
+  free(thr->cgpu_data);
+  thr->cgpu_data = NULL;
+}
+
+struct device_drv sim_drv = {
+  /*.drv_id = */      DRIVER_sim,
+  /*.dname = */     "sim",
+  /*.name = */      "SIM",
+  /*.drv_detect = */    sim_detect,
+  /*.reinit_device = */   NULL,
+  /*.get_statline_before = */ NULL,
+  /*.get_statline = */    get_sim_statline,
+  /*.api_data = */    sim_api_stats,
+  /*.get_stats = */   NULL,
+  /*.identify_device = */ NULL,
+  /*.set_device = */    NULL,
+
+  /*.thread_prepare = */  sim_thread_prepare,
+  /*.can_limit_work = */  sim_can_limit_work,
+  /*.thread_init = */   sim_thread_init,
+  /*.prepare_work = */    sim_prepare_work,
+  /*.hash_work = */   NULL,
+  /*.scanhash = */    sim_scanhash,
+  /*.scanwork = */    NULL,
+  /*.queue_full = */    NULL,
+  /*.flush_work = */    NULL,
+  /*.update_work = */   NULL,
+  /*.hw_error = */      NULL,
+  /*.thread_shutdown = */ sim_thread_shutdown,
+  /*.thread_enable =*/    NULL,
+  /*.zero_stats = */    NULL,
+  /*.copy = */      false,
+  /*.max_diff = */    65536,
+  /*.working_diff = */  1,
+};
@@ -0,0 +1,17 @@
+#ifndef DEVICE_SIM_H
+#define DEVICE_SIM_H
+
+#include "miner.h"
+
+extern char *set_sim_hashrate(const char *arg);
+
+extern int opt_sim_devices;
+extern double opt_sim_hashrate;
+extern int opt_sim_latency;
+
+extern struct device_drv sim_drv;
+
+/* Log the totals of the run, once, when sgminer shuts down */
+extern void sim_report(void);
+
+#endif /* DEVICE_SIM_H */
@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <pthread.h>
 #include <string.h>
+#include <sched.h>
 
 #include "findnonce.h"
 #include "algorithm/scrypt.h"
@@ -167,68 +168,224 @@ void precalc_hash(dev_blk_ctx *blk, uint32_t *state, uint32_t *data)
 
 #endif
 
+/* Nonces reported by a kernel pass are verified on a small pool of worker
+ * threads. Every worker owns a bounded ring that the mining threads push jobs
+ * into without taking a lock; a slot's sequence number tells producers
+ * whether it is free and the worker whether it has been filled. */
+#define VERIFY_RING_SIZE 64
+#define VERIFY_LATE_MS 1000
+
 struct pc_data {
   struct thr_info *thr;
   struct work *work;
   uint32_t res[MAXBUFFERS];
+  struct timeval tv_queued;
+};
+
+struct pc_slot {
+  unsigned int seq;
+  struct pc_data pcd;
+};
+
+struct pc_worker {
+  struct pc_slot ring[VERIFY_RING_SIZE];
+  unsigned int head;
+  unsigned int tail;
+  cgsem_t sem;
   pthread_t pth;
-  int found;
 };
 
-static void *postcalc_hash(void *userdata)
+int opt_verify_threads = 2;
+
+static struct pc_worker *pc_workers;
+static int pc_nworkers;
+static pthread_once_t pc_once = PTHREAD_ONCE_INIT;
+
+static pthread_mutex_t verify_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct verify_stats verify_stats;
+
+static void postcalc_hash(struct pc_data *pcd)
 {
-  struct pc_data *pcd = (struct pc_data *)userdata;
   struct thr_info *thr = pcd->thr;
+  uint32_t nonces[MAXBUFFERS];
   unsigned int entry = 0;
 
   int found = thr->cgpu->algorithm.found_idx;
-
-  pthread_detach(pthread_self());
-
-  /* To prevent corrupt values in FOUND from trying to read beyond the
-   * end of the res[] array */
-  if (unlikely(pcd->res[found] & ~found)) {
-    applog(LOG_WARNING, "%s%d: invalid nonce count - HW error",
-      thr->cgpu->drv->name, thr->cgpu->device_id);
-    hw_errors++;
-    thr->cgpu->hw_errors++;
-    pcd->res[found] &= found;
+  uint32_t count = pcd->res[found];
+
+  /* The counter lives in the slot after the last usable entry and the
+   * kernels drop the nonces that would land on or past it, so a count above
+   * it means the pass found more than the buffer holds. Check the entries
+   * that fit. */
+  if (unlikely(count > (uint32_t)found)) {
+    applog(LOG_WARNING, "%s%d: result buffer overflow (count %08x), checking the first %d results",
+      thr->cgpu->drv->name, thr->cgpu->device_id, count, found);
+    __atomic_add_fetch(&thr->cgpu->gpu_result_overflows, 1, __ATOMIC_RELAXED);
+    count = found;
   }
 
-  for (entry = 0; entry < pcd->res[found]; entry++) {
+  for (entry = 0; entry < count; entry++) {
     uint32_t nonce = pcd->res[entry];
     if (found == 0x0F)
       nonce = swab32(nonce);
 
     applog(LOG_DEBUG, "[THR%d] OCL NONCE %08x (%lu) found in slot %d (found = %d)", thr->id, nonce, nonce, entry, found);
-    submit_nonce(thr, pcd->work, nonce);
+    nonces[entry] = nonce;
   }
 
+  submit_nonces(thr, pcd->work, nonces, entry);
+
   discard_work(pcd->work);
-  free(pcd);
+}
+
+static void postcalc_job_done(struct pc_data *pcd, bool inline_job)
+{
+  struct timeval tv_now;
+  double latency;
+
+  cgtime(&tv_now);
+  latency = tdiff(&tv_now, &pcd->tv_queued) * 1000.0;
+
+  mutex_lock(&verify_stats_lock);
+  verify_stats.jobs++;
+  if (inline_job)
+    verify_stats.inline_jobs++;
+  if (latency > VERIFY_LATE_MS)
+    verify_stats.late_jobs++;
+  verify_stats.latency_total += latency;
+  if (latency > verify_stats.latency_max)
+    verify_stats.latency_max = latency;
+  mutex_unlock(&verify_stats_lock);
+}
+
+static void *postcalc_worker(void *userdata)
+{
+  struct pc_worker *worker = (struct pc_worker *)userdata;
+  struct pc_slot *slot;
+
+  RenameThread("PostCalc");
+
+  while (1) {
+    cgsem_wait(&worker->sem);
+
+    /* Another producer may have claimed an earlier slot and posted later,
+     * so wait for this slot itself to be published */
+    slot = &worker->ring[worker->tail % VERIFY_RING_SIZE];
+    while (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != worker->tail + 1)
+      sched_yield();
+    postcalc_hash(&slot->pcd);
+    postcalc_job_done(&slot->pcd, false);
+
+    __atomic_store_n(&slot->seq, worker->tail + VERIFY_RING_SIZE, __ATOMIC_RELEASE);
+    __atomic_store_n(&worker->tail, worker->tail + 1, __ATOMIC_RELEASE);
+  }
 
   return NULL;
 }
 
-void postcalc_hash_async(struct thr_info *thr, struct work *work, uint32_t *res)
+static void postcalc_init(void)
+{
+  struct pc_worker *workers;
+  int i, j;
+
+  workers = (struct pc_worker *)calloc(opt_verify_threads, sizeof(struct pc_worker));
+  if (unlikely(!workers))
+    quit(1, "Failed to calloc pc_workers");
+
+  for (i = 0; i < opt_verify_threads; i++) {
+    struct pc_worker *worker = &workers[i];
+
+    for (j = 0; j < VERIFY_RING_SIZE; j++)
+      worker->ring[j].seq = j;
+    cgsem_init(&worker->sem);
+    if (unlikely(pthread_create(&worker->pth, NULL, postcalc_worker, (void *)worker)))
+      quit(1, "Failed to create postcalc_worker thread");
+    pthread_detach(worker->pth);
+  }
+
+  pc_workers = workers;
+  __atomic_store_n(&pc_nworkers, opt_verify_threads, __ATOMIC_RELEASE);
+}
+
+/* Claims the next free slot of a worker's ring, or returns NULL when the
+ * worker is VERIFY_RING_SIZE jobs behind */
+static struct pc_slot *postcalc_claim(struct pc_worker *worker, unsigned int *pos)
 {
-	
-  struct pc_data *pcd = (struct pc_data *)malloc(sizeof(struct pc_data));
-  int buffersize;
+  struct pc_slot *slot;
+  unsigned int seq;
+
+  *pos = __atomic_load_n(&worker->head, __ATOMIC_RELAXED);
+  while (1) {
+    slot = &worker->ring[*pos % VERIFY_RING_SIZE];
+    seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+
+    if (seq == *pos) {
+      if (__atomic_compare_exchange_n(&worker->head, pos, *pos + 1, false,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        return slot;
+      /* *pos was reloaded by the failed exchange */
+    }
+    else if ((int)(seq - *pos) < 0)
+      return NULL;
+    else
+      *pos = __atomic_load_n(&worker->head, __ATOMIC_RELAXED);
+  }
+}
 
-  if (unlikely(!pcd)) {
-    applog(LOG_ERR, "Failed to malloc pc_data in postcalc_hash_async");
+void postcalc_hash_async(struct thr_info *thr, struct work *work, uint32_t *res)
+{
+  struct pc_worker *worker;
+  struct pc_slot *slot;
+  struct pc_data pcd;
+  unsigned int pos, depth;
+
+  pthread_once(&pc_once, postcalc_init);
+
+  pcd.thr = thr;
+  pcd.work = copy_work(work);
+  memcpy(&pcd.res, res, BUFFERSIZE);
+  cgtime(&pcd.tv_queued);
+
+  /* Results of one mining thread always go to the same worker, which
+   * verifies them in the order they were found. Results verified inline
+   * below can overtake the ones still queued; nothing depends on the order,
+   * as each result is submitted on its own. */
+  worker = &pc_workers[thr->id % pc_nworkers];
+  slot = postcalc_claim(worker, &pos);
+
+  if (unlikely(!slot)) {
+    /* Backpressure: the workers can't keep up, so the mining thread
+     * verifies its own results instead of queueing more */
+    postcalc_hash(&pcd);
+    postcalc_job_done(&pcd, true);
     return;
   }
 
-  pcd->thr = thr;
-  pcd->work = copy_work(work);
-  buffersize = BUFFERSIZE;
-   memcpy(&pcd->res, res, buffersize);
+  memcpy(&slot->pcd, &pcd, sizeof(pcd));
+  __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+  cgsem_post(&worker->sem);
 
-  if (pthread_create(&pcd->pth, NULL, postcalc_hash, (void *)pcd)) {
-    applog(LOG_ERR, "Failed to create postcalc_hash thread");
-    discard_work(pcd->work);
-    free(pcd);
-  }
+  depth = pos + 1 - __atomic_load_n(&worker->tail, __ATOMIC_RELAXED);
+  mutex_lock(&verify_stats_lock);
+  if (depth > verify_stats.depth_max)
+    verify_stats.depth_max = depth;
+  mutex_unlock(&verify_stats_lock);
+}
+
+/* Copies out the verification counters along with the number of results
+ * currently waiting in the rings */
+void get_verify_stats(struct verify_stats *stats)
+{
+  unsigned int depth = 0;
+  int i, nworkers;
+
+  nworkers = __atomic_load_n(&pc_nworkers, __ATOMIC_ACQUIRE);
+  for (i = 0; i < nworkers; i++)
+    depth += __atomic_load_n(&pc_workers[i].head, __ATOMIC_RELAXED) -
+             __atomic_load_n(&pc_workers[i].tail, __ATOMIC_RELAXED);
+
+  mutex_lock(&verify_stats_lock);
+  memcpy(stats, &verify_stats, sizeof(verify_stats));
+  mutex_unlock(&verify_stats_lock);
+  stats->depth = depth;
 }
@@ -7,7 +7,26 @@
 #define MAXBUFFERS (0x100)
 #define BUFFERSIZE (sizeof(uint32_t) * MAXBUFFERS)
 
+/* The kernels keep their found counter at a fixed slot inside the first
+ * MAXBUFFERS words and only store a nonce whose index is below that slot,
+ * so a pass that finds more than fits leaves the counter past the slot
+ * rather than writing over it. */
+#define OUTPUTBUFSIZE BUFFERSIZE
+
+struct verify_stats {
+  unsigned int depth;       /* results waiting to be verified */
+  unsigned int depth_max;
+  uint64_t jobs;
+  uint64_t inline_jobs;     /* verified by the mining thread as the queue was full */
+  uint64_t late_jobs;       /* waited longer than VERIFY_LATE_MS */
+  double latency_total;     /* ms from queueing to verified */
+  double latency_max;
+};
+
+extern int opt_verify_threads;
+
 extern void precalc_hash(dev_blk_ctx *blk, uint32_t *state, uint32_t *data);
 extern void postcalc_hash_async(struct thr_info *thr, struct work *work, uint32_t *res);
+extern void get_verify_stats(struct verify_stats *stats);
 
 #endif /*FINDNONCE_H*/
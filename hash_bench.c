@@ -0,0 +1,337 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 3 of the License, or (at your option)
+ * any later version.  See COPYING for more details.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <jansson.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define HAVE_MALLINFO2 1
+#endif
+
+#include "miner.h"
+#include "algorithm.h"
+#include "driver-cpu.h"
+#include "bench_block.h"
+#include "hash_bench.h"
+
+#define BENCH_SECONDS 1.0   /* Per algorithm, on one thread and on all cores */
+#define BENCH_BATCH 16      /* Hashes between looking at the clock */
+#define BENCH_KAT_NONCE 0x1d2c3b4aU
+#define BENCH_KAT_LANES 15  /* Odd, so batches also hash a partial group */
+
+/* regenhash of the benchmark block with BENCH_KAT_NONCE, as work->hash in
+ * hex. Update these only for a change that is meant to alter a hash. */
+static const struct {
+  const char *algorithm;
+  const char *hash;
+} bench_vectors[] = {
+  { "ckolivas", "1705a28ff0facb6ef13f060016f8f56af653012d0f83249e31ec8fb7dfd82e1b" },
+  { "alexkarnew", "1705a28ff0facb6ef13f060016f8f56af653012d0f83249e31ec8fb7dfd82e1b" },
+  { "alexkarnold", "1705a28ff0facb6ef13f060016f8f56af653012d0f83249e31ec8fb7dfd82e1b" },
+  { "bufius", "1705a28ff0facb6ef13f060016f8f56af653012d0f83249e31ec8fb7dfd82e1b" },
+  { "psw", "1705a28ff0facb6ef13f060016f8f56af653012d0f83249e31ec8fb7dfd82e1b" },
+  { "zuikkis", "1705a28ff0facb6ef13f060016f8f56af653012d0f83249e31ec8fb7dfd82e1b" },
+  { "arebyp", "1705a28ff0facb6ef13f060016f8f56af653012d0f83249e31ec8fb7dfd82e1b" },
+  { "neoscrypt", "e79eb414d8a15cf83522c9d5fdefea8ec225728dfba4548f3cedc6dd5f4c3cb1" },
+  { "pluck", "2ce7a00f6e4e3af65cb84a3fd52d0bc66bef15de444b8034ec095786e481a8ab" },
+  { "credits", "a8f181b089b95f731be1fd9633adaf6fef8140f3dcca19b76cb4a10b814f7928" },
+  { "decred", "5f8549f188020def41accf2f1ade925875b52653540d78fbb68dafd2328d6f81" },
+  { "yescrypt", "f3ceb96c50455a961fffd6e86cea4de8fd5887b1b810dff1d7a3eb0bbda052a4" },
+  { "yescrypt-multi", "f3ceb96c50455a961fffd6e86cea4de8fd5887b1b810dff1d7a3eb0bbda052a4" },
+  { "quarkcoin", "695821f3e027fe73d4f97aea13479a8ca46603043bbdd527bc31abf0b73e3cb8" },
+  { "qubitcoin", "de7f5d833aec501bbe0dd766eab07366050211d47652b5391c70999238a76700" },
+  { "animecoin", "7a6dabf3fc2458745670240d488d657aa62555011d65188bbb099cbf04b3e5d1" },
+  { "sifcoin", "bca0a87de7c4b053b744d96cbb3a468261580cfcbeeccdab50feea51f552afa5" },
+  { "darkcoin", "2f91b6f2d2126bab95cf43851b90a3ccf684d0d31eef42f3d0ff58c7f92159df" },
+  { "sibcoin", "5b12929897cba7e306e0cd19265928be5980bbfc4f90493d40bbbd525996c61c" },
+  { "inkcoin", "b8f2d51ef15bd228770617336d4df83e7b7ad7f8691201937ff7f211fe3e46ac" },
+  { "myriadcoin-groestl", "c95bce50d00f597fa84cae16957571055098def71a3c686a451da6078463ff3b" },
+  { "twecoin", "236b5c5f0a057af65f1cf4709339ee9911a3c1b9488c1599fb74b3747625d52f" },
+  { "maxcoin", "7824344491247e72387de71a785750b4ca3f95777f20e42baa091078fb40add8" },
+  { "darkcoin-mod", "2f91b6f2d2126bab95cf43851b90a3ccf684d0d31eef42f3d0ff58c7f92159df" },
+  { "sibcoin-mod", "5b12929897cba7e306e0cd19265928be5980bbfc4f90493d40bbbd525996c61c" },
+  { "marucoin", "6bb670d179854bc66d061c59edda584d97cb1f425e0997cad7e6fa4b6bf3d514" },
+  { "marucoin-mod", "6bb670d179854bc66d061c59edda584d97cb1f425e0997cad7e6fa4b6bf3d514" },
+  { "marucoin-modold", "6bb670d179854bc66d061c59edda584d97cb1f425e0997cad7e6fa4b6bf3d514" },
+  { "x14", "4cbaacd589e57146d9835daca1dce9a2e5fc08675989856c9667adf69ddcfc36" },
+  { "x14old", "4cbaacd589e57146d9835daca1dce9a2e5fc08675989856c9667adf69ddcfc36" },
+  { "bitblock", "a476f13b86f7136f7948fccbf2b67cf8c64d7e9b1256d4b96b495cb7e97dc1aa" },
+  { "bitblockold", "a476f13b86f7136f7948fccbf2b67cf8c64d7e9b1256d4b96b495cb7e97dc1aa" },
+  { "talkcoin-mod", "3812fbd42144d1c8e527b75b8006b87cf620d4ba51cf4b586035789f1c03bd53" },
+  { "fresh", "762fcf46a512cad6930b549ff8cc87526aef02886ad2be602ae9b7757bc74548" },
+  { "lyra2re", "0e27c53c277dfeaafb406d2eca51d76944c408ddffb0f57534f63b2419d4248a" },
+  { "lyra2rev2", "8cb836be6cf7f004439bafda278346a1d348dc1c65e4f45ee4fb6c54680016b6" },
+  { "fuguecoin", "e8b59da05df2e2c39cf88ec88bfff10e9456ada489a7ef6c9d9de4717fdbe7d6" },
+  { "groestlcoin", "2476006e5500f2b412b1a756d49573e52ea2f13aabf7a19372aea9d8ca1765f8" },
+  { "diamond", "2476006e5500f2b412b1a756d49573e52ea2f13aabf7a19372aea9d8ca1765f8" },
+  { "whirlcoin", "532b1cc40c251b3c5b79f891451f7a44d8d774e339b84c500926c44a91220fd9" },
+  { "whirlpoolx", "ee05d027d80ef2bbd5e5124107ba9305651f2042d1f3a63b30753f00fa267053" },
+  { "blake256r8", "282ed26eb0fd32b7f8c45739d4f5957b5da35c6644bc86e0438065023afdb7e6" },
+  { "blake256r14", "1f28ad764d52d8e8eb8806e5c9240a923b878246ecd9f3406084017a086afb94" },
+  { "sia", "397da7dfbf71e0694df89e333589b74dddf077a500469ff319ea044c4c438caa" },
+  { "vanilla", "282ed26eb0fd32b7f8c45739d4f5957b5da35c6644bc86e0438065023afdb7e6" },
+  { "lbry", "48ac4b7dabd21b4a781d6fbd5d83eabc6048f75b5914d0b17276e5d5940f113a" },
+  { "pascal", "6bded83376c3d01d81d85a53cb5eedd7ead5b73590216b8c4dbed0811fcf2119" },
+  { NULL, NULL }
+};
+
+struct bench_thread {
+  pthread_t pth;
+  struct pool *pool;
+  uint32_t first;
+  uint32_t step;
+  uint64_t hashes;
+  double elapsed;
+};
+
+bool opt_hash_bench;
+
+static const unsigned char bench_block[] = { SGMINER_BENCHMARK_BLOCK };
+
+static void bench_work_init(struct work *work, struct pool *pool)
+{
+  memset(work, 0, sizeof(*work));
+  memcpy(work->data, bench_block, MIN(sizeof(work->data), sizeof(bench_block)));
+  work->pool = pool;
+  if (pool->algorithm.calc_midstate)
+    pool->algorithm.calc_midstate(work);
+}
+
+static long long heap_in_use(void)
+{
+#ifdef HAVE_MALLINFO2
+  struct mallinfo2 mi = mallinfo2();
+
+  return (long long)(mi.uordblks + mi.hblkhd);
+#else
+  return -1;
+#endif
+}
+
+static void *bench_thread(void *userdata)
+{
+  struct bench_thread *bt = (struct bench_thread *)userdata;
+  void (*regenhash)(struct work *) = bt->pool->algorithm.regenhash;
+  struct timeval start, now;
+  struct work work;
+  uint32_t nonce = bt->first;
+  int i;
+
+  bench_work_init(&work, bt->pool);
+
+  cgtime(&start);
+  do {
+    for (i = 0; i < BENCH_BATCH; i++) {
+      set_work_nonce(&work, nonce);
+      regenhash(&work);
+      nonce += bt->step;
+    }
+    bt->hashes += BENCH_BATCH;
+    cgtime(&now);
+  } while (tdiff(&now, &start) < BENCH_SECONDS);
+  bt->elapsed = tdiff(&now, &start);
+
+  return NULL;
+}
+
+/* Hash nonces i, i + threads, ... on thread i of threads for BENCH_SECONDS,
+ * returning the total number of hashes and the time taken */
+static uint64_t bench_run(struct pool *pool, int threads, double *elapsed)
+{
+  struct bench_thread *bt;
+  uint64_t hashes = 0;
+  int i;
+
+  bt = (struct bench_thread *)calloc(threads, sizeof(*bt));
+  if (unlikely(!bt))
+    quit(1, "Failed to calloc in bench_run");
+
+  for (i = 0; i < threads; i++) {
+    bt[i].pool = pool;
+    bt[i].first = i;
+    bt[i].step = threads;
+  }
+
+  for (i = 0; i < threads; i++) {
+    if (unlikely(pthread_create(&bt[i].pth, NULL, bench_thread, &bt[i])))
+      quit(1, "Failed to create benchmark thread");
+  }
+  for (i = 0; i < threads; i++)
+    pthread_join(bt[i].pth, NULL);
+
+  *elapsed = 0;
+  for (i = 0; i < threads; i++) {
+    hashes += bt[i].hashes;
+    if (bt[i].elapsed > *elapsed)
+      *elapsed = bt[i].elapsed;
+  }
+  free(bt);
+
+  return hashes;
+}
+
+static const char *find_vector(const char *algorithm)
+{
+  int i;
+
+  for (i = 0; bench_vectors[i].algorithm; i++)
+    if (!strcmp(bench_vectors[i].algorithm, algorithm))
+      return bench_vectors[i].hash;
+  return NULL;
+}
+
+static json_t *bench_result(uint64_t hashes, double elapsed, int threads)
+{
+  json_t *val = json_object();
+
+  json_object_set_new(val, "threads", json_integer(threads));
+  json_object_set_new(val, "hashes", json_integer(hashes));
+  json_object_set_new(val, "seconds", json_real(elapsed));
+  json_object_set_new(val, "hashrate", json_real(hashes / elapsed));
+  json_object_set_new(val, "ns_per_hash", json_real(elapsed * 1e9 * threads / hashes));
+  return val;
+}
+
+/* Hash BENCH_KAT_LANES nonces, the first of them BENCH_KAT_NONCE, in one
+ * regenhash_batch call and check every lane against regenhash. Returns the
+ * first lane that differs, -1 if none does. */
+static int check_batch(struct pool *pool)
+{
+  uint32_t nonces[BENCH_KAT_LANES];
+  unsigned char hashes[BENCH_KAT_LANES * 32];
+  struct work work;
+  int i;
+
+  for (i = 0; i < BENCH_KAT_LANES; i++)
+    nonces[i] = BENCH_KAT_NONCE + i * 0x01010101U;
+
+  bench_work_init(&work, pool);
+  pool->algorithm.regenhash_batch(&work, nonces, hashes, BENCH_KAT_LANES);
+  for (i = 0; i < BENCH_KAT_LANES; i++) {
+    set_work_nonce(&work, nonces[i]);
+    pool->algorithm.regenhash(&work);
+    if (memcmp(work.hash, hashes + i * 32, 32))
+      return i;
+  }
+
+  return -1;
+}
+
+/* Returns false if the algorithm has a known answer that it does not give,
+ * or a batch hash that regenhash does not agree with */
+static bool bench_algorithm(const char *name, int cores, json_t *results)
+{
+  struct bench_thread single_bt;
+  struct pool *pool;
+  struct work work;
+  const char *expected;
+  char *hash;
+  json_t *val, *single;
+  uint64_t hashes;
+  double elapsed;
+  long long heap_before, heap_after;
+  bool ok = true;
+
+  pool = (struct pool *)calloc(1, sizeof(*pool));
+  if (unlikely(!pool))
+    quit(1, "Failed to calloc in bench_algorithm");
+  set_algorithm(&pool->algorithm, name);
+
+  bench_work_init(&work, pool);
+  set_work_nonce(&work, BENCH_KAT_NONCE);
+  pool->algorithm.regenhash(&work);
+  hash = bin2hex(work.hash, sizeof(work.hash));
+  expected = find_vector(name);
+
+  val = json_object();
+  json_object_set_new(val, "algorithm", json_string(name));
+  json_object_set_new(val, "hash", json_string(hash));
+  if (!expected)
+    json_object_set_new(val, "kat", json_string("none"));
+  else if (!strcmp(expected, hash))
+    json_object_set_new(val, "kat", json_string("pass"));
+  else {
+    json_object_set_new(val, "kat", json_string("fail"));
+    json_object_set_new(val, "expected", json_string(expected));
+    applog(LOG_ERR, "%s: hash %s, expected %s", name, hash, expected);
+    ok = false;
+  }
+  free(hash);
+
+  if (pool->algorithm.regenhash_batch) {
+    int lane = check_batch(pool);
+
+    json_object_set_new(val, "batch", json_string(lane < 0 ? "pass" : "fail"));
+    if (lane >= 0) {
+      applog(LOG_ERR, "%s: batch hash of lane %d differs from regenhash", name, lane);
+      ok = false;
+    }
+  }
+  else
+    json_object_set_new(val, "batch", json_string("none"));
+
+  /* Run on this thread so that nothing but the hash allocates in between.
+   * Memory that it keeps between calls, or leaks, shows up as growth. */
+  memset(&single_bt, 0, sizeof(single_bt));
+  single_bt.pool = pool;
+  single_bt.step = 1;
+  heap_before = heap_in_use();
+  bench_thread(&single_bt);
+  heap_after = heap_in_use();
+  single = bench_result(single_bt.hashes, single_bt.elapsed, 1);
+  if (heap_before >= 0)
+    json_object_set_new(single, "heap_growth", json_integer(heap_after - heap_before));
+  json_object_set_new(val, "single", single);
+  applog(LOG_NOTICE, "%s: %.0f H/s on one thread", name, single_bt.hashes / single_bt.elapsed);
+
+  hashes = bench_run(pool, cores, &elapsed);
+  json_object_set_new(val, "all", bench_result(hashes, elapsed, cores));
+  applog(LOG_NOTICE, "%s: %.0f H/s on %d threads", name, hashes / elapsed, cores);
+
+  json_array_append_new(results, val);
+  free(pool);
+
+  return ok;
+}
+
+int hash_bench(void)
+{
+  json_t *root, *results;
+  const char *name;
+  char *out;
+  int cores = cpu_core_count();
+  int i, failed = 0;
+
+  root = json_object();
+  results = json_array();
+
+  for (i = 0; (name = get_algorithm_name(i)); i++) {
+    if (!bench_algorithm(name, cores, results))
+      failed++;
+  }
+
+  json_object_set_new(root, "cores", json_integer(cores));
+  json_object_set_new(root, "seconds", json_real(BENCH_SECONDS));
+  json_object_set_new(root, "kat_nonce", json_integer(BENCH_KAT_NONCE));
+  json_object_set_new(root, "failed", json_integer(failed));
+  json_object_set_new(root, "algorithms", results);
+
+  out = json_dumps(root, JSON_PRESERVE_ORDER | JSON_INDENT(2));
+  printf("%s\n", out);
+  free(out);
+  json_decref(root);
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,13 @@
+#ifndef HASH_BENCH_H
+#define HASH_BENCH_H
+
+#include <stdbool.h>
+
+extern bool opt_hash_bench;
+
+/* Check every algorithm's regenhash against its known answer and time it on
+ * one thread and on all cores, printing the results as JSON on stdout.
+ * Returns the process exit code, non zero if any known answer failed. */
+extern int hash_bench(void);
+
+#endif /* HASH_BENCH_H */
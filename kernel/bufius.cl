@@ -664,7 +664,7 @@ void scrypt_core(uint4 X[8], __global uint4* const restrict lookup)
 
 #pragma OPENCL EXTENSION cl_khr_global_int32_base_atomics : enable
 #define SCRYPT_FOUND (0xFF)
-#define SETFOUND(Xnonce) output[atomic_add(&output[SCRYPT_FOUND], 1)] = Xnonce;
+#define SETFOUND(Xnonce) do { uint slot = atomic_add(&output[SCRYPT_FOUND], 1); if (slot < SCRYPT_FOUND) output[slot] = Xnonce; } while (0)
 
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __attribute__((max_work_group_size(WORKSIZE, 1, 1)))
@@ -839,7 +839,7 @@ void scrypt_core(uint4 X[8], __global uint4*restrict lookup)
 }
 
 #define FOUND (0xFF)
-#define SETFOUND(Xnonce) output[output[FOUND]++] = Xnonce
+#define SETFOUND(Xnonce) do { uint slot = atomic_inc(output + FOUND); if (slot < FOUND) output[slot] = Xnonce; } while (0)
 
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(__global const uint4 * restrict input,
@@ -225,8 +225,10 @@ __kernel void search(__global const uchar* restrict input, __global uint* restri
     in.hi = pad_state; 
 	state1 = sha256_Transform(in,H256);
 
-if (SWAP64(state1.s67) <= target)  
-		output[atomic_inc(output + 0xFF)] = nonce;
+if (SWAP64(state1.s67) <= target) {
+		uint slot = atomic_inc(output + 0xFF);
+		if (slot < 0xFF) output[slot] = nonce;
+}
 
 }
 
@@ -15,12 +15,14 @@
  * GTX 960 | (5s):875.0M (avg):899.2Mh/s
  * GTX 750 | (5s):523.1M (avg):536.8Mh/s
  */
-#define ROTR(v,n) rotate(v,(uint)(32U-n))
+#include "vector_helper.cl"
+
+#define ROTR(v,n) rotate(v,(uintv)(32U-n))
 #define ROTL(v,n) rotate(v, n)
 
-#ifdef _AMD_OPENCL
-#define SWAP(v)   rotate(v, 16U)
-#define ROTR8(v)  rotate(v, 24U)
+#if defined(_AMD_OPENCL) || VECTORS > 1
+#define SWAP(v)   rotate(v, (uintv)16U)
+#define ROTR8(v)  rotate(v, (uintv)24U)
 #else
 #define SWAP(v)  as_uint(as_uchar4(v).zwxy)
 #define ROTR8(v) as_uint(as_uchar4(v).yzwx)
@@ -56,7 +58,7 @@ __kernel void search(
 )
 {
 	/* Load the block header and padding */
-	const uint M3 = get_global_id(0);
+	const uintv M3 = VNONCE;
 	const uint MD = 0x80000001UL;
 	const uint ME = 0x00000000UL;
 	const uint MF = 0x000005a0UL;
@@ -78,8 +80,8 @@ __kernel void search(
 	const uint cstE = 0x3F84D5B5UL;
 	const uint cstF = 0xB5470917UL;
 
-	uint V0, V1, V2, V3, V4, V5, V6, V7;
-	uint V8, V9, VA, VB, VC, VD, VE, VF;
+	uintv V0, V1, V2, V3, V4, V5, V6, V7;
+	uintv V8, V9, VA, VB, VC, VD, VE, VF;
 	uint pre7;
 
 	/* Load the midstate and initialize */
@@ -90,14 +92,14 @@ __kernel void search(
 	V4 = h4;
 	V5 = h5;
 	V6 = h6;
-	pre7 = V7 = h7;
+	V7 = pre7 = h7;
 
 	V8 = cst0;
 	V9 = cst1;
 	VA = cst2;
 	VB = cst3;
-	VC = 0xA4093D82UL;
-	VD = 0x299F3470UL;
+	VC = 0xA4093D82U;
+	VD = 0x299F3470U;
 	VE = cst6;
 	VF = cst7;
 
@@ -154,8 +156,12 @@ __kernel void search(
 	}
 	*/
 
-	if (pre7 ^ V7 ^ VF) return;
+	uintv result = pre7 ^ V7 ^ VF;
 
-	/* Push this share */
-	output[output[0xFF]++] = M3;
+	/* Push the shares */
+	for (uint i = 0; i < VECTORS; i++)
+		if (!VLANE(result, i)) {
+			uint slot = atomic_inc(output + 0xFF);
+			if (slot < 0xFF) output[slot] = VLANE(M3, i);
+		}
 }
@@ -589,8 +589,10 @@ __kernel void search4(__global hash_t* hashes, __global uint* output, const ulon
   Vb31 ^= hash->h8[7] ^ W31 ^ WB1;
 
   bool result = (Vb11 <= target);
-  if (result)
-      output[output[0xFF]++] = SWAP4(gid);
+  if (result) {
+      uint slot = atomic_inc(output + 0xFF);
+      if (slot < 0xFF) output[slot] = SWAP4(gid);
+  }
 }
 
 #endif // FRESH_CL
\ No newline at end of file
@@ -222,8 +222,10 @@ __kernel void search(__global unsigned char* input, volatile __global uint* outp
   S16 ^= S01;
 
   bool result = ((((sph_u64) SWAP4(S19) << 32) | SWAP4(S18)) <= target);
-  if (result)
-    output[output[0xFF]++] = SWAP4(gid);
+  if (result) {
+    uint slot = atomic_inc(output + 0xFF);
+    if (slot < 0xFF) output[slot] = SWAP4(gid);
+  }
 }
 
 #endif // FUGUECOIN_CL
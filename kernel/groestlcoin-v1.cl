@@ -1847,7 +1847,7 @@ round:
   goto perm;
 
 end:
-  if ((g[3 + 8] ^ m[3]) <= target) output[output[0xFF]++] = as_uint(as_uchar4(gid).wzyx);
+  if ((g[3 + 8] ^ m[3]) <= target) { uint slot = atomic_inc(output + 0xFF); if (slot < 0xFF) output[slot] = as_uint(as_uchar4(gid).wzyx); }
 }
 
 #endif
@@ -174,6 +174,8 @@ __kernel void search2(__global uint8 *ctx, __global uint *output, ulong target)
   outbuf.s6 = SWAP32(outbuf.s6);
   outbuf.s7 = SWAP32(outbuf.s7);
 
-  if(as_ulong(outbuf.s67) <= target)
-    output[atomic_inc(output+0xFF)] = SWAP32(gid);
+  if(as_ulong(outbuf.s67) <= target) {
+    uint slot = atomic_inc(output + 0xFF);
+    if (slot < 0xFF) output[slot] = SWAP32(gid);
+  }
 }
@@ -463,7 +463,8 @@ barrier(CLK_LOCAL_MEM_FENCE);
 
 	bool result = ( state[7] <= target);
 	if (result) {
-		output[atomic_inc(output + 0xFF)] = SWAP4(gid);
+		uint slot = atomic_inc(output + 0xFF);
+		if (slot < 0xFF) output[slot] = SWAP4(gid);
 	}
 }
 
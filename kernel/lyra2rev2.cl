@@ -516,7 +516,8 @@ __kernel void search6(__global uchar* hashes, __global uint* output, const ulong
 
 	bool result = ( ((ulong*)final_s)[7] <= target);
 	if (result) {
-		output[atomic_inc(output + 0xFF)] = SWAP4(gid);
+		uint slot = atomic_inc(output + 0xFF);
+		if (slot < 0xFF) output[slot] = SWAP4(gid);
 	}
 
 }
@@ -118,7 +118,7 @@ __kernel void search(__global const uint2*restrict in, __global uint*restrict ou
   keccak_block_noabsorb(ARGS_25(&state));
 
 #define FOUND (0x0F)
-#define SETFOUND(Xnonce) output[output[FOUND]++] = Xnonce
+#define SETFOUND(Xnonce) do { uint slot = atomic_inc(output + FOUND); if (slot < FOUND) output[slot] = Xnonce; } while (0)
 
   if ((state3.y & 0xFFFFFFF0U) == 0)
   {
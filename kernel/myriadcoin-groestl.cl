@@ -416,8 +416,10 @@ __kernel void search(__global unsigned char* block, volatile __global uint* outp
   hash.h4[7] = SWAP4(v7 + s7);
 
   bool result = (hash.h8[3] <= target);
-  if (result)
-    output[output[0xFF]++] = SWAP4(gid);
+  if (result) {
+    uint slot = atomic_inc(output + 0xFF);
+    if (slot < 0xFF) output[slot] = SWAP4(gid);
+  }
 }
 
 #endif // MYRIADCOIN_GROESTL_CL
\ No newline at end of file
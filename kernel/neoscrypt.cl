@@ -804,7 +804,7 @@ void fastkdf2(const uchar password[80], const uchar salt[256],  __global uint* r
 		XORBytes(outbuf, B + bufidx, A, 32);
 	}*/
 	
-	if(((uint *)outbuf)[7] <= target) output[atomic_add(output + 0xFF, 1)] = get_global_id(0);
+	if(((uint *)outbuf)[7] <= target) { uint slot = atomic_add(output + 0xFF, 1); if (slot < 0xFF) output[slot] = get_global_id(0); }
 
 }
 
@@ -33,7 +33,9 @@
 #endif
 
 
-#define ROL32(x, n)  rotate(x, (uint) n)
+#include "vector_helper.cl"
+
+#define ROL32(x, n)  rotate(x, (uintv) n)
 #define SWAP32(a)    (as_uint(as_uchar4(a).wzyx))
 #define SWAP64(x) as_ulong(as_uchar8(x).s32107654)  /// hmm...
 
@@ -74,36 +76,34 @@
 #define RD14 (S1(W12) + W7 + S0(W15) + W14)
 #define RD15 (S1(W13) + W8 + S0(W0) + W15)
 
-/// generic sha transform
-inline uint8 sha256_Transform(uint16 data, uint8 state)
+/// generic sha transform, of VECTORS blocks at a time
+inline void sha256_Transform(const uintv *data, uintv *state)
 {
-	uint temp1;
-	uint8 res = state;
-	uint W0 = data.s0;
-	uint W1 = data.s1;
-	uint W2 = data.s2;
-	uint W3 = data.s3;
-	uint W4 = data.s4;
-	uint W5 = data.s5;
-	uint W6 = data.s6;
-	uint W7 = data.s7;
-	uint W8 = data.s8;
-	uint W9 = data.s9;
-	uint W10 = data.sA;
-	uint W11 = data.sB;
-	uint W12 = data.sC;
-	uint W13 = data.sD;
-	uint W14 = data.sE;
-	uint W15 = data.sF;
-
-#define v0  res.s0
-#define v1  res.s1
-#define v2  res.s2
-#define v3  res.s3
-#define v4  res.s4
-#define v5  res.s5
-#define v6  res.s6
-#define v7  res.s7
+	uintv temp1;
+	uintv v0 = state[0];
+	uintv v1 = state[1];
+	uintv v2 = state[2];
+	uintv v3 = state[3];
+	uintv v4 = state[4];
+	uintv v5 = state[5];
+	uintv v6 = state[6];
+	uintv v7 = state[7];
+	uintv W0 = data[0];
+	uintv W1 = data[1];
+	uintv W2 = data[2];
+	uintv W3 = data[3];
+	uintv W4 = data[4];
+	uintv W5 = data[5];
+	uintv W6 = data[6];
+	uintv W7 = data[7];
+	uintv W8 = data[8];
+	uintv W9 = data[9];
+	uintv W10 = data[10];
+	uintv W11 = data[11];
+	uintv W12 = data[12];
+	uintv W13 = data[13];
+	uintv W14 = data[14];
+	uintv W15 = data[15];
 
 	P(v0, v1, v2, v3, v4, v5, v6, v7, W0, 0x428A2F98);
 	P(v7, v0, v1, v2, v3, v4, v5, v6, W1, 0x71374491);
@@ -172,27 +172,27 @@ inline uint8 sha256_Transform(uint16 data, uint8 state)
 	P(v3, v4, v5, v6, v7, v0, v1, v2, R13, 0xA4506CEB);
 	P(v2, v3, v4, v5, v6, v7, v0, v1, RD14, 0xBEF9A3F7);
 	P(v1, v2, v3, v4, v5, v6, v7, v0, RD15, 0xC67178F2);
-#undef v0
-#undef v1
-#undef v2
-#undef v3
-#undef v4
-#undef v5
-#undef v6
-#undef v7
-	return (res + state);
+
+	state[0] += v0;
+	state[1] += v1;
+	state[2] += v2;
+	state[3] += v3;
+	state[4] += v4;
+	state[5] += v5;
+	state[6] += v6;
+	state[7] += v7;
 }
 
 
 
-static __constant  uint8 H256 = {
+static __constant uint H256[8] = {
 	0x6A09E667, 0xBB67AE85, 0x3C6EF372,
 	0xA54FF53A, 0x510E527F, 0x9B05688C,
 	0x1F83D9AB, 0x5BE0CD19
 };
 
 
-static __constant uint16 pad_data =
+static __constant uint pad_data[16] =
 {
 	0x00000000, 0x00000000, 0x80000000, 0x00000000,
 	0x00000000, 0x00000000, 0x00000000, 0x00000000,
@@ -200,7 +200,7 @@ static __constant uint16 pad_data =
 	0x00000000, 0x00000000, 0x00000000, 0x00000640
 };
 
-static __constant uint8 pad_state =
+static __constant uint pad_state[8] =
 {
 	0x80000000, 0x00000000, 0x00000000, 0x00000000,
 	0x00000000, 0x00000000, 0x00000000, 0x00000100
@@ -211,19 +211,38 @@ static __constant uint8 pad_state =
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(__global const uchar* restrict input, __global uint* restrict output,const ulong target, uint8 midstate )
 {
-	uint nonce = get_global_id(0);
-	uint16 in;
-	uint8 state1;
-	in = pad_data;
-	in.s0 = ((__global const uint *)input)[48];
-	in.s1 = nonce;
-	state1 = sha256_Transform(in, midstate);
-	in.lo = state1;
-	in.hi = pad_state;
-	state1 = sha256_Transform(in, H256);
-
-	if (as_ulong(state1.s10) <= target) {
-		output[atomic_inc(output + 0xFF)] = SWAP32(nonce);
+	uintv nonce = VNONCE;
+	uintv in[16];
+	uintv state[8];
+	uint i;
+
+	#pragma unroll
+	for (i = 0; i < 16; i++)
+		in[i] = pad_data[i];
+	in[0] = ((__global const uint *)input)[48];
+	in[1] = nonce;
+	state[0] = midstate.s0;
+	state[1] = midstate.s1;
+	state[2] = midstate.s2;
+	state[3] = midstate.s3;
+	state[4] = midstate.s4;
+	state[5] = midstate.s5;
+	state[6] = midstate.s6;
+	state[7] = midstate.s7;
+	sha256_Transform(in, state);
+	#pragma unroll
+	for (i = 0; i < 8; i++) {
+		in[i] = state[i];
+		in[i + 8] = pad_state[i];
+		state[i] = H256[i];
+	}
+	sha256_Transform(in, state);
+
+	/* as_ulong(state.s10) of each lane */
+	for (i = 0; i < VECTORS; i++) {
+		if ((((ulong)VLANE(state[0], i) << 32) | VLANE(state[1], i)) <= target) {
+			uint slot = atomic_inc(output + 0xFF);
+			if (slot < 0xFF) output[slot] = SWAP32(VLANE(nonce, i));
+		}
 	}
 }
-
@@ -452,7 +452,7 @@ __kernel void search(__global const uchar* restrict input, __global uint* restri
 	} // main loop
 
 	
-	if( ((__global uint *)hashbuffer)[7] <= (target)) {output[atomic_inc(output + 0xFF)] = SWAP32(get_global_id(0));
+	if( ((__global uint *)hashbuffer)[7] <= (target)) {uint slot = atomic_inc(output + 0xFF); if (slot < 0xFF) output[slot] = SWAP32(get_global_id(0));
 //printf("gpu hashbuffer %08x nonce %08x\n",((__global uint *)hashbuffer)[7] ,SWAP32(get_global_id(0)));
 }
 
@@ -20,6 +20,8 @@ typedef int sph_s32;
 #define SPH_64 1
 #define SPH_64_TRUE 1
 
+#include "vector_helper.cl"
+
 #define SWAP4(x) as_uint(as_uchar4(x).wzyx)
 #define SWAP8(x) as_ulong(as_uchar8(x).s76543210)
 
@@ -57,16 +59,16 @@ __constant static const uchar blake2b_sigma[12][16] = {
 	{ 14, 10, 4,  8,  9,  15, 13, 6,  1,  12, 0,  2,  11, 7,  5,  3  } };
 
 __kernel void search(__global unsigned char* block, volatile __global uint* output, const ulong target) {
-	sph_u32 gid = get_global_id(0);
+	uintv gid = VNONCE;
 
-	ulong m[16];
+	ulongv m[16];
 	m[0] = DEC64LE(block + 0);
 	m[1] = DEC64LE(block + 8);
 	m[2] = DEC64LE(block + 16);
 	m[3] = DEC64LE(block + 24);
 	m[4] = DEC64LE(block + 32);
 	m[4] &= 0xFFFFFFFF00000000;
-	m[4] ^= (gid);
+	m[4] ^= convert_ulongv(gid);
 	m[5] = DEC64LE(block + 40);
 	m[6] = DEC64LE(block + 48);
 	m[7] = DEC64LE(block + 56);
@@ -74,11 +76,27 @@ __kernel void search(__global unsigned char* block, volatile __global uint* outp
 	m[9] = DEC64LE(block + 72);
 	m[10] = m[11] = m[12] = m[13] = m[14] = m[15] = 0;
 
-	ulong v[16] = { 0x6a09e667f2bdc928, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1,
-	                0x510e527fade682d1, 0x9b05688c2b3e6c1f, 0x1f83d9abfb41bd6b, 0x5be0cd19137e2179,
-	                0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1,
-	                0x510e527fade68281, 0x9b05688c2b3e6c1f, 0xe07c265404be4294, 0x5be0cd19137e2179 };
+	const ulong iv[16] = { 0x6a09e667f2bdc928, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1,
+	                       0x510e527fade682d1, 0x9b05688c2b3e6c1f, 0x1f83d9abfb41bd6b, 0x5be0cd19137e2179,
+	                       0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1,
+	                       0x510e527fade68281, 0x9b05688c2b3e6c1f, 0xe07c265404be4294, 0x5be0cd19137e2179 };
+	ulongv v[16];
+	#pragma unroll
+	for (int i = 0; i < 16; i++)
+		v[i] = iv[i];
 
+#if VECTORS > 1
+/* The uint2 halves trick only works on a scalar ulong */
+#define G(r,i,a,b,c,d) \
+	a = a + b + m[ blake2b_sigma[r][2*i] ]; \
+	d = rotate(d ^ a, (ulongv)32UL); \
+	c = c + d; \
+	b = rotate(b ^ c, (ulongv)40UL); \
+	a = a + b + m[ blake2b_sigma[r][2*i+1] ]; \
+	d = rotate(d ^ a, (ulongv)48UL); \
+	c = c + d; \
+	b = rotate(b ^ c, (ulongv)1UL);
+#else
 #define G(r,i,a,b,c,d) \
 	a = a + b + m[ blake2b_sigma[r][2*i] ]; \
 	((uint2*)&d)[0] = ((uint2*)&d)[0].yx ^ ((uint2*)&a)[0].yx; \
@@ -88,6 +106,7 @@ __kernel void search(__global unsigned char* block, volatile __global uint* outp
 	((uint2*)&d)[0] = ror64( ((uint2*)&d)[0] ^ ((uint2*)&a)[0], 16U); \
 	c = c + d; \
     ((uint2*)&b)[0] = ror64_2( ((uint2*)&b)[0] ^ ((uint2*)&c)[0], 63U);
+#endif
 
 #define ROUND(r)                    \
 	G(r,0,v[ 0],v[ 4],v[ 8],v[12]); \
@@ -114,7 +133,10 @@ __kernel void search(__global unsigned char* block, volatile __global uint* outp
 #undef G
 #undef ROUND
 
-	bool result = (SWAP8(0x6a09e667f2bdc928 ^ v[0] ^ v[8]) <= target);
-	if (result)
-		output[output[0xFF]++] = SWAP4(gid);
+	ulongv h0 = 0x6a09e667f2bdc928UL ^ v[0] ^ v[8];
+	for (uint i = 0; i < VECTORS; i++)
+		if (SWAP8(VLANE64(h0, i)) <= target) {
+			uint slot = atomic_inc(output + 0xFF);
+			if (slot < 0xFF) output[slot] = SWAP4(VLANE(gid, i));
+		}
 }
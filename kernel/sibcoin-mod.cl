@@ -1162,8 +1162,10 @@ __kernel void search11(__global hash_t* hashes, __global uint* output, const ulo
 
   bool result = (Vb11 <= target);
 
-  if (result)
-  output[atomic_inc(output+0xFF)] = SWAP4(gid);
+  if (result) {
+  uint slot = atomic_inc(output + 0xFF);
+  if (slot < 0xFF) output[slot] = SWAP4(gid);
+  }
 }
 
 #endif// SIBCOIN_MOD_CL
\ No newline at end of file
@@ -751,8 +751,10 @@ __kernel void search(__global unsigned char* block, volatile __global uint* outp
     Vb31 ^= hash.h8[7] ^ W31 ^ WB1;
 
     bool result = (Vb11 <= target);
-    if (result)
-      output[output[0xFF]++] = SWAP4(gid);
+    if (result) {
+      uint slot = atomic_inc(output + 0xFF);
+      if (slot < 0xFF) output[slot] = SWAP4(gid);
+    }
   }
 }
 
@@ -630,8 +630,10 @@ __kernel void search(__global unsigned char* block, volatile __global uint* outp
   }
 
   bool result = (SWAP8(hash.h8[3]) <= target);
-  if (result)
-    output[output[0xFF]++] = SWAP4(gid);
+  if (result) {
+    uint slot = atomic_inc(output + 0xFF);
+    if (slot < 0xFF) output[slot] = SWAP4(gid);
+  }
 }
 
 #endif // SIFCOIN_CL
\ No newline at end of file
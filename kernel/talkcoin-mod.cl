@@ -396,8 +396,10 @@ __kernel void search4(__global hash_t* hashes, __global uint* output, const ulon
   hash.h8[7] = SWAP8(h7);
 
   bool result = (SWAP8(hash.h8[3]) <= target);
-  if (result)
-  output[atomic_inc(output+0xFF)] = SWAP4(gid);
+  if (result) {
+  uint slot = atomic_inc(output + 0xFF);
+  if (slot < 0xFF) output[slot] = SWAP4(gid);
+  }
 }
 
 #endif // TALKCOIN_MOD_CL
\ No newline at end of file
@@ -430,7 +430,9 @@ __kernel void search(__global unsigned char* block, volatile __global uint* outp
 #undef INW2
 
     bool result = ((((sph_u64) state[16] << 32) | state[15]) <= target);
-    if (result)
-      output[output[0xFF]++] = SWAP4(gid);
+    if (result) {
+      uint slot = atomic_inc(output + 0xFF);
+      if (slot < 0xFF) output[slot] = SWAP4(gid);
+    }
   }
 }
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef VECTOR_HELPER_CL
+#define VECTOR_HELPER_CL
+
+/*
+ * Helpers for kernels that hash VECTORS nonces per work item, one in each
+ * lane of a uintv. The host sets VECTORS to the vector width it picked for
+ * the device and runs global size / VECTORS work items. Lane k of work item
+ * gid hashes nonce gid + k * global size, so a pass still covers exactly
+ * one run of nonces from the global offset on, as with VECTORS 1.
+ */
+
+#if VECTORS == 4
+typedef uint4 uintv;
+typedef ulong4 ulongv;
+#define VLANES (uint4)(0U, 1U, 2U, 3U)
+#define convert_ulongv convert_ulong4
+#elif VECTORS == 2
+typedef uint2 uintv;
+typedef ulong2 ulongv;
+#define VLANES (uint2)(0U, 1U)
+#define convert_ulongv convert_ulong2
+#else
+#undef VECTORS
+#define VECTORS 1
+typedef uint uintv;
+typedef ulong ulongv;
+#define VLANES 0U
+#define convert_ulongv convert_ulong
+#endif
+
+/* The nonce of every lane */
+#define VNONCE ((uint)get_global_id(0) + VLANES * (uint)get_global_size(0))
+
+/* Lane k of a uintv or ulongv */
+#define VLANE(v, k)   (((const uint *)&(v))[k])
+#define VLANE64(v, k) (((const ulong *)&(v))[k])
+
+#endif // VECTOR_HELPER_CL
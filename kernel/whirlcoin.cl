@@ -1351,8 +1351,10 @@ __kernel void search3(__global hash_t* hashes, __global uint* output, const ulon
     __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
 
     bool result = (hash->h8[3] <= target);
-    if (result)
-        output[atomic_inc(output+0xFF)] = SWAP4(gid);
+    if (result) {
+        uint slot = atomic_inc(output + 0xFF);
+        if (slot < 0xFF) output[slot] = SWAP4(gid);
+    }
 }
 
 #endif // W_CL
\ No newline at end of file
@@ -309,7 +309,7 @@ __kernel void search(const ulong8 midstate, const ulong input0, const ulong inpu
 		Therefore, explicit OpenCL cast to uchar4, reverse bytes, and explicit cast back to uint should be quicker, not that it matters much.
 	*/
 	
-	if((midstate.s3 ^ n.s3 ^ midstate.s5 ^ n.s5) <= target) output[atomic_inc(output+0xFF)] = as_uint(as_uchar4(gid).s3210);
+	if((midstate.s3 ^ n.s3 ^ midstate.s5 ^ n.s5) <= target) { uint slot = atomic_inc(output + 0xFF); if (slot < 0xFF) output[slot] = as_uint(as_uchar4(gid).s3210); }
 }
 
 #endif	// WHIRLPOOLX_CL
\ No newline at end of file
@@ -130,12 +130,24 @@ typedef union {
   ulong h8[8];
 } hash_t;
 
-__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search(__global unsigned char* block, __global hash_t* hashes)
+/* The stages of the chain run one kernel each, unless FUSE_n is defined to
+ * run stage n in the same kernel as stage n - 1, which keeps the hash in
+ * private memory between them. Every kernel takes the same arguments. */
+#define CHAIN_KERNEL(name) \
+  __attribute__((reqd_work_group_size(WORKSIZE, 1, 1))) \
+  __kernel void name(__global unsigned char* block, __global hash_t* hashes, __global uint* output, const ulong target)
+#define CHAIN_BEGIN \
+  uint gid = get_global_id(0); \
+  __global hash_t *hashg = &(hashes[gid-get_global_offset(0)]); \
+  hash_t hashp, *hash = &hashp
+#define CHAIN_LOAD hashp = *hashg
+#define CHAIN_END *hashg = hashp
+
+CHAIN_KERNEL(search)
 {
-    uint gid = get_global_id(0);
-    __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
+  CHAIN_BEGIN;
 
+  {
   // blake
   sph_u64 H0 = SPH_C64(0x6A09E667F3BCC908), H1 = SPH_C64(0xBB67AE8584CAA73B);
   sph_u64 H2 = SPH_C64(0x3C6EF372FE94F82B), H3 = SPH_C64(0xA54FF53A5F1D36F1);
@@ -181,16 +193,20 @@ __kernel void search(__global unsigned char* block, __global hash_t* hashes)
   hash->h8[5] = H5;
   hash->h8[6] = H6;
   hash->h8[7] = H7;
-
-  barrier(CLK_GLOBAL_MEM_FENCE);
+  }
+#ifndef FUSE_1
+  CHAIN_END;
 }
+#endif
 
-__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search1(__global hash_t* hashes)
+#ifndef FUSE_1
+CHAIN_KERNEL(search1)
 {
- uint gid = get_global_id(0);
-  __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
+  CHAIN_BEGIN;
+  CHAIN_LOAD;
+#endif
 
+  {
   // bmw
   sph_u64 BMW_H[16];
 
@@ -453,15 +469,18 @@ __kernel void search1(__global hash_t* hashes)
   hash->h8[5] = SWAP8(BMW_H[13]);
   hash->h8[6] = SWAP8(BMW_H[14]);
   hash->h8[7] = SWAP8(BMW_H[15]);
-
-  barrier(CLK_GLOBAL_MEM_FENCE);
+  }
+#ifndef FUSE_2
+  CHAIN_END;
 }
+#endif
 
-__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search2(__global hash_t* hashes)
+#ifndef FUSE_2
+CHAIN_KERNEL(search2)
 {
-  uint gid = get_global_id(0);
-  __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
+  CHAIN_BEGIN;
+  CHAIN_LOAD;
+#endif
 
 #if !SPH_SMALL_FOOTPRINT_GROESTL
   __local sph_u64 T0_C[256], T1_C[256], T2_C[256], T3_C[256];
@@ -469,6 +488,7 @@ __kernel void search2(__global hash_t* hashes)
 #else
   __local sph_u64 T0_C[256], T4_C[256];
 #endif
+  {
   int init = get_local_id(0);
   int step = get_local_size(0);
 
@@ -486,6 +506,7 @@ __kernel void search2(__global hash_t* hashes)
 #endif
   }
   barrier(CLK_LOCAL_MEM_FENCE);    // groestl
+  }
 #define T0 T0_C
 #define T1 T1_C
 #define T2 T2_C
@@ -494,8 +515,7 @@ __kernel void search2(__global hash_t* hashes)
 #define T5 T5_C
 #define T6 T6_C
 #define T7 T7_C
-
-
+  {
   sph_u64 H[16];
 //#pragma unroll 15
   for (unsigned int u = 0; u < 15; u ++)
@@ -547,16 +567,20 @@ __kernel void search2(__global hash_t* hashes)
 //#pragma unroll 8
   for (unsigned int u = 0; u < 8; u ++)
     hash->h8[u] = DEC64E(H[u + 8]);
-    barrier(CLK_GLOBAL_MEM_FENCE);
-
+  }
+#ifndef FUSE_3
+  CHAIN_END;
 }
+#endif
 
-__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search3(__global hash_t* hashes)
+#ifndef FUSE_3
+CHAIN_KERNEL(search3)
 {
-  uint gid = get_global_id(0);
-  __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
+  CHAIN_BEGIN;
+  CHAIN_LOAD;
+#endif
 
+  {
   // skein
 
   sph_u64 h0 = SPH_C64(0x4903ADFF749C51CE), h1 = SPH_C64(0x0D95DE399746DF03), h2 = SPH_C64(0x8FD1934127C79BCE), h3 = SPH_C64(0x9A255629FF352CB1), h4 = SPH_C64(0x5DB62599DF6CA7B0), h5 = SPH_C64(0xEABE394CA9D5C3F4), h6 = SPH_C64(0x991112C71A75B523), h7 = SPH_C64(0xAE18A40B660FCC33);
@@ -587,16 +611,20 @@ __kernel void search3(__global hash_t* hashes)
   hash->h8[5] = SWAP8(h5);
   hash->h8[6] = SWAP8(h6);
   hash->h8[7] = SWAP8(h7);
-
-  barrier(CLK_GLOBAL_MEM_FENCE);
+  }
+#ifndef FUSE_4
+  CHAIN_END;
 }
+#endif
 
-__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search4(__global hash_t* hashes)
+#ifndef FUSE_4
+CHAIN_KERNEL(search4)
 {
-  uint gid = get_global_id(0);
-  __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
+  CHAIN_BEGIN;
+  CHAIN_LOAD;
+#endif
 
+  {
   // jh
 
   sph_u64 h0h = C64e(0x6fd14b963e00aa17), h0l = C64e(0x636a2e057a15d543), h1h = C64e(0x8a225e8d0c97ef0b), h1l = C64e(0xe9341259f2b3c361), h2h = C64e(0x891da0c1536f801e), h2l = C64e(0x2aa9056bea2b6d80), h3h = C64e(0x588eccdb2075baa6), h3l = C64e(0xa90f3a76baf83bf7);
@@ -643,16 +671,20 @@ __kernel void search4(__global hash_t* hashes)
   hash->h8[5] = DEC64E(h6l);
   hash->h8[6] = DEC64E(h7h);
   hash->h8[7] = DEC64E(h7l);
-
-  barrier(CLK_GLOBAL_MEM_FENCE);
+  }
+#ifndef FUSE_5
+  CHAIN_END;
 }
+#endif
 
-__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search5(__global hash_t* hashes)
+#ifndef FUSE_5
+CHAIN_KERNEL(search5)
 {
-  uint gid = get_global_id(0);
-  __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
+  CHAIN_BEGIN;
+  CHAIN_LOAD;
+#endif
 
+  {
   // keccak
 
   sph_u64 a00 = 0, a01 = 0, a02 = 0, a03 = 0, a04 = 0;
@@ -691,16 +723,20 @@ __kernel void search5(__global hash_t* hashes)
   hash->h8[5] = SWAP8(a01);
   hash->h8[6] = SWAP8(a11);
   hash->h8[7] = SWAP8(a21);
-
-  barrier(CLK_GLOBAL_MEM_FENCE);
+  }
+#ifndef FUSE_6
+  CHAIN_END;
 }
+#endif
 
-__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search6(__global hash_t* hashes)
+#ifndef FUSE_6
+CHAIN_KERNEL(search6)
 {
-  uint gid = get_global_id(0);
-  __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
+  CHAIN_BEGIN;
+  CHAIN_LOAD;
+#endif
 
+  {
   // luffa
 
   sph_u32 V00 = SPH_C32(0x6d251e69), V01 = SPH_C32(0x44b051e0), V02 = SPH_C32(0x4eaa6fb4), V03 = SPH_C32(0xdbf78465), V04 = SPH_C32(0x6e292011), V05 = SPH_C32(0x90152df4), V06 = SPH_C32(0xee058139), V07 = SPH_C32(0xdef610bb);
@@ -764,16 +800,20 @@ __kernel void search6(__global hash_t* hashes)
   hash->h4[12] = V05 ^ V15 ^ V25 ^ V35 ^ V45;
   hash->h4[15] = V06 ^ V16 ^ V26 ^ V36 ^ V46;
   hash->h4[14] = V07 ^ V17 ^ V27 ^ V37 ^ V47;
-
-  barrier(CLK_GLOBAL_MEM_FENCE);
+  }
+#ifndef FUSE_7
+  CHAIN_END;
 }
+#endif
 
-__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search7(__global hash_t* hashes)
+#ifndef FUSE_7
+CHAIN_KERNEL(search7)
 {
-  uint gid = get_global_id(0);
-  __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
+  CHAIN_BEGIN;
+  CHAIN_LOAD;
+#endif
 
+  {
   // cubehash.h1
 
   sph_u32 x0 = SPH_C32(0x2AEA2A61), x1 = SPH_C32(0x50F494D4), x2 = SPH_C32(0x2D538B8B), x3 = SPH_C32(0x4167D83E);
@@ -831,18 +871,21 @@ __kernel void search7(__global hash_t* hashes)
   hash->h4[13] = xd;
   hash->h4[14] = xe;
   hash->h4[15] = xf;
-
-  barrier(CLK_GLOBAL_MEM_FENCE);
+  }
+#ifndef FUSE_8
+  CHAIN_END;
 }
+#endif
 
-__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search8(__global hash_t* hashes)
+#ifndef FUSE_8
+CHAIN_KERNEL(search8)
 {
-  uint gid = get_global_id(0);
-  __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
+  CHAIN_BEGIN;
+  CHAIN_LOAD;
+#endif
 
   __local sph_u32 AES0[256], AES1[256], AES2[256], AES3[256];
-
+  {
   int init = get_local_id(0);
   int step = get_local_size(0);
 
@@ -855,7 +898,8 @@ __kernel void search8(__global hash_t* hashes)
   }
 
   barrier(CLK_LOCAL_MEM_FENCE);
-
+  }
+  {
   // shavite
   // IV
   sph_u32 h0 = SPH_C32(0x72FCCDD8), h1 = SPH_C32(0x79CA4727), h2 = SPH_C32(0x128A077B), h3 = SPH_C32(0x40D55AEC);
@@ -911,16 +955,20 @@ __kernel void search8(__global hash_t* hashes)
   hash->h4[13] = hD;
   hash->h4[14] = hE;
   hash->h4[15] = hF;
-
-  barrier(CLK_GLOBAL_MEM_FENCE);
+  }
+#ifndef FUSE_9
+  CHAIN_END;
 }
+#endif
 
-__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search9(__global hash_t* hashes)
+#ifndef FUSE_9
+CHAIN_KERNEL(search9)
 {
-  uint gid = get_global_id(0);
-  __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
+  CHAIN_BEGIN;
+  CHAIN_LOAD;
+#endif
 
+  {
   // simd
   s32 q[256];
   unsigned char x[128];
@@ -1040,20 +1088,22 @@ __kernel void search9(__global hash_t* hashes)
   hash->h4[13] = B5;
   hash->h4[14] = B6;
   hash->h4[15] = B7;
-
-  barrier(CLK_GLOBAL_MEM_FENCE);
+  }
+#ifndef FUSE_10
+  CHAIN_END;
 }
+#endif
 
-__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search10(__global hash_t* hashes)
+#ifndef FUSE_10
+CHAIN_KERNEL(search10)
 {
-  uint gid = get_global_id(0);
-  uint offset = get_global_offset(0);
-  hash_t hash;
-  __global hash_t *hashp = &(hashes[gid-offset]);
+  CHAIN_BEGIN;
+  CHAIN_LOAD;
+#endif
 
+#if !defined(FUSE_9) || !defined(FUSE_10)
   __local sph_u32 AES0[256], AES1[256], AES2[256], AES3[256];
-
+  {
   int init = get_local_id(0);
   int step = get_local_size(0);
 
@@ -1066,10 +1116,9 @@ __kernel void search10(__global hash_t* hashes)
   }
 
   barrier(CLK_LOCAL_MEM_FENCE);
-
-  for (int i = 0; i < 8; i++)
-    hash.h8[i] = hashes[gid-offset].h8[i];
-
+  }
+#endif
+  {
   // echo
   sph_u64 W00, W01, W10, W11, W20, W21, W30, W31, W40, W41, W50, W51, W60, W61, W70, W71, W80, W81, W90, W91, WA0, WA1, WB0, WB1, WC0, WC1, WD0, WD1, WE0, WE1, WF0, WF1;
   sph_u64 Vb00, Vb01, Vb10, Vb11, Vb20, Vb21, Vb30, Vb31, Vb40, Vb41, Vb50, Vb51, Vb60, Vb61, Vb70, Vb71;
@@ -1097,14 +1146,14 @@ __kernel void search10(__global hash_t* hashes)
   W61 = Vb61;
   W70 = Vb70;
   W71 = Vb71;
-  W80 = hash.h8[0];
-  W81 = hash.h8[1];
-  W90 = hash.h8[2];
-  W91 = hash.h8[3];
-  WA0 = hash.h8[4];
-  WA1 = hash.h8[5];
-  WB0 = hash.h8[6];
-  WB1 = hash.h8[7];
+  W80 = hash->h8[0];
+  W81 = hash->h8[1];
+  W90 = hash->h8[2];
+  W91 = hash->h8[3];
+  WA0 = hash->h8[4];
+  WA1 = hash->h8[5];
+  WB0 = hash->h8[6];
+  WB1 = hash->h8[7];
   WC0 = 0x80;
   WC1 = 0;
   WD0 = 0;
@@ -1117,38 +1166,41 @@ __kernel void search10(__global hash_t* hashes)
   for (unsigned u = 0; u < 10; u ++)
     BIG_ROUND;
 
-  hashp->h8[0] = hash.h8[0] ^ Vb00 ^ W00 ^ W80;
-  hashp->h8[1] = hash.h8[1] ^ Vb01 ^ W01 ^ W81;
-  hashp->h8[2] = hash.h8[2] ^ Vb10 ^ W10 ^ W90;
-  hashp->h8[3] = hash.h8[3] ^ Vb11 ^ W11 ^ W91;
-  hashp->h8[4] = hash.h8[4] ^ Vb20 ^ W20 ^ WA0;
-  hashp->h8[5] = hash.h8[5] ^ Vb21 ^ W21 ^ WA1;
-  hashp->h8[6] = hash.h8[6] ^ Vb30 ^ W30 ^ WB0;
-  hashp->h8[7] = hash.h8[7] ^ Vb31 ^ W31 ^ WB1;
-
-  barrier(CLK_GLOBAL_MEM_FENCE);
+  hash->h8[0] = hash->h8[0] ^ Vb00 ^ W00 ^ W80;
+  hash->h8[1] = hash->h8[1] ^ Vb01 ^ W01 ^ W81;
+  hash->h8[2] = hash->h8[2] ^ Vb10 ^ W10 ^ W90;
+  hash->h8[3] = hash->h8[3] ^ Vb11 ^ W11 ^ W91;
+  hash->h8[4] = hash->h8[4] ^ Vb20 ^ W20 ^ WA0;
+  hash->h8[5] = hash->h8[5] ^ Vb21 ^ W21 ^ WA1;
+  hash->h8[6] = hash->h8[6] ^ Vb30 ^ W30 ^ WB0;
+  hash->h8[7] = hash->h8[7] ^ Vb31 ^ W31 ^ WB1;
+  }
+#ifndef FUSE_11
+  CHAIN_END;
 }
+#endif
 
-__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search11(__global hash_t* hashes)
+#ifndef FUSE_11
+CHAIN_KERNEL(search11)
 {
-  uint gid = get_global_id(0);
-  __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
+  CHAIN_BEGIN;
+  CHAIN_LOAD;
+#endif
 
   #ifdef INPUT_BIG_LOCAL
     __local sph_u32 T512_L[1024];
+  {
     __constant const sph_u32 *T512_C = &T512[0][0];
-
     int init = get_local_id(0);
     int step = get_local_size(0);
     for (int i = init; i < 1024; i += step)
       T512_L[i] = T512_C[i];
-
     barrier(CLK_LOCAL_MEM_FENCE);
+  }
   #else
     #define INPUT_BIG_LOCAL INPUT_BIG
   #endif
-
+  {
   sph_u32 c0 = HAMSI_IV512[0], c1 = HAMSI_IV512[1], c2 = HAMSI_IV512[2], c3 = HAMSI_IV512[3];
   sph_u32 c4 = HAMSI_IV512[4], c5 = HAMSI_IV512[5], c6 = HAMSI_IV512[6], c7 = HAMSI_IV512[7];
   sph_u32 c8 = HAMSI_IV512[8], c9 = HAMSI_IV512[9], cA = HAMSI_IV512[10], cB = HAMSI_IV512[11];
@@ -1182,19 +1234,22 @@ __kernel void search11(__global hash_t* hashes)
 
   for (unsigned u = 0; u < 16; u ++)
       hash->h4[u] = h[u];
-
-  barrier(CLK_GLOBAL_MEM_FENCE);
+  }
+#ifndef FUSE_12
+  CHAIN_END;
 }
+#endif
 
-__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search12(__global hash_t* hashes)
+#ifndef FUSE_12
+CHAIN_KERNEL(search12)
 {
-  uint gid = get_global_id(0);
-  uint offset = get_global_offset(0);
-  __global hash_t *hash = &(hashes[gid-offset]);
+  CHAIN_BEGIN;
+  CHAIN_LOAD;
+#endif
 
   // mixtab
   __local sph_u32 mixtab0[256], mixtab1[256], mixtab2[256], mixtab3[256];
+  {
   int init = get_local_id(0);
   int step = get_local_size(0);
   for (int i = init; i < 256; i += step)
@@ -1204,7 +1259,9 @@ __kernel void search12(__global hash_t* hashes)
     mixtab2[i] = mixtab2_c[i];
     mixtab3[i] = mixtab3_c[i];
   }
-
+  barrier(CLK_LOCAL_MEM_FENCE);
+  }
+  {
   // fugue
   sph_u32 S00, S01, S02, S03, S04, S05, S06, S07, S08, S09;
   sph_u32 S10, S11, S12, S13, S14, S15, S16, S17, S18, S19;
@@ -1285,17 +1342,20 @@ __kernel void search12(__global hash_t* hashes)
   hash->h4[13] = SWAP4(S28);
   hash->h4[14] = SWAP4(S29);
   hash->h4[15] = SWAP4(S30);
-
-  barrier(CLK_GLOBAL_MEM_FENCE);
+  }
+#ifndef FUSE_13
+  CHAIN_END;
 }
+#endif
 
-__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search13(__global hash_t* hashes, __global uint* output, const ulong target)
+#ifndef FUSE_13
+CHAIN_KERNEL(search13)
 {
-  uint gid = get_global_id(0);
-  uint offset = get_global_offset(0);
-  __global hash_t *hash = &(hashes[gid-offset]);
+  CHAIN_BEGIN;
+  CHAIN_LOAD;
+#endif
 
+  {
   // shabal
   sph_u32 A00 = A_init_512[0], A01 = A_init_512[1], A02 = A_init_512[2], A03 = A_init_512[3], A04 = A_init_512[4], A05 = A_init_512[5], A06 = A_init_512[6], A07 = A_init_512[7],
     A08 = A_init_512[8], A09 = A_init_512[9], A0A = A_init_512[10], A0B = A_init_512[11];
@@ -1362,10 +1422,11 @@ __kernel void search13(__global hash_t* hashes, __global uint* output, const ulo
 	hash->h4[15] = BF;
 
   bool result = (hash->h8[3] <= target);
-  if (result)
-    output[atomic_inc(output+0xFF)] = SWAP4(gid);
-
-  barrier(CLK_GLOBAL_MEM_FENCE);
+  if (result) {
+    uint slot = atomic_inc(output + 0xFF);
+    if (slot < 0xFF) output[slot] = SWAP4(gid);
+  }
+  }
 }
 
 #endif // X14_CL
\ No newline at end of file
@@ -1076,8 +1076,10 @@ __kernel void search10(__global hash_t* hashes, __global uint* output, const ulo
 	}
 
     bool result = (hash.h8[3] <= target);
-    if (result)
-      output[atomic_inc(output+0xFF)] = SWAP4(gid);
+    if (result) {
+      uint slot = atomic_inc(output + 0xFF);
+      if (slot < 0xFF) output[slot] = SWAP4(gid);
+    }
 
     barrier(CLK_GLOBAL_MEM_FENCE);
 }
@@ -308,7 +308,9 @@ __kernel void search4(__global const uchar* restrict input, __global uint* restr
 	res = sha256_Transform(in, H256);
 
 
-	if (SWAP32(res.s7) <= (target)) 
-		output[atomic_inc(output + 0xFF)] = (nonce);
+	if (SWAP32(res.s7) <= (target)) {
+		uint slot = atomic_inc(output + 0xFF);
+		if (slot < 0xFF) output[slot] = (nonce);
+	}
 	
 }
@@ -38,6 +38,7 @@ extern char *curly;
 #include "logging.h"
 #include "util.h"
 #include "algorithm.h"
+#include "sph/sph_sha2.h"
 
 #include <sys/types.h>
 #ifndef WIN32
@@ -233,7 +234,9 @@ static inline int fsync (int fd)
  * the *_PARSE_COMMANDS macros for each listed driver.
  */
 #define DRIVER_PARSE_COMMANDS(DRIVER_ADD_COMMAND) \
-  DRIVER_ADD_COMMAND(opencl)
+  DRIVER_ADD_COMMAND(opencl) \
+  DRIVER_ADD_COMMAND(cpu) \
+  DRIVER_ADD_COMMAND(sim)
 
 #define DRIVER_ENUM(X) DRIVER_##X,
 #define DRIVER_PROTOTYPE(X) struct device_drv X##_drv;
@@ -380,6 +383,7 @@ enum switcher_options {
   SWITCHER_APPLY_GPU_FAN = 0x2000,
   SWITCHER_APPLY_GPU_POWERTUNE = 0x4000,
   SWITCHER_APPLY_GPU_VDDC = 0x8000,
+  SWITCHER_APPLY_HW = 0xf800,   /* The ADL settings above */
   SWITCHER_SOFT_RESET = 0x4000000,
   SWITCHER_HARD_RESET = 0x8000000
 };
@@ -563,6 +567,14 @@ struct cgpu_info {
   size_t shaders;
   struct timeval tv_gpustart;
   int intervals;
+  int tune_stable;        /* Samples in a row near the target kernel time */
+  bool tune_saved;
+
+  /* Gap between one kernel pass finishing and the next being queued */
+  uint64_t gpu_passes;
+  double gpu_idle_total;  /* ms */
+  double gpu_idle_max;    /* ms */
+  uint64_t gpu_result_overflows;
 
   bool new_work;
 
@@ -1134,6 +1146,13 @@ extern bool opt_disable_client_reconnect;
 extern bool opt_restart;
 extern bool opt_worktime;
 extern int swork_id;
+
+/* Id for a new stratum request, unique across all the pools */
+static inline int next_swork_id(void)
+{
+  return __atomic_fetch_add(&swork_id, 1, __ATOMIC_RELAXED);
+}
+
 extern int opt_tcp_keepalive;
 extern bool opt_incognito;
 
@@ -1143,6 +1162,7 @@ extern bool opt_blake_compact;
 extern bool opt_luffa_parallel;
 extern int opt_hamsi_expand_big;
 extern bool opt_hamsi_short;
+extern char *opt_kernel_fuse;
 
 #if LOCK_TRACKING
 extern pthread_mutex_t lockstat_lock;
@@ -1186,8 +1206,31 @@ extern pthread_rwlock_t devices_lock;
 extern pthread_mutex_t restart_lock;
 extern pthread_cond_t restart_cond;
 
+struct staged_stats {
+  int staged;
+  int rollable;
+  uint64_t pushes;
+  uint64_t pops;
+  uint64_t pop_waits;   /* hash_pop found nothing staged and had to wait */
+  uint64_t locks;
+  uint64_t contended;   /* stgd_lock was already held by another thread */
+};
+
+struct work_slab_stats {
+  int live;             /* Work structs currently handed out */
+  int peak;
+  int depot;            /* Free work held in the global depot */
+  uint64_t allocated;   /* Work structs carved from slabs */
+  uint64_t slabs;
+  uint64_t allocs;
+  uint64_t cache_hits;  /* Allocations served by the thread's own cache */
+  uint64_t depot_hits;  /* Thread cache refills from the depot */
+};
+
 extern void clear_stratum_shares(struct pool *pool);
 extern void clear_pool_work(struct pool *pool);
+extern void get_staged_stats(struct staged_stats *stats);
+extern void get_work_slab_stats(struct work_slab_stats *stats);
 extern void set_target(unsigned char *dest_target, double diff, double diff_multiplier2, const int thr_id);
 extern void set_target_neoscrypt(unsigned char *target, double diff, const int thr_id);
 
@@ -1316,19 +1359,33 @@ enum pool_state {
   POOL_HIDDEN,
 };
 
+/* Immutable description of one stratum job, shared by reference between
+ * every work item generated from it */
+struct stratum_job {
+  int refcount;
+  char *job_id;
+  char *nonce1;
+  char *ntime;
+  double diff;
+  unsigned char target[32];
+  bool clean;
+  struct timeval tv_notify;   /* When the notify arrived */
+};
+
 struct stratum_work {
+  struct stratum_job *job;
   char *job_id;
   char *prev_hash;
   unsigned char **merkle_bin;
   char *bbversion;
   char *nbit;
   char *ntime;
-  bool clean;
 
   size_t cb_len;
   size_t header_len;
   int merkles;
   double diff;
+  struct timeval tv_notify;
 };
 
 #define RBUFSIZE 8192
@@ -1435,6 +1492,9 @@ struct pool {
   SOCKETTYPE sock;
   char *sockbuf;
   size_t sockbuf_size;
+  size_t sockbuf_head;  /* Start of unread data */
+  size_t sockbuf_tail;  /* End of received data */
+  size_t sockbuf_scan;  /* Where the next newline search resumes */
   char *sockaddr_url; /* stripped url used for sockaddr */
   char *sockaddr_proxy_url;
   char *sockaddr_proxy_port;
@@ -1448,11 +1508,14 @@ struct pool {
   bool stratum_active;
   bool stratum_init;
   bool stratum_notify;
+  bool reconnect_pending; /* client.reconnect moved the pool, restart it */
   struct stratum_work swork;
   pthread_t stratum_sthread;
   pthread_t stratum_rthread;
   pthread_mutex_t stratum_lock;
   struct thread_q *stratum_q;
+  pthread_mutex_t sshare_lock; /* Protects stratum_shares and sshares */
+  struct stratum_share *stratum_shares; /* Keyed by request id */
   int sshares; /* stratum shares submitted waiting on response */
 
   /* GBT variables */
@@ -1474,6 +1537,15 @@ struct pool {
   /* Shared by both stratum & GBT */
   unsigned char *coinbase;
   size_t nonce2_offset;
+  /* SHA-256 state of the stratum coinbase up to nonce2_offset */
+  sph_sha256_context cb_midstate;
+
+  /* Work pre-generated from the current stratum job */
+  pthread_mutex_t pregen_lock;
+  struct work **pregen;
+  int pregen_size;
+  int pregen_head;
+  int pregen_count;
   unsigned char header_bin[128];
   double next_diff;
   int merkle_offset;
@@ -1518,12 +1590,12 @@ struct work {
   bool    block;
 
   bool    stratum;
+  struct stratum_job *job;
   char    *job_id;
   uint64_t  nonce2;
   size_t    nonce2_len;
-  char    *ntime;
+  char    *ntime; /* Only set when rolled away from job->ntime */
   double    sdiff;
-  char    *nonce1;
 
   bool    gbt;
   char    *coinbase;
@@ -1531,7 +1603,7 @@ struct work {
 
   unsigned int  work_block;
   int   id;
-  UT_hash_handle  hh;
+  struct list_head staged_node;
 
   double    work_difficulty;
 
@@ -1550,6 +1622,12 @@ struct work {
   char    getwork_mode;
 };
 
+/* The ntime to submit stratum work with */
+static inline const char *stratum_work_ntime(const struct work *work)
+{
+  return work->ntime ? work->ntime : work->job->ntime;
+}
+
 #define TAILBUFSIZ 64
 
 #define tailsprintf(buf, bufsiz, fmt, ...) do { \
@@ -1564,9 +1642,11 @@ struct work {
 
 extern void get_datestamp(char *, size_t, struct timeval *);
 extern void inc_hw_errors(struct thr_info *thr);
+extern void set_work_nonce(struct work *work, uint32_t nonce);
 extern bool test_nonce(struct work *work, uint32_t nonce);
 extern bool submit_tested_work(struct thr_info *thr, struct work *work);
 extern bool submit_nonce(struct thr_info *thr, struct work *work, uint32_t nonce);
+extern int submit_nonces(struct thr_info *thr, struct work *work, const uint32_t *nonces, int count);
 extern struct work *get_work(struct thr_info *thr, const int thr_id);
 extern void _wlog(const char *str);
 extern void _wlogprint(const char *str);
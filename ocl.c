@@ -34,6 +34,7 @@
 #include "ocl.h"
 #include "ocl/build_kernel.h"
 #include "ocl/binary_kernel.h"
+#include "ocl/kernel_cache.h"
 #include "algorithm/neoscrypt.h"
 #include "algorithm/pluck.h"
 #include "algorithm/yescrypt.h"
@@ -46,6 +47,61 @@
 #include "miner.h"
 
 int opt_platform_id = -1;
+bool opt_gpu_mapped;
+cl_device_type opt_device_type = CL_DEVICE_TYPE_GPU;
+
+/* Devices are numbered by type in this order, so selecting another type
+ * never renumbers the devices of the ones already in use */
+static const cl_device_type device_type_order[] = {
+  CL_DEVICE_TYPE_GPU,
+  CL_DEVICE_TYPE_ACCELERATOR,
+  CL_DEVICE_TYPE_CPU
+};
+
+/* A rough count of the shaders of a GPU that runs well at the default
+ * intensity, used to scale intensity down for smaller CPU devices */
+#define REFERENCE_SHADERS 2048
+
+/* Context and program shared by the mining threads of one device. Each
+ * thread still has its own command queue, kernels and buffers, as kernel
+ * arguments and scratch space can not be shared between passes that run
+ * at the same time. */
+struct device_share {
+  pthread_mutex_t lock;
+  cl_context context;
+  cl_program program;
+  char key[65];   /* Kernel cache key the program was built from */
+};
+
+static struct device_share device_shares[MAX_GPUDEVICES];
+static pthread_once_t device_shares_once = PTHREAD_ONCE_INIT;
+
+static void init_device_shares(void)
+{
+  int i;
+
+  for (i = 0; i < MAX_GPUDEVICES; i++)
+    mutex_init(&device_shares[i].lock);
+}
+
+/* Stop handing out a device's context and program, so the next initCl for
+ * it starts afresh. Threads still using them hold their own references. */
+void clear_device_share(unsigned int gpu)
+{
+  struct device_share *share = &device_shares[gpu];
+
+  pthread_once(&device_shares_once, init_device_shares);
+
+  mutex_lock(&share->lock);
+  if (share->program)
+    clReleaseProgram(share->program);
+  if (share->context)
+    clReleaseContext(share->context);
+  share->program = NULL;
+  share->context = NULL;
+  share->key[0] = '\0';
+  mutex_unlock(&share->lock);
+}
 
 bool get_opencl_platform(int preferred_platform_id, cl_platform_id *platform) {
   cl_int status;
@@ -92,6 +148,40 @@ out:
 }
 
 
+/* Count the devices of the selected types and, if devices is not NULL,
+ * fill it with up to num of them. Returns -1 on error. */
+static int get_opencl_devices(cl_platform_id platform, cl_device_id *devices, cl_uint num)
+{
+  cl_uint i, n = 0;
+
+  for (i = 0; i < sizeof(device_type_order) / sizeof(device_type_order[0]); i++) {
+    cl_device_type type = device_type_order[i];
+    cl_uint found = 0;
+    cl_int status;
+
+    if (!(opt_device_type & type))
+      continue;
+
+    status = clGetDeviceIDs(platform, type, 0, NULL, &found);
+    if (status == CL_DEVICE_NOT_FOUND)
+      continue;
+    if (status != CL_SUCCESS) {
+      applog(LOG_INFO, "Error %d: Getting Device IDs (num)", status);
+      return -1;
+    }
+    if (devices && n < num && found) {
+      status = clGetDeviceIDs(platform, type, MIN(found, num - n), devices + n, NULL);
+      if (status != CL_SUCCESS) {
+        applog(LOG_ERR, "Error %d: Getting Device IDs (list)", status);
+        return -1;
+      }
+    }
+    n += found;
+  }
+
+  return n;
+}
+
 int clDevicesNum(void) {
   cl_int status;
   char pbuff[256];
@@ -116,17 +206,16 @@ int clDevicesNum(void) {
   status = clGetPlatformInfo(platform, CL_PLATFORM_VERSION, sizeof(pbuff), pbuff, NULL);
   if (status == CL_SUCCESS)
     applog(LOG_INFO, "CL Platform version: %s", pbuff);
-  status = clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 0, NULL, &numDevices);
-  if (status != CL_SUCCESS) {
-    applog(LOG_INFO, "Error %d: Getting Device IDs (num)", status);
+  if ((ret = get_opencl_devices(platform, NULL, 0)) < 0)
     goto out;
-  }
+  numDevices = ret;
+  ret = -1;
   applog(LOG_INFO, "Platform devices: %d", numDevices);
   if (numDevices) {
     unsigned int j;
     cl_device_id *devices = (cl_device_id *)malloc(numDevices*sizeof(cl_device_id));
 
-    clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, numDevices, devices, NULL);
+    get_opencl_devices(platform, devices, numDevices);
     for (j = 0; j < numDevices; j++) {
       clGetDeviceInfo(devices[j], CL_DEVICE_NAME, sizeof(pbuff), pbuff, NULL);
       applog(LOG_INFO, "\t%i\t%s", j, pbuff);
@@ -139,12 +228,25 @@ out:
   return ret;
 }
 
-static cl_int create_opencl_context(cl_context *context, cl_platform_id *platform)
+/* How many of the devices are GPUs, which are always numbered first */
+int clGPUsNum(void)
+{
+  cl_platform_id platform = NULL;
+  cl_uint num = 0;
+
+  if (!(opt_device_type & CL_DEVICE_TYPE_GPU) || !get_opencl_platform(opt_platform_id, &platform))
+    return 0;
+  if (clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 0, NULL, &num) != CL_SUCCESS)
+    return 0;
+  return num;
+}
+
+static cl_int create_opencl_context(cl_context *context, cl_platform_id *platform, cl_device_id *device)
 {
   cl_context_properties cps[3] = { CL_CONTEXT_PLATFORM, (cl_context_properties)*platform, 0 };
   cl_int status;
 
-  *context = clCreateContextFromType(cps, CL_DEVICE_TYPE_GPU, NULL, NULL, &status);
+  *context = clCreateContext(cps, 1, device, NULL, NULL, &status);
   return status;
 }
 
@@ -180,6 +282,23 @@ static cl_int create_opencl_command_queue(cl_command_queue *command_queue, cl_co
   return status;
 }
 
+/* Largest local memory any kernel of clState uses, as the compiler laid it
+ * out. A fused kernel holds the __local tables of all of its stages. */
+static cl_ulong kernel_local_mem(_clState *clState, cl_device_id device)
+{
+  cl_ulong size, max = 0;
+  unsigned int i;
+
+  for (i = 0; i <= clState->n_extra_kernels; i++) {
+    cl_kernel kernel = i ? clState->extra_kernels[i - 1] : clState->kernel;
+
+    if (clGetKernelWorkGroupInfo(kernel, device, CL_KERNEL_LOCAL_MEM_SIZE, sizeof(size), &size, NULL) == CL_SUCCESS &&
+        size > max)
+      max = size;
+  }
+  return max;
+}
+
 _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *algorithm)
 {
   cl_int status = 0;
@@ -191,6 +310,9 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
 	cl_device_id *devices = (cl_device_id *)alloca(numDevices * sizeof(cl_device_id));
 	build_kernel_data *build_data = (build_kernel_data *)alloca(sizeof(struct _build_kernel_data));
 	char **pbuff = (char **)alloca(sizeof(char *) * numDevices), filename[256];
+	struct device_share *share = &device_shares[gpu];
+	uint32_t fuse;
+	unsigned int stage;
 
   // sanity check
   if (!get_opencl_platform(opt_platform_id, &platform)) {
@@ -209,11 +331,8 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
 
   /* Now, get the device list data */
 
-  status = clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, numDevices, devices, NULL);
-  if (status != CL_SUCCESS) {
-    applog(LOG_ERR, "Error %d: Getting Device IDs (list)", status);
+  if (get_opencl_devices(platform, devices, numDevices) < 0)
     return NULL;
-  }
 
   applog(LOG_INFO, "List of devices:");
 
@@ -237,17 +356,32 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
 	applog(LOG_INFO, "Selected %d: %s", gpu, pbuff[gpu]);
   strncpy(name, pbuff[gpu], nameSize);
   
-  status = create_opencl_context(&clState->context, &platform);
-  if (status != CL_SUCCESS) {
-    applog(LOG_ERR, "Error %d: Creating Context. (clCreateContextFromType)", status);
-    return NULL;
+  pthread_once(&device_shares_once, init_device_shares);
+  mutex_lock(&share->lock);
+  if (!share->context) {
+    status = create_opencl_context(&share->context, &platform, &devices[gpu]);
+    if (status != CL_SUCCESS) {
+      share->context = NULL;
+      mutex_unlock(&share->lock);
+      applog(LOG_ERR, "Error %d: Creating Context. (clCreateContext)", status);
+      return NULL;
+    }
   }
+  clState->context = share->context;
+  clRetainContext(clState->context);
+  mutex_unlock(&share->lock);
 
   status = create_opencl_command_queue(&clState->commandQueue, &clState->context, &devices[gpu], cgpu->algorithm.cq_properties);
   if (status != CL_SUCCESS) {
     applog(LOG_ERR, "Error %d: Creating Command Queue. (clCreateCommandQueue)", status);
     return NULL;
   }
+  if (cgpu->algorithm.cq_properties & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) {
+    cl_command_queue_properties cq_properties = 0;
+
+    clGetCommandQueueInfo(clState->commandQueue, CL_QUEUE_PROPERTIES, sizeof(cq_properties), &cq_properties, NULL);
+    clState->out_of_order = (cq_properties & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) != 0;
+  }
 
   status = clGetDeviceInfo(devices[gpu], CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT, sizeof(cl_uint), (void *)&preferred_vwidth, NULL);
   if (status != CL_SUCCESS) {
@@ -268,12 +402,30 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
     applog(LOG_ERR, "Error %d: Failed to clGetDeviceInfo when trying to get CL_DEVICE_MAX_COMPUTE_UNITS", status);
     return NULL;
   }
-  // AMD architechture got 64 compute shaders per compute unit.
-  // Source: http://www.amd.com/us/Documents/GCN_Architecture_whitepaper.pdf
-  clState->compute_shaders = compute_units << 6;
-  applog(LOG_INFO, "Maximum work size for this GPU (%d) is %d.", gpu, clState->max_work_size);
-	applog(LOG_INFO, "Your GPU (#%d) has %d compute units, and all AMD cards in the 7 series or newer (GCN cards) \
+  status = clGetDeviceInfo(devices[gpu], CL_DEVICE_TYPE, sizeof(cl_device_type), (void *)&clState->device_type, NULL);
+  if (status != CL_SUCCESS) {
+    applog(LOG_ERR, "Error %d: Failed to clGetDeviceInfo when trying to get CL_DEVICE_TYPE", status);
+    return NULL;
+  }
+  if (clState->device_type & CL_DEVICE_TYPE_GPU) {
+    // AMD architechture got 64 compute shaders per compute unit.
+    // Source: http://www.amd.com/us/Documents/GCN_Architecture_whitepaper.pdf
+    clState->compute_shaders = compute_units << 6;
+    applog(LOG_INFO, "Maximum work size for this GPU (%d) is %d.", gpu, clState->max_work_size);
+    applog(LOG_INFO, "Your GPU (#%d) has %d compute units, and all AMD cards in the 7 series or newer (GCN cards) \
 		have 64 shaders per compute unit - this means it has %d shaders.", gpu, compute_units, clState->compute_shaders);
+  }
+  else {
+    size_t shaders;
+
+    // CPU runtimes report a compute unit per hardware thread, each running
+    // as many work items at once as its SIMD unit has lanes
+    clState->compute_shaders = compute_units * (preferred_vwidth ? preferred_vwidth : 1);
+    for (shaders = clState->compute_shaders; shaders < REFERENCE_SHADERS; shaders <<= 1)
+      clState->intensity_rshift++;
+    applog(LOG_INFO, "Device %d is not a GPU: %d compute units, %d shaders, intensity scaled down by %d",
+      gpu, (int)compute_units, (int)clState->compute_shaders, clState->intensity_rshift);
+  }
 
   status = clGetDeviceInfo(devices[gpu], CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(cl_ulong), (void *)&cgpu->max_alloc, NULL);
   if (status != CL_SUCCESS) {
@@ -288,31 +440,38 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
    * name + g + lg + lookup_gap + tc + thread_concurrency + nf + nfactor + w + work_size + l + sizeof(long) + .bin
    */
 
-  sprintf(filename, "%s.cl", (!empty_string(cgpu->algorithm.kernelfile) ? cgpu->algorithm.kernelfile : cgpu->algorithm.name));
+  sprintf(filename, "%s.cl", (!empty_string(cgpu->algorithm.kernelfile) ? cgpu->algorithm.kernelfile : get_algorithm_kernel(&cgpu->algorithm)));
   applog(LOG_DEBUG, "Using source file %s", filename);
 
   /* For some reason 2 vectors is still better even if the card says
    * otherwise, and many cards lie about their max so use 256 as max
-   * unless explicitly set on the command line. Tahiti prefers 1 */
+   * unless explicitly set on the command line. Tahiti prefers 1. Kernels
+   * written for 4 lanes get what the card asks for, up to their max */
   if (strstr(name, "Tahiti"))
     preferred_vwidth = 1;
-  else if (preferred_vwidth > 2)
+  else if (preferred_vwidth > 2 && cgpu->algorithm.max_vwidth < 4)
     preferred_vwidth = 2;
 
-  /* All available kernels only support vector 1 */
-  cgpu->vwidth = 1;
-
-  /* Vectors are hard-set to 1 above. */
-  if (likely(cgpu->vwidth))
+  /* Only kernels built for it hash several nonces per work item. The width
+   * is left unset on the device so another algorithm picks its own */
+  if (cgpu->vwidth)
     clState->vwidth = cgpu->vwidth;
-  else {
-    clState->vwidth = preferred_vwidth;
-    cgpu->vwidth = preferred_vwidth;
-  }
+  else
+    clState->vwidth = preferred_vwidth ? preferred_vwidth : 1;
+  if (clState->vwidth > cgpu->algorithm.max_vwidth)
+    clState->vwidth = cgpu->algorithm.max_vwidth ? cgpu->algorithm.max_vwidth : 1;
+  if (clState->vwidth > 1)
+    applog(LOG_INFO, "GPU %d: %s hashes %u nonces per work item", gpu, get_algorithm_kernel(&cgpu->algorithm), clState->vwidth);
 
   clState->goffset = true;
 
-  clState->wsize = (cgpu->work_size && cgpu->work_size <= clState->max_work_size) ? cgpu->work_size : 256;
+  if (cgpu->work_size && cgpu->work_size <= clState->max_work_size)
+    clState->wsize = cgpu->work_size;
+  else if (clState->device_type & CL_DEVICE_TYPE_GPU)
+    clState->wsize = 256;
+  else
+    /* CPU runtimes serialise a work group on one core; keep them small */
+    clState->wsize = MIN(64, clState->max_work_size);
 
   if (!cgpu->opt_lg) {
     applog(LOG_DEBUG, "GPU %d: selecting lookup gap of 2", gpu);
@@ -321,12 +480,12 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
   else
     cgpu->lookup_gap = cgpu->opt_lg;
 
-  if ((strcmp(cgpu->algorithm.name, "zuikkis") == 0) && (cgpu->lookup_gap != 2)) {
+  if ((strcmp(get_algorithm_kernel(&cgpu->algorithm), "zuikkis") == 0) && (cgpu->lookup_gap != 2)) {
     applog(LOG_WARNING, "Kernel zuikkis only supports lookup-gap = 2 (currently %d), forcing.", cgpu->lookup_gap);
     cgpu->lookup_gap = 2;
   }
 
-  if ((strcmp(cgpu->algorithm.name, "bufius") == 0) && ((cgpu->lookup_gap != 2) && (cgpu->lookup_gap != 4) && (cgpu->lookup_gap != 8))) {
+  if ((strcmp(get_algorithm_kernel(&cgpu->algorithm), "bufius") == 0) && ((cgpu->lookup_gap != 2) && (cgpu->lookup_gap != 4) && (cgpu->lookup_gap != 8))) {
     applog(LOG_WARNING, "Kernel bufius only supports lookup-gap of 2, 4 or 8 (currently %d), forcing to 2", cgpu->lookup_gap);
     cgpu->lookup_gap = 2;
   }
@@ -696,8 +855,11 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
 
   build_data->kernel_path = (*opt_kernel_path) ? opt_kernel_path : NULL;
   build_data->work_size = clState->wsize;
-  build_data->opencl_version = get_opencl_version(devices[gpu]);
+  build_data->vectors = clState->vwidth;
+  clState->opencl_version = get_opencl_version(devices[gpu]);
+  build_data->opencl_version = clState->opencl_version;
 
+build:
   strcpy(build_data->binary_filename, filename);
 	build_data->binary_filename[strlen(filename) - 3] = 0x00;		// And one NULL terminator, cutting off the .cl suffix.
 	strcat(build_data->binary_filename, pbuff[gpu]);
@@ -712,19 +874,45 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
   }
 
   strcat(build_data->binary_filename, ".bin");
+  kernel_cache_begin(build_data);
   applog(LOG_DEBUG, "Using binary file %s", build_data->binary_filename);
 
-  // Load program from file or build it if it doesn't exist
-  if (!(clState->program = load_opencl_binary_kernel(build_data))) {
-    applog(LOG_NOTICE, "Building binary %s", build_data->binary_filename);
+  mutex_lock(&share->lock);
+  if (share->program && !strcmp(share->key, build_data->cache_key)) {
+    // Another thread on this device already has it
+    applog(LOG_DEBUG, "Sharing program with the other threads of GPU %d", gpu);
+    clState->program = share->program;
+    clRetainProgram(clState->program);
+  }
+  else {
+    // Load program from file or build it if it doesn't exist
+    if (!(clState->program = load_opencl_binary_kernel(build_data))) {
+      applog(LOG_NOTICE, "Building binary %s", build_data->binary_filename);
+
+      if (!(clState->program = build_opencl_kernel(build_data, filename))) {
+        mutex_unlock(&share->lock);
+        kernel_cache_end(build_data);
+        /* Some compilers reject the local memory of a fused kernel outright */
+        if (get_algorithm_fuse_mask(algorithm)) {
+          applog(LOG_WARNING, "GPU %d: fused %s kernels failed to build, not fusing", gpu, algorithm->name);
+          algorithm->fuse_groups = NULL;
+          goto build;
+        }
+        return NULL;
+      }
 
-    if (!(clState->program = build_opencl_kernel(build_data, filename))) {
-      return NULL;
+      // If it doesn't work, oh well, build it again next run
+      save_opencl_kernel(build_data, clState->program);
     }
 
-	// If it doesn't work, oh well, build it again next run
-    save_opencl_kernel(build_data, clState->program);
+    if (share->program)
+      clReleaseProgram(share->program);
+    share->program = clState->program;
+    clRetainProgram(share->program);
+    strcpy(share->key, build_data->cache_key);
   }
+  mutex_unlock(&share->lock);
+  kernel_cache_end(build_data);
 
   // Load kernels
   applog(LOG_NOTICE, "Initialising kernel %s with nfactor %d, n %d",
@@ -737,15 +925,27 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
     return NULL;
   }
 
+  /* Fused stages have no kernel of their own, the rest keep their number */
+  fuse = get_algorithm_fuse_mask(algorithm);
   clState->n_extra_kernels = algorithm->n_extra_kernels;
+  for (stage = 1; stage <= algorithm->n_extra_kernels; stage++) {
+    if (fuse & (1U << stage))
+      clState->n_extra_kernels--;
+  }
+  if (fuse)
+    applog(LOG_INFO, "%s: %u kernel chain, fused stages 0x%x", algorithm->name,
+      (unsigned int)clState->n_extra_kernels + 1, (unsigned int)fuse);
+
   if (clState->n_extra_kernels > 0) {
     unsigned int i;
     char kernel_name[9]; // max: search99 + 0x0
 
     clState->extra_kernels = (cl_kernel *)malloc(sizeof(cl_kernel)* clState->n_extra_kernels);
 
-    for (i = 0; i < clState->n_extra_kernels; i++) {
-      snprintf(kernel_name, 9, "%s%d", "search", i + 1);
+    for (i = 0, stage = 1; i < clState->n_extra_kernels; i++, stage++) {
+      while (fuse & (1U << stage))
+        stage++;
+      snprintf(kernel_name, 9, "%s%d", "search", stage);
       clState->extra_kernels[i] = clCreateKernel(clState->program, kernel_name, &status);
       if (status != CL_SUCCESS) {
         applog(LOG_ERR, "Error %d: Creating ExtraKernel #%d from program. (clCreateKernel)", status, i);
@@ -754,6 +954,30 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
     }
   }
 
+  /* Fusing adds up the __local tables of the stages, which can outgrow the
+   * device. Build the chain unfused instead of failing every launch. */
+  if (fuse) {
+    cl_ulong local_mem = 0, used = kernel_local_mem(clState, devices[gpu]);
+
+    clGetDeviceInfo(devices[gpu], CL_DEVICE_LOCAL_MEM_SIZE, sizeof(cl_ulong), (void *)&local_mem, NULL);
+    if (local_mem && used > local_mem) {
+      unsigned int i;
+
+      applog(LOG_WARNING, "GPU %d: fused %s kernels need %lu bytes of local memory but the device has %lu, not fusing",
+        gpu, algorithm->name, (unsigned long)used, (unsigned long)local_mem);
+      for (i = 0; i < clState->n_extra_kernels; i++)
+        clReleaseKernel(clState->extra_kernels[i]);
+      free(clState->extra_kernels);
+      clState->extra_kernels = NULL;
+      clReleaseKernel(clState->kernel);
+      clReleaseProgram(clState->program);
+      /* This device's copy of the algorithm, get_algorithm_fuse_mask then
+       * returns 0 for it */
+      algorithm->fuse_groups = NULL;
+      goto build;
+    }
+  }
+
   size_t bufsize;
   size_t buf1size;
   size_t buf3size;
@@ -821,6 +1045,9 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
   }
   else {
     bufsize = (size_t)algorithm->rw_buffer_size;
+    /* A chain fused into one kernel keeps every hash in private memory */
+    if (fuse && clState->n_extra_kernels == 0)
+      bufsize = 64;
     applog(LOG_DEBUG, "Buffer sizes: %lu RW, %lu R", (unsigned long)bufsize, (unsigned long)readbufsize);
   }
 
@@ -892,8 +1119,10 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
     return NULL;
   }
 
-  applog(LOG_DEBUG, "Using output buffer sized %lu", BUFFERSIZE);
-  clState->outputBuffer = clCreateBuffer(clState->context, CL_MEM_WRITE_ONLY, BUFFERSIZE, NULL, &status);
+  applog(LOG_DEBUG, "Using output buffer sized %lu", OUTPUTBUFSIZE);
+  /* Host-allocated when mapped so results can be read without a copy */
+  clState->outputBuffer = clCreateBuffer(clState->context,
+    CL_MEM_WRITE_ONLY | (opt_gpu_mapped ? CL_MEM_ALLOC_HOST_PTR : 0), OUTPUTBUFSIZE, NULL, &status);
   if (status != CL_SUCCESS) {
     applog(LOG_ERR, "Error %d: clCreateBuffer (outputBuffer)", status);
     return NULL;
@@ -3,6 +3,8 @@
 
 #include <stdbool.h>
 
+#define MAX_OUTPUT_ARGS 4
+
 typedef struct __clState {
   cl_context context;
   cl_kernel kernel;
@@ -19,13 +21,32 @@ typedef struct __clState {
   cl_mem buffer3;
   unsigned char cldata[256];
   bool goffset;
+  float opencl_version;
   cl_uint vwidth;
   size_t max_work_size;
   size_t wsize;
   size_t compute_shaders;
+  cl_device_type device_type;
+  unsigned int intensity_rshift;  /* Intensity reduction for devices smaller than a GPU */
+  /* Kernel arguments that point at outputBuffer */
+  cl_kernel output_kernels[MAX_OUTPUT_ARGS];
+  cl_uint output_args[MAX_OUTPUT_ARGS];
+  unsigned int n_output_args;
+  /* Work the kernel arguments were last set for, and its header upload */
+  bool bound;
+  int bound_work;
+  cl_mem bound_output;
+  cl_event header_event;
+  /* Out of order queues have every command wait on the last one queued */
+  bool out_of_order;
+  cl_event tail_event;
 } _clState;
 
+extern cl_device_type opt_device_type;
+
 extern int clDevicesNum(void);
+extern int clGPUsNum(void);
 extern _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *algorithm);
+extern void clear_device_share(unsigned int gpu);
 
 #endif /* OCL_H */
@@ -0,0 +1,269 @@
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "miner.h"
+#include "autotune.h"
+
+#define TUNE_DB_NAME "gpu-tune.db"
+#define TUNE_SAMPLE_US 70000  /* Windows' timer resolution is only 15ms */
+#define TUNE_TOLERANCE 0.1    /* Close enough to the target kernel time */
+#define TUNE_STABLE_SAMPLES 3 /* In tolerance this many times to be saved */
+#define TUNE_MAX_STEP 2.0     /* Largest change to threads per sample */
+
+struct tune_entry {
+  char *device;
+  char *algorithm;
+  char *kernel;
+  int rawintensity;
+};
+
+char *opt_gpu_tune_db;
+
+extern int opt_dynamic_interval;
+
+static struct tune_entry *tune_db;
+static int tune_db_size;
+static pthread_mutex_t tune_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t update_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t tune_once = PTHREAD_ONCE_INIT;
+
+static void tune_db_path(char *filename, size_t size)
+{
+  if (!empty_string(opt_gpu_tune_db)) {
+    snprintf(filename, size, "%s", opt_gpu_tune_db);
+    return;
+  }
+
+#if defined(unix) || defined(__APPLE__)
+  if (getenv("HOME") && *getenv("HOME"))
+    snprintf(filename, size, "%s/.sgminer/", getenv("HOME"));
+  else
+    snprintf(filename, size, ".sgminer/");
+  mkdir(filename, 0777);
+#else
+  filename[0] = '\0';
+#endif
+  strncat(filename, TUNE_DB_NAME, size - strlen(filename) - 1);
+}
+
+static const char *tune_kernel(struct cgpu_info *gpu)
+{
+  return !empty_string(gpu->algorithm.kernelfile) ? gpu->algorithm.kernelfile : get_algorithm_kernel(&gpu->algorithm);
+}
+
+static struct tune_entry *find_entry(const char *device, const char *algorithm, const char *kernel)
+{
+  int i;
+
+  for (i = 0; i < tune_db_size; i++) {
+    struct tune_entry *entry = &tune_db[i];
+
+    if (!strcmp(entry->device, device) && !strcmp(entry->algorithm, algorithm) &&
+        !strcmp(entry->kernel, kernel))
+      return entry;
+  }
+  return NULL;
+}
+
+/* Must be called with tune_lock held */
+static void set_entry(const char *device, const char *algorithm, const char *kernel, int rawintensity)
+{
+  struct tune_entry *entry = find_entry(device, algorithm, kernel);
+
+  if (!entry) {
+    tune_db = (struct tune_entry *)realloc(tune_db, sizeof(*tune_db) * (tune_db_size + 1));
+    if (unlikely(!tune_db))
+      quit(1, "Failed to realloc tune_db in set_entry");
+    entry = &tune_db[tune_db_size++];
+    entry->device = strdup(device);
+    entry->algorithm = strdup(algorithm);
+    entry->kernel = strdup(kernel);
+  }
+  entry->rawintensity = rawintensity;
+}
+
+/* One line per setting: device, algorithm, kernel and raw intensity,
+ * separated by tabs */
+static void load_tune_db(void)
+{
+  char filename[PATH_MAX], line[512];
+  FILE *fp;
+
+  tune_db_path(filename, sizeof(filename));
+  fp = fopen(filename, "r");
+  if (!fp) {
+    applog(LOG_DEBUG, "No GPU tuning database at %s", filename);
+    return;
+  }
+
+  mutex_lock(&tune_lock);
+  while (fgets(line, sizeof(line), fp)) {
+    char *fields[4], *p;
+    int n, raw;
+
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] == '#' || line[0] == '\0')
+      continue;
+
+    fields[0] = line;
+    for (n = 1; n < 4; n++) {
+      if (!(p = strchr(fields[n - 1], '\t')))
+        break;
+      *p++ = '\0';
+      fields[n] = p;
+    }
+    raw = (n == 4) ? atoi(fields[3]) : 0;
+    if (raw < MIN_RAWINTENSITY) {
+      applog(LOG_DEBUG, "Ignoring malformed line in %s", filename);
+      continue;
+    }
+    set_entry(fields[0], fields[1], fields[2], raw);
+  }
+  applog(LOG_INFO, "Loaded %d GPU tuning settings from %s", tune_db_size, filename);
+  mutex_unlock(&tune_lock);
+
+  fclose(fp);
+}
+
+static int lookup_setting(struct cgpu_info *gpu)
+{
+  struct tune_entry *entry;
+  int raw = 0;
+
+  pthread_once(&tune_once, load_tune_db);
+
+  mutex_lock(&tune_lock);
+  entry = find_entry(gpu->name, gpu->algorithm.name, tune_kernel(gpu));
+  if (entry)
+    raw = entry->rawintensity;
+  mutex_unlock(&tune_lock);
+
+  return raw;
+}
+
+/* Written to a temporary file that replaces the database once it is
+ * complete, so a reader never sees it half written */
+static void save_setting(struct cgpu_info *gpu, int rawintensity)
+{
+  char filename[PATH_MAX], tmpname[PATH_MAX + 4];
+  FILE *fp;
+  int i;
+
+  tune_db_path(filename, sizeof(filename));
+  snprintf(tmpname, sizeof(tmpname), "%s.tmp", filename);
+
+  mutex_lock(&tune_lock);
+  set_entry(gpu->name, gpu->algorithm.name, tune_kernel(gpu), rawintensity);
+
+  fp = fopen(tmpname, "w");
+  if (!fp) {
+    applog(LOG_WARNING, "Failed to open %s to save GPU tuning", tmpname);
+    goto out;
+  }
+  fprintf(fp, "# device\talgorithm\tkernel\trawintensity\n");
+  for (i = 0; i < tune_db_size; i++)
+    fprintf(fp, "%s\t%s\t%s\t%d\n", tune_db[i].device, tune_db[i].algorithm,
+      tune_db[i].kernel, tune_db[i].rawintensity);
+  if (fclose(fp) || !replace_file(tmpname, filename)) {
+    applog(LOG_WARNING, "Failed to save GPU tuning to %s", filename);
+    remove(tmpname);
+  }
+out:
+  mutex_unlock(&tune_lock);
+}
+
+/* Threads of the device that are mining. Dynamic mode set from the menu
+ * pauses all but the first. */
+static int running_threads(struct cgpu_info *gpu)
+{
+  int i, running = 0;
+
+  for (i = 0; i < gpu->threads; i++) {
+    if (gpu->thr && gpu->thr[i] && !gpu->thr[i]->pause)
+      running++;
+  }
+  return MAX(running, 1);
+}
+
+/* Must be called with update_lock held */
+static void __autotune_update(struct cgpu_info *gpu, size_t threads, size_t worksize, size_t max_threads)
+{
+  const double target_us = opt_dynamic_interval * 1000.0;
+  struct timeval now;
+  double pass_us, ratio, raw;
+
+  if (unlikely(!gpu->tv_gpustart.tv_sec)) {
+    cgtime(&gpu->tv_gpustart);
+    gpu->intervals = 0;
+    return;
+  }
+  cgtime(&now);
+  gpu->intervals++;
+  pass_us = us_tdiff(&now, &gpu->tv_gpustart);
+  if (pass_us < TUNE_SAMPLE_US)
+    return;
+
+  /* Every running thread of the device counts its passes here, and their
+   * passes run side by side, so each one took that many times the average
+   * gap */
+  pass_us = pass_us * running_threads(gpu) / gpu->intervals;
+  copy_time(&gpu->tv_gpustart, &now);
+  gpu->intervals = 0;
+
+  if (max_threads > MAX_RAWINTENSITY)
+    max_threads = MAX_RAWINTENSITY;
+  max_threads -= max_threads % worksize;
+  if (max_threads < worksize)
+    max_threads = worksize;
+
+  /* Just switched to dynamic. Begin from the last setting that held for
+   * this device, algorithm and kernel if there is one. */
+  if (gpu->rawintensity <= 0) {
+    gpu->rawintensity = lookup_setting(gpu);
+    gpu->tune_saved = gpu->rawintensity > 0;
+    if (gpu->tune_saved)
+      applog(LOG_INFO, "GPU %d: raw intensity %d from tuning database", gpu->device_id, gpu->rawintensity);
+    else
+      gpu->rawintensity = threads;
+    if ((size_t)gpu->rawintensity > max_threads)
+      gpu->rawintensity = max_threads;
+    gpu->tune_stable = 0;
+    return;
+  }
+
+  ratio = target_us / pass_us;
+  if (ratio > 1.0 - TUNE_TOLERANCE && ratio < 1.0 + TUNE_TOLERANCE) {
+    if (++gpu->tune_stable >= TUNE_STABLE_SAMPLES && !gpu->tune_saved) {
+      applog(LOG_NOTICE, "GPU %d: tuned to raw intensity %d (%.1f ms per pass)",
+        gpu->device_id, gpu->rawintensity, pass_us / 1000.0);
+      save_setting(gpu, gpu->rawintensity);
+      gpu->tune_saved = true;
+    }
+    return;
+  }
+  gpu->tune_stable = 0;
+  gpu->tune_saved = false;
+
+  /* Kernel time is close to linear in threads, so scale by how far off
+   * target the last sample was, but by no more than TUNE_MAX_STEP at once */
+  if (ratio > TUNE_MAX_STEP)
+    ratio = TUNE_MAX_STEP;
+  else if (ratio < 1.0 / TUNE_MAX_STEP)
+    ratio = 1.0 / TUNE_MAX_STEP;
+  raw = gpu->rawintensity * ratio;
+  if (raw > max_threads)
+    raw = max_threads;
+  gpu->rawintensity = (int)raw - (int)raw % worksize;
+  if (gpu->rawintensity < (int)worksize)
+    gpu->rawintensity = worksize;
+}
+
+void autotune_update(struct cgpu_info *gpu, size_t threads, size_t worksize, size_t max_threads)
+{
+  mutex_lock(&update_lock);
+  __autotune_update(gpu, threads, worksize, max_threads);
+  mutex_unlock(&update_lock);
+}
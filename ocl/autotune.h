@@ -0,0 +1,16 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stddef.h>
+
+struct cgpu_info;
+
+extern char *opt_gpu_tune_db;
+
+/* Steer a dynamic GPU's raw intensity towards opt_dynamic_interval ms per
+ * kernel pass. threads is what the last pass ran with, and the result is
+ * kept a multiple of worksize and no more than max_threads. Settings that
+ * hold steady are saved per device, algorithm and kernel. */
+extern void autotune_update(struct cgpu_info *gpu, size_t threads, size_t worksize, size_t max_threads);
+
+#endif /* AUTOTUNE_H */
@@ -1,9 +1,10 @@
 #include <stdio.h>
+#include <unistd.h>
 
 #include "miner.h"
 #include "build_kernel.h"
 
-static char *file_contents(const char *filename, int *length)
+char *file_contents(const char *filename, int *length)
 {
   char *fullpath = (char *)alloca(PATH_MAX);
   void *buffer;
@@ -62,6 +63,13 @@ void set_base_compiler_options(build_kernel_data *data)
 
   sprintf(buf, "w%dl%d", (int)data->work_size, (int)sizeof(long));
   strcat(data->binary_filename, buf);
+
+  if (data->vectors > 1) {
+    sprintf(buf, " -D VECTORS=%u", data->vectors);
+    strcat(data->compiler_options, buf);
+    sprintf(buf, "v%u", data->vectors);
+    strcat(data->binary_filename, buf);
+  }
   
   if (data->kernel_path) {
     strcat(data->compiler_options, " -I \"");
@@ -120,6 +128,7 @@ bool save_opencl_kernel(build_kernel_data *data, cl_program program)
   char **binaries = NULL;
   cl_int status;
   FILE *binaryfile;
+  char tmpname[PATH_MAX];
   bool ret = false;
 
   #ifdef __APPLE__
@@ -165,18 +174,27 @@ bool save_opencl_kernel(build_kernel_data *data, cl_program program)
     goto out;
   }
 
-  /* Save the binary to be loaded next time */
-  binaryfile = fopen(data->binary_filename, "wb");
+  /* Save the binary to be loaded next time. Write it aside and replace
+   * the old one with it so nothing ever loads a partly written binary. */
+  snprintf(tmpname, sizeof(tmpname), "%s.tmp", data->binary_filename);
+  binaryfile = fopen(tmpname, "wb");
   if (!binaryfile) {
     /* Not fatal, just means we build it again next time */
-    applog(LOG_DEBUG, "Unable to create file %s", data->binary_filename);
+    applog(LOG_DEBUG, "Unable to create file %s", tmpname);
     goto out;
   } else {
     if (unlikely(fwrite(binaries[slot], 1, binary_sizes[slot], binaryfile) != binary_sizes[slot])) {
       applog(LOG_ERR, "Unable to fwrite to binaryfile");
+      fclose(binaryfile);
+      unlink(tmpname);
       goto out;
     }
     fclose(binaryfile);
+    if (!replace_file(tmpname, data->binary_filename)) {
+      applog(LOG_DEBUG, "Unable to replace %s", data->binary_filename);
+      unlink(tmpname);
+      goto out;
+    }
   }
 
   ret = true;
@@ -13,6 +13,7 @@ typedef struct _build_kernel_data {
   char source_filename[255];
   char binary_filename[255];
   char compiler_options[512];
+  char cache_key[65];
 
   cl_context context;
   cl_device_id *device;
@@ -22,9 +23,11 @@ typedef struct _build_kernel_data {
   char sgminer_path[255];
   const char *kernel_path;
   size_t work_size;
+  unsigned int vectors;
   float opencl_version;
 } build_kernel_data;
 
+char *file_contents(const char *filename, int *length);
 cl_program build_opencl_kernel(build_kernel_data *data, const char *filename);
 bool save_opencl_kernel(build_kernel_data *data, cl_program program);
 void set_base_compiler_options(build_kernel_data *data);
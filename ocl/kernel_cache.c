@@ -0,0 +1,276 @@
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "miner.h"
+#include "sph/sph_sha2.h"
+#include "kernel_cache.h"
+
+#define CACHE_INDEX "index"
+#define CACHE_MAX_INCLUDES 64
+
+struct cache_entry {
+  char key[65];
+  long size;
+  time_t used;
+  char *name;     /* What the binary used to be called, for humans */
+  bool building;
+};
+
+char *opt_kernel_cache = "kernel-cache";
+int opt_kernel_cache_size = 512; /* MB, 0 for no limit */
+
+static struct cache_entry *cache_index;
+static int cache_index_size;
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cache_cond = PTHREAD_COND_INITIALIZER;
+static pthread_once_t cache_once = PTHREAD_ONCE_INIT;
+
+static struct cache_entry *find_entry(const char *key)
+{
+  int i;
+
+  for (i = 0; i < cache_index_size; i++)
+    if (!strcmp(cache_index[i].key, key))
+      return &cache_index[i];
+  return NULL;
+}
+
+static struct cache_entry *add_entry(const char *key, const char *name)
+{
+  struct cache_entry *entry;
+
+  cache_index = (struct cache_entry *)realloc(cache_index, sizeof(*cache_index) * (cache_index_size + 1));
+  if (unlikely(!cache_index))
+    quit(1, "Failed to realloc cache_index in add_entry");
+  entry = &cache_index[cache_index_size++];
+  memset(entry, 0, sizeof(*entry));
+  snprintf(entry->key, sizeof(entry->key), "%s", key);
+  entry->name = strdup(name);
+  return entry;
+}
+
+static void remove_entry(struct cache_entry *entry)
+{
+  free(entry->name);
+  *entry = cache_index[--cache_index_size];
+}
+
+/* One line per binary: key, size, last used and the old style name,
+ * separated by tabs */
+static void load_index(void)
+{
+  char filename[PATH_MAX], line[512];
+  FILE *fp;
+
+#ifdef WIN32
+  mkdir(opt_kernel_cache);
+#else
+  mkdir(opt_kernel_cache, 0777);
+#endif
+
+  snprintf(filename, sizeof(filename), "%s/%s", opt_kernel_cache, CACHE_INDEX);
+  fp = fopen(filename, "r");
+  if (!fp)
+    return;
+
+  mutex_lock(&cache_lock);
+  while (fgets(line, sizeof(line), fp)) {
+    char *fields[4], *p;
+    struct cache_entry *entry;
+    int n;
+
+    line[strcspn(line, "\r\n")] = '\0';
+    fields[0] = line;
+    for (n = 1; n < 4; n++) {
+      if (!(p = strchr(fields[n - 1], '\t')))
+        break;
+      *p++ = '\0';
+      fields[n] = p;
+    }
+    if (n < 4 || strlen(fields[0]) != 64 || find_entry(fields[0]))
+      continue;
+
+    entry = add_entry(fields[0], fields[3]);
+    entry->size = atol(fields[1]);
+    entry->used = (time_t)atoll(fields[2]);
+  }
+  applog(LOG_DEBUG, "Loaded %d kernel cache entries from %s", cache_index_size, filename);
+  mutex_unlock(&cache_lock);
+
+  fclose(fp);
+}
+
+/* Must be called with cache_lock held */
+static void save_index(void)
+{
+  char filename[PATH_MAX], tmpname[PATH_MAX + 4];
+  FILE *fp;
+  int i;
+
+  snprintf(filename, sizeof(filename), "%s/%s", opt_kernel_cache, CACHE_INDEX);
+  snprintf(tmpname, sizeof(tmpname), "%s.tmp", filename);
+  fp = fopen(tmpname, "w");
+  if (!fp) {
+    applog(LOG_DEBUG, "Unable to write kernel cache index %s", filename);
+    return;
+  }
+  for (i = 0; i < cache_index_size; i++) {
+    if (cache_index[i].building)
+      continue;
+    fprintf(fp, "%s\t%ld\t%lld\t%s\n", cache_index[i].key, cache_index[i].size,
+      (long long)cache_index[i].used, cache_index[i].name);
+  }
+  if (fclose(fp) || !replace_file(tmpname, filename)) {
+    applog(LOG_DEBUG, "Unable to write kernel cache index %s", filename);
+    remove(tmpname);
+  }
+}
+
+/* Drop the least recently used binaries until the cache fits. Must be
+ * called with cache_lock held */
+static void trim_cache(const char *keep)
+{
+  long long limit = (long long)opt_kernel_cache_size * 1024 * 1024;
+  long long total = 0;
+  int i;
+
+  if (!limit)
+    return;
+
+  for (i = 0; i < cache_index_size; i++)
+    total += cache_index[i].size;
+
+  while (total > limit) {
+    struct cache_entry *oldest = NULL;
+    char filename[PATH_MAX];
+
+    for (i = 0; i < cache_index_size; i++) {
+      struct cache_entry *entry = &cache_index[i];
+
+      if (entry->building || !strcmp(entry->key, keep))
+        continue;
+      if (!oldest || entry->used < oldest->used)
+        oldest = entry;
+    }
+    if (!oldest)
+      break;
+
+    snprintf(filename, sizeof(filename), "%s/%s.bin", opt_kernel_cache, oldest->key);
+    applog(LOG_DEBUG, "Evicting %s (%s) from the kernel cache", filename, oldest->name);
+    unlink(filename);
+    total -= oldest->size;
+    remove_entry(oldest);
+  }
+}
+
+/* Hash a kernel file and, depth first, every file it #includes */
+static void hash_source(sph_sha256_context *ctx, const char *filename, char **seen, int *nseen)
+{
+  char *source, *p;
+  int i, length;
+
+  for (i = 0; i < *nseen; i++)
+    if (!strcmp(seen[i], filename))
+      return;
+  if (*nseen >= CACHE_MAX_INCLUDES)
+    return;
+  seen[(*nseen)++] = strdup(filename);
+
+  sph_sha256(ctx, filename, strlen(filename) + 1);
+  source = file_contents(filename, &length);
+  if (!source)
+    return;
+  sph_sha256(ctx, source, length);
+
+  for (p = source; (p = strstr(p, "#include")); ) {
+    char *start, *end;
+
+    p += strlen("#include");
+    start = p + strspn(p, " \t");
+    if (*start != '"')
+      continue;
+    end = strchr(++start, '"');
+    if (!end || memchr(start, '\n', end - start))
+      continue;
+    *end = '\0';
+    hash_source(ctx, start, seen, nseen);
+    p = end + 1;
+  }
+
+  free(source);
+}
+
+static void hash_device_info(sph_sha256_context *ctx, cl_device_id device, cl_device_info param)
+{
+  char buf[256] = { 0 };
+
+  clGetDeviceInfo(device, param, sizeof(buf) - 1, buf, NULL);
+  sph_sha256(ctx, buf, strlen(buf) + 1);
+}
+
+void kernel_cache_begin(build_kernel_data *data)
+{
+  sph_sha256_context ctx;
+  unsigned char hash[32];
+  char *seen[CACHE_MAX_INCLUDES];
+  struct cache_entry *entry;
+  char *hex;
+  int i, nseen = 0;
+
+  pthread_once(&cache_once, load_index);
+
+  /* The old style name covers the settings that are not compiler options */
+  sph_sha256_init(&ctx);
+  sph_sha256(&ctx, data->binary_filename, strlen(data->binary_filename) + 1);
+  sph_sha256(&ctx, data->compiler_options, strlen(data->compiler_options) + 1);
+  hash_device_info(&ctx, *data->device, CL_DEVICE_NAME);
+  hash_device_info(&ctx, *data->device, CL_DEVICE_VERSION);
+  hash_device_info(&ctx, *data->device, CL_DRIVER_VERSION);
+  hash_source(&ctx, data->source_filename, seen, &nseen);
+  sph_sha256_close(&ctx, hash);
+  for (i = 0; i < nseen; i++)
+    free(seen[i]);
+
+  hex = bin2hex(hash, sizeof(hash));
+  snprintf(data->cache_key, sizeof(data->cache_key), "%s", hex);
+  free(hex);
+
+  mutex_lock(&cache_lock);
+  while ((entry = find_entry(data->cache_key)) && entry->building)
+    pthread_cond_wait(&cache_cond, &cache_lock);
+  if (!entry)
+    entry = add_entry(data->cache_key, data->binary_filename);
+  entry->building = true;
+  mutex_unlock(&cache_lock);
+
+  applog(LOG_DEBUG, "Kernel cache key for %s is %s", data->binary_filename, data->cache_key);
+  snprintf(data->binary_filename, sizeof(data->binary_filename), "%s/%s.bin",
+    opt_kernel_cache, data->cache_key);
+}
+
+void kernel_cache_end(build_kernel_data *data)
+{
+  struct cache_entry *entry;
+  struct stat st;
+
+  mutex_lock(&cache_lock);
+  entry = find_entry(data->cache_key);
+  if (entry) {
+    entry->building = false;
+    if (!stat(data->binary_filename, &st) && st.st_size) {
+      entry->size = st.st_size;
+      entry->used = time(NULL);
+    }
+    else
+      remove_entry(entry);
+    trim_cache(data->cache_key);
+    save_index();
+  }
+  pthread_cond_broadcast(&cache_cond);
+  mutex_unlock(&cache_lock);
+}
@@ -0,0 +1,18 @@
+#ifndef KERNEL_CACHE_H
+#define KERNEL_CACHE_H
+
+#include "build_kernel.h"
+
+extern char *opt_kernel_cache;
+extern int opt_kernel_cache_size;
+
+/* Point data->binary_filename at the cache entry for this build, keyed on
+ * the kernel source and everything it includes, the compiler options and
+ * the device and driver. Waits while another thread compiles the same
+ * entry so it is only built once. Must be paired with kernel_cache_end. */
+void kernel_cache_begin(build_kernel_data *data);
+/* Record the entry's binary in the index and trim the cache to its size
+ * limit */
+void kernel_cache_end(build_kernel_data *data);
+
+#endif /* KERNEL_CACHE_H */
@@ -0,0 +1,166 @@
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "miner.h"
+#include "kernel_select.h"
+
+#define SELECT_DB_NAME "kernel-select.db"
+
+struct select_entry {
+  char *device;
+  char *family;
+  int nfactor;
+  char *kernel;
+};
+
+bool opt_auto_kernel;
+char *opt_auto_kernel_db;
+
+static struct select_entry *select_db;
+static int select_db_size;
+static pthread_mutex_t select_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t select_once = PTHREAD_ONCE_INIT;
+
+static void select_db_path(char *filename, size_t size)
+{
+  if (!empty_string(opt_auto_kernel_db)) {
+    snprintf(filename, size, "%s", opt_auto_kernel_db);
+    return;
+  }
+
+#if defined(unix) || defined(__APPLE__)
+  if (getenv("HOME") && *getenv("HOME"))
+    snprintf(filename, size, "%s/.sgminer/", getenv("HOME"));
+  else
+    snprintf(filename, size, ".sgminer/");
+  mkdir(filename, 0777);
+#else
+  filename[0] = '\0';
+#endif
+  strncat(filename, SELECT_DB_NAME, size - strlen(filename) - 1);
+}
+
+static struct select_entry *find_entry(const char *device, const char *family, int nfactor)
+{
+  int i;
+
+  for (i = 0; i < select_db_size; i++) {
+    struct select_entry *entry = &select_db[i];
+
+    if (!strcmp(entry->device, device) && !strcmp(entry->family, family) &&
+        entry->nfactor == nfactor)
+      return entry;
+  }
+  return NULL;
+}
+
+/* Must be called with select_lock held */
+static void set_entry(const char *device, const char *family, int nfactor, const char *kernel)
+{
+  struct select_entry *entry = find_entry(device, family, nfactor);
+
+  if (!entry) {
+    select_db = (struct select_entry *)realloc(select_db, sizeof(*select_db) * (select_db_size + 1));
+    if (unlikely(!select_db))
+      quit(1, "Failed to realloc select_db in set_entry");
+    entry = &select_db[select_db_size++];
+    entry->device = strdup(device);
+    entry->family = strdup(family);
+    entry->nfactor = nfactor;
+  }
+  else
+    free(entry->kernel);
+  entry->kernel = strdup(kernel);
+}
+
+/* One line per benchmark: device, family, N factor and the kernel that
+ * won, separated by tabs. The family is named after its first kernel. */
+static void load_select_db(void)
+{
+  char filename[PATH_MAX], line[512];
+  FILE *fp;
+
+  select_db_path(filename, sizeof(filename));
+  fp = fopen(filename, "r");
+  if (!fp) {
+    applog(LOG_DEBUG, "No kernel selection database at %s", filename);
+    return;
+  }
+
+  mutex_lock(&select_lock);
+  while (fgets(line, sizeof(line), fp)) {
+    char *fields[4], *p;
+    int n;
+
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] == '#' || line[0] == '\0')
+      continue;
+
+    fields[0] = line;
+    for (n = 1; n < 4; n++) {
+      if (!(p = strchr(fields[n - 1], '\t')))
+        break;
+      *p++ = '\0';
+      fields[n] = p;
+    }
+    if (n < 4 || empty_string(fields[3])) {
+      applog(LOG_DEBUG, "Ignoring malformed line in %s", filename);
+      continue;
+    }
+    set_entry(fields[0], fields[1], atoi(fields[2]), fields[3]);
+  }
+  applog(LOG_INFO, "Loaded %d kernel selections from %s", select_db_size, filename);
+  mutex_unlock(&select_lock);
+
+  fclose(fp);
+}
+
+bool kernel_select_lookup(struct cgpu_info *gpu, const char *family, char *kernel, size_t size)
+{
+  struct select_entry *entry;
+
+  pthread_once(&select_once, load_select_db);
+
+  mutex_lock(&select_lock);
+  entry = find_entry(gpu->name, family, gpu->algorithm.nfactor);
+  if (entry)
+    snprintf(kernel, size, "%s", entry->kernel);
+  mutex_unlock(&select_lock);
+
+  return entry != NULL;
+}
+
+/* Other devices may be benchmarking and saving at the same time, so the
+ * database is written to a temporary file that then replaces it */
+void kernel_select_save(struct cgpu_info *gpu, const char *family, const char *kernel)
+{
+  char filename[PATH_MAX], tmpname[PATH_MAX + 4];
+  FILE *fp;
+  int i;
+
+  pthread_once(&select_once, load_select_db);
+  select_db_path(filename, sizeof(filename));
+  snprintf(tmpname, sizeof(tmpname), "%s.tmp", filename);
+
+  mutex_lock(&select_lock);
+  set_entry(gpu->name, family, gpu->algorithm.nfactor, kernel);
+
+  fp = fopen(tmpname, "w");
+  if (!fp) {
+    applog(LOG_WARNING, "Failed to open %s to save the kernel selection", tmpname);
+    goto out;
+  }
+  fprintf(fp, "# device\tfamily\tnfactor\tkernel\n");
+  for (i = 0; i < select_db_size; i++)
+    fprintf(fp, "%s\t%s\t%d\t%s\n", select_db[i].device, select_db[i].family,
+      select_db[i].nfactor, select_db[i].kernel);
+  if (fclose(fp) || !replace_file(tmpname, filename)) {
+    applog(LOG_WARNING, "Failed to save the kernel selection to %s", filename);
+    remove(tmpname);
+  }
+out:
+  mutex_unlock(&select_lock);
+}
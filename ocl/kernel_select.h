@@ -0,0 +1,23 @@
+#ifndef KERNEL_SELECT_H
+#define KERNEL_SELECT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct cgpu_info;
+
+#define KERNEL_SELECT_SECONDS 3 /* Benchmark time of each kernel */
+#define KERNEL_SELECT_MAX 16    /* Most kernels one PoW can have */
+
+extern bool opt_auto_kernel;
+extern char *opt_auto_kernel_db;
+
+/* Copy the kernel that won the last benchmark of the device's algorithm
+ * family into kernel. Returns false if the family was never benchmarked on
+ * this device. */
+extern bool kernel_select_lookup(struct cgpu_info *gpu, const char *family, char *kernel, size_t size);
+
+/* Record the winning kernel of a family for the device and save it */
+extern void kernel_select_save(struct cgpu_info *gpu, const char *family, const char *kernel);
+
+#endif /* KERNEL_SELECT_H */
@@ -55,7 +55,12 @@ char *curly = ":D";
 #include "findnonce.h"
 #include "adl.h"
 #include "driver-opencl.h"
-#include "bench_block.h"
+#include "driver-cpu.h"
+#include "driver-sim.h"
+#include "ocl/autotune.h"
+#include "ocl/kernel_select.h"
+#include "ocl/kernel_cache.h"
+#include "hash_bench.h"
 
 #include "algorithm.h"
 #include "pool.h"
@@ -105,6 +110,7 @@ time_t last_getwork;
 
 int nDevs;
 int opt_dynamic_interval = 7;
+int opt_kernel_build_threads = 4;
 int opt_g_threads = -1;
 bool opt_restart = true;
 int opt_vote = 0;
@@ -117,6 +123,7 @@ int opt_keccak_unroll = 0;
 bool opt_hamsi_short = false;
 bool opt_blake_compact = false;
 bool opt_luffa_parallel = false;
+char *opt_kernel_fuse = NULL;
 
 struct list_head scan_devices;
 bool devices_enabled[MAX_DEVICES];
@@ -194,7 +201,6 @@ static pthread_mutex_t *stgd_lock;
 pthread_mutex_t console_lock;
 cglock_t ch_lock;
 static pthread_rwlock_t blk_lock;
-static pthread_mutex_t sshare_lock;
 
 pthread_rwlock_t netacc_lock;
 pthread_rwlock_t mining_thr_lock;
@@ -208,6 +214,8 @@ static int algo_switch_n = 0;
 static unsigned long pool_switch_options = 0;
 static pthread_mutex_t algo_switch_wait_lock;
 static pthread_cond_t algo_switch_wait_cond;
+static struct pool *hot_switch_pools[OPENCL_WARM_SLOTS]; /* Settings of each warm slot */
+static int hot_switch_slot = -1;  /* Slot of the GPU state in use */
 
 pthread_mutex_t restart_lock;
 pthread_cond_t restart_cond;
@@ -226,6 +234,7 @@ static void apply_initial_gpu_settings(struct pool *pool);
 static unsigned long compare_pool_settings(struct pool *oldpool, struct pool *newpool);
 static void apply_switcher_options(unsigned long options, struct pool *pool);
 static void restart_mining_threads(unsigned int new_n_threads);
+static void prepare_mining_threads(struct thr_info **thr, int count, bool init);
 static void probe_pools(void);
 static bool test_pool(struct pool *pool);
 
@@ -290,19 +299,20 @@ static struct block *blocks = NULL;
 
 int swork_id;
 
-/* For creating a hash database of stratum shares submitted that have not had
- * a response yet */
+/* For creating a hash database per pool of stratum shares submitted that
+ * have not had a response yet */
 struct stratum_share {
   UT_hash_handle hh;
+  struct list_head retry_node; /* On the send thread's list while waiting to retry */
   bool block;
   struct work *work;
   int id;
   time_t sshare_time;
   time_t sshare_sent;
+  time_t sshare_retry;
+  char msg[1024];
 };
 
-static struct stratum_share *stratum_shares = NULL;
-
 char *opt_socks_proxy = NULL;
 
 #if defined(unix) || defined(__APPLE__)
@@ -317,7 +327,22 @@ struct sigaction termhandler, inthandler;
 struct thread_q *getq;
 
 static int total_work;
-struct work *staged_work = NULL;
+
+/* Id for a new work item. Work is generated by the stratum, GBT and
+ * scheduler threads at once, and the GPU drivers key on the id, so it has
+ * to be unique. */
+static inline int next_work_id(void)
+{
+  return __atomic_fetch_add(&total_work, 1, __ATOMIC_RELAXED);
+}
+
+/* Staged work, oldest first, under stgd_lock. Work that can't be rolled is
+ * kept on its own list so hash_pop can hand it out first without searching,
+ * which keeps the masters around to be rolled again. */
+static LIST_HEAD(staged_fixed);
+static LIST_HEAD(staged_rolling);
+static int staged_count;
+static struct staged_stats staged_stats;
 
 struct schedtime schedstart;
 struct schedtime schedstop;
@@ -554,6 +579,8 @@ struct pool *add_pool(void)
     quit(1, "Failed to pthread_cond_init in add_pool");
   cglock_init(&pool->data_lock);
   mutex_init(&pool->stratum_lock);
+  mutex_init(&pool->sshare_lock);
+  mutex_init(&pool->pregen_lock);
   cglock_init(&pool->gbt_lock);
   INIT_LIST_HEAD(&pool->curlring);
 
@@ -1026,6 +1053,16 @@ static char *set_pool_state(char *arg)
   return NULL;
 }
 
+static char *set_kernel_fuse(const char *arg)
+{
+  uint32_t mask;
+
+  if (!parse_fuse_groups(arg, &mask))
+    return "Invalid value passed to --kernel-fuse";
+
+  return opt_set_charp(arg, &opt_kernel_fuse);
+}
+
 static char *set_switcher_mode(char *arg)
 {
   if(!strcasecmp(arg, "off"))
@@ -1363,6 +1400,12 @@ struct opt_table opt_config_table[] = {
       opt_set_bool, &opt_autoengine,
       "Automatically adjust all GPU engine clock speeds to maintain a target temperature"),
 #endif
+  OPT_WITHOUT_ARG("--auto-kernel",
+      opt_set_bool, &opt_auto_kernel,
+      "Benchmark the kernels of the algorithm on each GPU and mine with the fastest"),
+  OPT_WITH_ARG("--auto-kernel-db",
+      opt_set_charp, NULL, &opt_auto_kernel_db,
+      "File that the kernels picked by --auto-kernel are saved to and loaded from"),
   OPT_WITHOUT_ARG("--balance",
       set_balance, &pool_strategy,
       "Change multipool strategy from failover to even share balance"),
@@ -1374,6 +1417,12 @@ struct opt_table opt_config_table[] = {
       opt_set_bool, &opt_compact,
       "Use compact display without per device statistics"),
 #endif
+  OPT_WITHOUT_ARG("--cpu-affinity",
+      opt_set_bool, &opt_cpu_affinity,
+      "Pin each CPU mining thread to its own core"),
+  OPT_WITH_ARG("--cpu-threads",
+      set_cpu_threads, NULL, NULL,
+      "Number of CPU mining threads, or auto for one per core (default: 0, no CPU mining)"),
   OPT_WITHOUT_ARG("--debug|-D",
       enable_debug, &opt_debug,
       "Enable debug output"),
@@ -1389,6 +1438,9 @@ struct opt_table opt_config_table[] = {
   OPT_WITH_ARG("--device|-d",
       set_default_devices, NULL, NULL,
       "Select device to use, one value, range and/or comma separated (e.g. 0-2,4) default: all"),
+  OPT_WITH_ARG("--device-type",
+      set_device_type, NULL, NULL,
+      "OpenCL device types to mine on: gpu, cpu, accelerator or all, comma separated (default: gpu)"),
   OPT_WITHOUT_ARG("--disable-rejecting",
       opt_set_bool, &opt_disable_pool,
       "Automatically disable pools that continually reject shares"),
@@ -1427,10 +1479,19 @@ struct opt_table opt_config_table[] = {
       "Do not redirect to a different getwork protocol (eg. stratum)"),
   OPT_WITH_ARG("--gpu-dyninterval",
       set_int_1_to_65535, opt_show_intval, &opt_dynamic_interval,
-      "Set the refresh interval in ms for GPUs using dynamic intensity"),
+      "Set the kernel time in ms that GPUs using dynamic intensity are tuned to"),
+  OPT_WITHOUT_ARG("--gpu-mapped",
+      opt_set_bool, &opt_gpu_mapped,
+      "Map GPU result buffers in host memory instead of copying results back"),
+  OPT_WITHOUT_ARG("--gpu-pipeline",
+      opt_set_bool, &opt_gpu_pipeline,
+      "Queue each GPU kernel pass before reading back the previous one's results"),
   OPT_WITH_ARG("--gpu-platform",
       set_int_0_to_9999, opt_show_intval, &opt_platform_id,
       "Select OpenCL platform ID to use for GPU mining"),
+  OPT_WITH_ARG("--gpu-tune-db",
+      opt_set_charp, NULL, &opt_gpu_tune_db,
+      "File that dynamic intensity tuning is saved to and loaded from"),
 #ifndef HAVE_ADL
   // gpu-threads can only be set per-card if ADL is available
   OPT_WITH_ARG("--gpu-threads|-g",
@@ -1471,9 +1532,15 @@ struct opt_table opt_config_table[] = {
   OPT_WITHOUT_ARG("--hamsi-short",
       opt_set_bool, &opt_hamsi_short,
       "Set SPH_HAMSI_SHORT for X13 derived algorithms (Can give better hashrate for some GPUs)"),
+  OPT_WITHOUT_ARG("--hot-switch",
+      opt_set_bool, &opt_hot_switch,
+      "Keep the GPU state of each algorithm loaded so switching back to it is immediate"),
   OPT_WITH_ARG("--keccak-unroll",
       set_int_0_to_9999, opt_show_intval, &opt_keccak_unroll,
       "Set SPH_KECCAK_UNROLL for Xn derived algorithms (Default: 0)"),
+  OPT_WITH_ARG("--kernel-fuse",
+      set_kernel_fuse, opt_show_charp, &opt_kernel_fuse,
+      "Stages of the X11/X13/X14/X15 chains to run as one kernel: none, all or ranges such as 0-1,2-4,5-7"),
   OPT_WITH_ARG("--kernelfile",
          set_default_kernelfile, NULL, NULL,
          "Set the algorithm kernel source file (without file extension)."),
@@ -1504,6 +1571,15 @@ struct opt_table opt_config_table[] = {
       set_default_rawintensity, NULL, NULL,
       "Raw intensity of GPU scanning (" MIN_RAWINTENSITY_STR " to "
         MAX_RAWINTENSITY_STR "), overrides --intensity|-I and --xintensity|-X."),
+  OPT_WITH_ARG("--kernel-build-threads",
+      set_int_1_to_65535, opt_show_intval, &opt_kernel_build_threads,
+      "Number of GPUs to load or compile kernels for at once"),
+  OPT_WITH_ARG("--kernel-cache",
+      opt_set_charp, opt_show_charp, &opt_kernel_cache,
+      "Directory compiled GPU kernels are cached in"),
+  OPT_WITH_ARG("--kernel-cache-size",
+      set_int_0_to_9999, opt_show_intval, &opt_kernel_cache_size,
+      "Size limit in MB for the kernel cache, 0 for no limit"),
   OPT_WITH_ARG("--kernel-path|-K",
       opt_set_charp, opt_show_charp, &opt_kernel_path,
       "Specify a path to where kernel files are"),
@@ -1744,6 +1820,15 @@ struct opt_table opt_config_table[] = {
   OPT_WITHOUT_ARG("--show-coindiff",
       opt_set_bool, &opt_show_coindiff,
       "Show coin difficulty rather than hash value of a share"),
+  OPT_WITH_ARG("--sim-devices",
+      set_int_0_to_9999, opt_show_intval, &opt_sim_devices,
+      "Number of simulated devices, for testing the host side without GPUs (default: 0)"),
+  OPT_WITH_ARG("--sim-hashrate",
+      set_sim_hashrate, NULL, NULL,
+      "Hashrate of each simulated device in kH/s (default: 1000)"),
+  OPT_WITH_ARG("--sim-latency",
+      set_int_1_to_65535, opt_show_intval, &opt_sim_latency,
+      "Time each simulated device takes for one pass in ms (default: 10)"),
   OPT_WITH_ARG("--state|--pool-state",
       set_pool_state, NULL, NULL,
       "Specify pool state at startup (default: enabled)"),
@@ -1798,12 +1883,13 @@ struct opt_table opt_config_table[] = {
       "Username for bitcoin JSON-RPC server"),
   OPT_WITH_ARG("--vectors",
       set_vector, NULL, NULL,
-      opt_hidden),
-      /* All current kernels only support vectors=1 */
-      /* "Override detected optimal vector (1, 2 or 4) - one value or comma separated list"), */
+      "Override detected optimal vector (1, 2 or 4) for kernels that support it - one value or comma separated list"),
   OPT_WITHOUT_ARG("--verbose|-v",
       opt_set_bool, &opt_verbose,
       "Log verbose output to stderr as well as status output"),
+  OPT_WITH_ARG("--verify-threads",
+      set_int_1_to_10, opt_show_intval, &opt_verify_threads,
+      "Number of threads verifying the nonces found by the GPUs (1-10)"),
   OPT_WITH_ARG("--vote",
       set_int_1_to_65535, opt_show_intval, &opt_vote,
       "Optional vote value for decred blocks"),
@@ -1871,6 +1957,9 @@ static struct opt_table opt_cmdline_table[] = {
   OPT_WITHOUT_ARG("--remote-config-usecache",
       opt_set_bool, &opt_remoteconf_usecache,
       "Use cached copy of the remote config file when download fails. Default: No"),
+  OPT_WITHOUT_ARG("--hash-bench",
+      opt_set_bool, &opt_hash_bench,
+      "Check and time every algorithm's CPU hash, print the results as JSON and exit"),
   OPT_WITHOUT_ARG("--help|-h",
       opt_verusage_and_exit, NULL,
       "Print this message"),
@@ -1910,16 +1999,148 @@ static bool jobj_binary(const json_t *obj, const char *key,
 }
 #endif
 
-static struct work *make_work(void)
+/* Work structs come from slabs that are never returned to the heap. Freed
+ * work goes to a small per thread cache, which spills half its contents to
+ * a global depot when full and refills from it when empty, so threads that
+ * only free work (miners) feed threads that only make it (the scheduler). */
+#define WORK_SLAB_SIZE 64
+#define WORK_CACHE_MAX 32
+
+struct work_cache {
+  struct list_head items;
+  int count;
+};
+
+static __thread struct work_cache *work_cache;
+static pthread_key_t work_cache_key;
+static pthread_once_t work_cache_once = PTHREAD_ONCE_INIT;
+
+static pthread_mutex_t work_depot_lock = PTHREAD_MUTEX_INITIALIZER;
+static LIST_HEAD(work_depot);
+static int work_depot_count;
+static struct work_slab_stats work_slab_stats;
+
+/* Move up to count items from one free list to another */
+static int work_list_move(struct list_head *from, struct list_head *to, int count)
 {
-  struct work *w = (struct work *)calloc(1, sizeof(struct work));
+  int moved = 0;
 
-  if (unlikely(!w))
-    quit(1, "Failed to calloc work in make_work");
+  while (moved < count && !list_empty(from)) {
+    list_move(from->next, to);
+    moved++;
+  }
 
-  cg_wlock(&control_lock);
-  w->id = total_work++;
-  cg_wunlock(&control_lock);
+  return moved;
+}
+
+/* Hand a thread's cached work back to the depot when the thread exits.
+ * This runs on the exiting thread, so work freed by a later destructor
+ * starts a new cache instead of using the freed one. */
+static void work_cache_destroy(void *arg)
+{
+  struct work_cache *cache = (struct work_cache *)arg;
+
+  mutex_lock(&work_depot_lock);
+  work_depot_count += work_list_move(&cache->items, &work_depot, cache->count);
+  mutex_unlock(&work_depot_lock);
+  if (work_cache == cache)
+    work_cache = NULL;
+  free(cache);
+}
+
+static void work_cache_key_init(void)
+{
+  if (unlikely(pthread_key_create(&work_cache_key, work_cache_destroy)))
+    quit(1, "Failed to pthread_key_create in work_cache_key_init");
+}
+
+static struct work_cache *get_work_cache(void)
+{
+  if (unlikely(!work_cache)) {
+    pthread_once(&work_cache_once, work_cache_key_init);
+    work_cache = (struct work_cache *)calloc(1, sizeof(struct work_cache));
+    if (unlikely(!work_cache))
+      quit(1, "Failed to calloc work_cache in get_work_cache");
+    INIT_LIST_HEAD(&work_cache->items);
+    pthread_setspecific(work_cache_key, work_cache);
+  }
+  return work_cache;
+}
+
+static struct work *alloc_work(void)
+{
+  struct work_cache *cache = get_work_cache();
+  struct work *w;
+  int live;
+
+  if (likely(cache->count)) {
+    __atomic_add_fetch(&work_slab_stats.cache_hits, 1, __ATOMIC_RELAXED);
+  } else {
+    mutex_lock(&work_depot_lock);
+    cache->count = work_list_move(&work_depot, &cache->items, WORK_CACHE_MAX / 2);
+    work_depot_count -= cache->count;
+    if (cache->count)
+      work_slab_stats.depot_hits++;
+    mutex_unlock(&work_depot_lock);
+
+    if (!cache->count) {
+      struct work *slab = (struct work *)calloc(WORK_SLAB_SIZE, sizeof(struct work));
+      int i;
+
+      if (unlikely(!slab))
+        quit(1, "Failed to calloc work slab in make_work");
+      for (i = 0; i < WORK_SLAB_SIZE; i++)
+        list_add_tail(&slab[i].staged_node, &cache->items);
+      cache->count = WORK_SLAB_SIZE;
+      __atomic_add_fetch(&work_slab_stats.slabs, 1, __ATOMIC_RELAXED);
+    }
+  }
+
+  w = list_entry(cache->items.next, struct work *, staged_node);
+  list_del(&w->staged_node);
+  cache->count--;
+  memset(&w->staged_node, 0, sizeof(w->staged_node));
+
+  __atomic_add_fetch(&work_slab_stats.allocs, 1, __ATOMIC_RELAXED);
+  live = __atomic_add_fetch(&work_slab_stats.live, 1, __ATOMIC_RELAXED);
+  if (unlikely(live > __atomic_load_n(&work_slab_stats.peak, __ATOMIC_RELAXED)))
+    __atomic_store_n(&work_slab_stats.peak, live, __ATOMIC_RELAXED);
+
+  return w;
+}
+
+/* w must already have been cleaned */
+static void release_work(struct work *w)
+{
+  struct work_cache *cache = get_work_cache();
+  int moved;
+
+  __atomic_sub_fetch(&work_slab_stats.live, 1, __ATOMIC_RELAXED);
+  list_add(&w->staged_node, &cache->items);
+  if (++cache->count <= WORK_CACHE_MAX)
+    return;
+
+  mutex_lock(&work_depot_lock);
+  moved = work_list_move(&cache->items, &work_depot, WORK_CACHE_MAX / 2);
+  work_depot_count += moved;
+  mutex_unlock(&work_depot_lock);
+  cache->count -= moved;
+}
+
+void get_work_slab_stats(struct work_slab_stats *stats)
+{
+  mutex_lock(&work_depot_lock);
+  memcpy(stats, &work_slab_stats, sizeof(struct work_slab_stats));
+  stats->depot = work_depot_count;
+  mutex_unlock(&work_depot_lock);
+  stats->allocated = stats->slabs * WORK_SLAB_SIZE;
+}
+
+static struct work *make_work(void)
+{
+  struct work *w = alloc_work();
+
+  w->id = next_work_id();
 
   return w;
 }
@@ -1928,10 +2149,10 @@ static struct work *make_work(void)
  * cleaned to remove any dynamically allocated arrays within the struct */
 void clean_work(struct work *w)
 {
+  stratum_job_put(w->job);
   free(w->job_id);
   free(w->ntime);
   free(w->coinbase);
-  free(w->nonce1);
   memset(w, 0, sizeof(struct work));
 }
 
@@ -1940,7 +2161,7 @@ void clean_work(struct work *w)
 void free_work(struct work *w)
 {
   clean_work(w);
-  free(w);
+  release_work(w);
 }
 
 static void calc_diff(struct work *work, double known);
@@ -2152,7 +2373,7 @@ static void gen_gbt_work(struct pool *pool, struct work *work)
   local_work++;
   work->pool = pool;
   work->gbt = true;
-  work->id = total_work++;
+  work->id = next_work_id();
   work->longpoll = false;
   work->getwork_mode = GETWORK_MODE_GBT;
   work->work_block = work_block;
@@ -2358,16 +2579,55 @@ void decay_time(double *f, double fadd, double fsecs)
 
 static int __total_staged(void)
 {
-  return HASH_COUNT(staged_work);
+  return staged_count;
+}
+
+static bool work_rollable(struct work *work)
+{
+  return (!work->clone && work->rolltime);
+}
+
+/* Takes stgd_lock, counting how often another thread already held it */
+static void staged_lock(void)
+{
+  bool contended = pthread_mutex_trylock(stgd_lock) != 0;
+
+  if (contended)
+    mutex_lock(stgd_lock);
+  staged_stats.locks++;
+  if (contended)
+    staged_stats.contended++;
+}
+
+static void staged_unlock(void)
+{
+  mutex_unlock(stgd_lock);
+}
+
+static void __staged_del(struct work *work)
+{
+  list_del(&work->staged_node);
+  staged_count--;
+  if (work_rollable(work))
+    staged_rollable--;
+}
+
+void get_staged_stats(struct staged_stats *stats)
+{
+  staged_lock();
+  memcpy(stats, &staged_stats, sizeof(staged_stats));
+  stats->staged = staged_count;
+  stats->rollable = staged_rollable;
+  staged_unlock();
 }
 
 static int total_staged(void)
 {
   int ret;
 
-  mutex_lock(stgd_lock);
+  staged_lock();
   ret = __total_staged();
-  mutex_unlock(stgd_lock);
+  staged_unlock();
 
   return ret;
 }
@@ -3556,6 +3816,8 @@ static void __kill_work(void)
 
   cg_completion_timeout(&kill_mining, NULL, 3000);
 
+  sim_report();
+
   /* Stop the others */
   forcelog(LOG_DEBUG, "Killing off API thread");
   thr = &control_thr[api_thr_id];
@@ -3746,7 +4008,7 @@ static void roll_work(struct work *work)
 
   /* This is now a different work item so it needs a different ID for the
    * hashtable */
-  work->id = total_work++;
+  work->id = next_work_id();
 }
 
 static void *submit_work_thread(void *userdata)
@@ -3820,11 +4082,11 @@ static bool clone_available(void)
   struct work *work_clone = NULL, *work, *tmp;
   bool cloned = false;
 
-  mutex_lock(stgd_lock);
+  staged_lock();
   if (!staged_rollable)
     goto out_unlock;
 
-  HASH_ITER(hh, staged_work, work, tmp) {
+  list_for_each_entry_safe(work, tmp, &staged_rolling, staged_node) {
     if (can_roll(work) && should_roll(work)) {
       roll_work(work);
       work_clone = make_clone(work);
@@ -3835,7 +4097,7 @@ static bool clone_available(void)
   }
 
 out_unlock:
-  mutex_unlock(stgd_lock);
+  staged_unlock();
 
   if (cloned) {
     applog(LOG_DEBUG, "Pushing cloned available work to stage thread");
@@ -3912,11 +4174,10 @@ static void _copy_work(struct work *work, const struct work *base_work, int noff
   /* Keep the unique new id assigned during make_work to prevent copied
    * work from having the same id. */
   work->id = id;
+  stratum_job_get(work->job);
   if (base_work->job_id)
     work->job_id = strdup(base_work->job_id);
-  if (base_work->nonce1)
-    work->nonce1 = strdup(base_work->nonce1);
-  if (base_work->ntime) {
+  if (base_work->job) {
     /* If we are passed an noffset the binary work->data ntime and
      * the work->ntime hex string need to be adjusted. */
     if (noffset) {
@@ -3924,8 +4185,8 @@ static void _copy_work(struct work *work, const struct work *base_work, int noff
       uint32_t ntime = be32toh(work_ntime);
       ntime += noffset;
       _set_work_time(work, htobe32(ntime));
-      work->ntime = offset_ntime(base_work->ntime, noffset);
-    } else
+      work->ntime = offset_ntime(stratum_work_ntime(base_work), noffset);
+    } else if (base_work->ntime)
       work->ntime = strdup(base_work->ntime);
   } else if (noffset) {
     uint32_t work_ntime = _get_work_time(work);
@@ -3973,6 +4234,13 @@ static void pool_died(struct pool *pool)
   }
 }
 
+/* Jobs are immutable and referenced by their work, so a pointer compare
+ * against the pool's current job needs no lock */
+static inline bool stratum_job_current(struct pool *pool, struct work *work)
+{
+  return work->job && work->job == __atomic_load_n(&pool->swork.job, __ATOMIC_ACQUIRE);
+}
+
 static bool stale_work(struct work *work, bool share)
 {
   struct timeval now;
@@ -3996,21 +4264,12 @@ static bool stale_work(struct work *work, bool share)
   pool = work->pool;
 
   if (!share && pool->has_stratum) {
-    bool same_job;
-
     if (!pool->stratum_active || !pool->stratum_notify) {
       applog(LOG_DEBUG, "Work stale due to stratum inactive");
       return true;
     }
 
-    same_job = true;
-
-    cg_rlock(&pool->data_lock);
-    if (strcmp(work->job_id, pool->swork.job_id))
-      same_job = false;
-    cg_runlock(&pool->data_lock);
-
-    if (!same_job) {
+    if (!stratum_job_current(pool, work)) {
       applog(LOG_DEBUG, "Work stale due to stratum job_id mismatch");
       return true;
     }
@@ -4231,26 +4490,35 @@ void discard_work(struct work *work)
 
 static void wake_gws(void)
 {
-  mutex_lock(stgd_lock);
+  staged_lock();
   pthread_cond_signal(&gws_cond);
-  mutex_unlock(stgd_lock);
+  staged_unlock();
 }
 
-static void discard_stale(void)
+static int __discard_stale_list(struct list_head *head)
 {
   struct work *work, *tmp;
   int stale = 0;
 
-  mutex_lock(stgd_lock);
-  HASH_ITER(hh, staged_work, work, tmp) {
+  list_for_each_entry_safe(work, tmp, head, staged_node) {
     if (stale_work(work, false)) {
-      HASH_DEL(staged_work, work);
+      __staged_del(work);
       discard_work(work);
       stale++;
     }
   }
+  return stale;
+}
+
+static void discard_stale(void)
+{
+  int stale;
+
+  staged_lock();
+  stale = __discard_stale_list(&staged_fixed);
+  stale += __discard_stale_list(&staged_rolling);
   pthread_cond_signal(&gws_cond);
-  mutex_unlock(stgd_lock);
+  staged_unlock();
 
   if (stale)
     applog(LOG_DEBUG, "Discarded %d stales that didn't match current hash", stale);
@@ -4478,30 +4746,24 @@ out:
   return ret;
 }
 
-static int tv_sort(struct work *worka, struct work *workb)
-{
-  return worka->tv_staged.tv_sec - workb->tv_staged.tv_sec;
-}
-
-static bool work_rollable(struct work *work)
-{
-  return (!work->clone && work->rolltime);
-}
-
 static bool hash_push(struct work *work)
 {
   bool rc = true;
 
-  mutex_lock(stgd_lock);
-  if (work_rollable(work))
-    staged_rollable++;
+  staged_lock();
   if (likely(!getq->frozen)) {
-    HASH_ADD_INT(staged_work, id, work);
-    HASH_SORT(staged_work, tv_sort);
+    if (work_rollable(work)) {
+      list_add_tail(&work->staged_node, &staged_rolling);
+      staged_rollable++;
+    } else
+      list_add_tail(&work->staged_node, &staged_fixed);
+    staged_count++;
+    staged_stats.pushes++;
   } else
     rc = false;
-  pthread_cond_broadcast(&getq->cond);
-  mutex_unlock(stgd_lock);
+  /* One new item can only satisfy one waiter */
+  pthread_cond_signal(&getq->cond);
+  staged_unlock();
 
   return rc;
 }
@@ -5277,13 +5539,13 @@ static bool parse_stratum_response(struct pool *pool, char *s)
 
   id = json_integer_value(id_val);
 
-  mutex_lock(&sshare_lock);
-  HASH_FIND_INT(stratum_shares, &id, sshare);
+  mutex_lock(&pool->sshare_lock);
+  HASH_FIND_INT(pool->stratum_shares, &id, sshare);
   if (sshare) {
-    HASH_DEL(stratum_shares, sshare);
+    HASH_DEL(pool->stratum_shares, sshare);
     pool->sshares--;
   }
-  mutex_unlock(&sshare_lock);
+  mutex_unlock(&pool->sshare_lock);
 
   if (!sshare) {
     double pool_diff;
@@ -5335,18 +5597,16 @@ void clear_stratum_shares(struct pool *pool)
   double diff_cleared = 0;
   int cleared = 0;
 
-  mutex_lock(&sshare_lock);
-  HASH_ITER(hh, stratum_shares, sshare, tmpshare) {
-    if (sshare->work->pool == pool) {
-      HASH_DEL(stratum_shares, sshare);
-      diff_cleared += sshare->work->work_difficulty;
-      free_work(sshare->work);
-      pool->sshares--;
-      free(sshare);
-      cleared++;
-    }
+  mutex_lock(&pool->sshare_lock);
+  HASH_ITER(hh, pool->stratum_shares, sshare, tmpshare) {
+    HASH_DEL(pool->stratum_shares, sshare);
+    diff_cleared += sshare->work->work_difficulty;
+    free_work(sshare->work);
+    pool->sshares--;
+    free(sshare);
+    cleared++;
   }
-  mutex_unlock(&sshare_lock);
+  mutex_unlock(&pool->sshare_lock);
 
   if (cleared) {
     applog(LOG_WARNING, "Lost %d shares due to stratum disconnect on %s", cleared, get_pool_name(pool));
@@ -5357,20 +5617,48 @@ void clear_stratum_shares(struct pool *pool)
   }
 }
 
-void clear_pool_work(struct pool *pool)
+static int __clear_pool_list(struct list_head *head, struct pool *pool)
 {
   struct work *work, *tmp;
   int cleared = 0;
 
-  mutex_lock(stgd_lock);
-  HASH_ITER(hh, staged_work, work, tmp) {
+  list_for_each_entry_safe(work, tmp, head, staged_node) {
     if (work->pool == pool) {
-      HASH_DEL(staged_work, work);
+      __staged_del(work);
       free_work(work);
       cleared++;
     }
   }
-  mutex_unlock(stgd_lock);
+  return cleared;
+}
+
+/* Discard any work pre-generated for the pool's stratum job */
+static int clear_stratum_pregen(struct pool *pool)
+{
+  int cleared = 0;
+
+  mutex_lock(&pool->pregen_lock);
+  while (pool->pregen_count) {
+    free_work(pool->pregen[pool->pregen_head]);
+    pool->pregen_head = (pool->pregen_head + 1) % pool->pregen_size;
+    pool->pregen_count--;
+    cleared++;
+  }
+  pool->pregen_head = 0;
+  mutex_unlock(&pool->pregen_lock);
+
+  return cleared;
+}
+
+void clear_pool_work(struct pool *pool)
+{
+  int cleared;
+
+  staged_lock();
+  cleared = __clear_pool_list(&staged_fixed, pool);
+  cleared += __clear_pool_list(&staged_rolling, pool);
+  staged_unlock();
+  cleared += clear_stratum_pregen(pool);
 
   if (cleared)
     applog(LOG_INFO, "Cleared %d work items due to stratum disconnect on pool %d", cleared, pool->pool_no);
@@ -5434,6 +5722,88 @@ static void wait_lpcurrent(struct pool *pool);
 static void pool_resus(struct pool *pool);
 static void gen_stratum_work(struct pool *pool, struct work *work);
 
+/* Whether getwork can pick the pool while the current one keeps up: the
+ * current pool itself, or any workable pool when work is spread over them */
+static bool pool_selectable(struct pool *pool)
+{
+  if (pool == current_pool())
+    return true;
+  if (pool_strategy == POOL_LOADBALANCE || pool_strategy == POOL_BALANCE)
+    return !pool_unworkable(pool);
+  return false;
+}
+
+/* Build a batch of work for the pool's current stratum job, one per mining
+ * thread plus the queue depth, so the getwork scheduler can hand work out
+ * straight after a notify without hashing the coinbase itself. Backup pools
+ * that getwork would not pick get none. */
+static void fill_stratum_pregen(struct pool *pool)
+{
+  int i, count = mining_threads + opt_queue;
+  struct work **batch;
+
+  clear_stratum_pregen(pool);
+  if (count < 1 || !pool_selectable(pool))
+    return;
+
+  batch = (struct work **)malloc(sizeof(struct work *) * count);
+  if (unlikely(!batch))
+    quit(1, "Failed to malloc batch in fill_stratum_pregen");
+  for (i = 0; i < count; i++) {
+    batch[i] = make_work();
+    gen_stratum_work(pool, batch[i]);
+  }
+
+  mutex_lock(&pool->pregen_lock);
+  if (pool->pregen_size < count) {
+    pool->pregen = (struct work **)realloc(pool->pregen, sizeof(struct work *) * count);
+    if (unlikely(!pool->pregen))
+      quit(1, "Failed to realloc pregen in fill_stratum_pregen");
+    pool->pregen_size = count;
+  }
+  /* A notify may have raced with a getwork that drained the old ring */
+  while (pool->pregen_count) {
+    free_work(pool->pregen[pool->pregen_head]);
+    pool->pregen_head = (pool->pregen_head + 1) % pool->pregen_size;
+    pool->pregen_count--;
+  }
+  memcpy(pool->pregen, batch, sizeof(struct work *) * count);
+  pool->pregen_head = 0;
+  pool->pregen_count = count;
+  mutex_unlock(&pool->pregen_lock);
+
+  free(batch);
+  applog(LOG_DEBUG, "Pre-generated %d work items for %s", count, get_pool_name(pool));
+}
+
+/* Take one pre-generated work item if it still belongs to the current job */
+static struct work *pop_stratum_pregen(struct pool *pool)
+{
+  struct work *work = NULL;
+
+  mutex_lock(&pool->pregen_lock);
+  if (pool->pregen_count) {
+    work = pool->pregen[pool->pregen_head];
+    pool->pregen_head = (pool->pregen_head + 1) % pool->pregen_size;
+    pool->pregen_count--;
+  }
+  mutex_unlock(&pool->pregen_lock);
+
+  if (!work)
+    return NULL;
+
+  if (unlikely(!stratum_job_current(pool, work))) {
+    free_work(work);
+    return NULL;
+  }
+  /* Still the current job, so a block change on another pool since it was
+   * made doesn't make it stale */
+  work->work_block = work_block;
+  cgtime(&work->tv_staged);
+
+  return work;
+}
+
 static void stratum_resumed(struct pool *pool)
 {
   if (!pool->stratum_notify)
@@ -5470,6 +5840,7 @@ static void *stratum_rthread(void *userdata)
   RenameThread(threadname);
 
   while (42) {
+    struct stratum_job *job;
     struct timeval timeout;
     int sel_ret;
     fd_set rd;
@@ -5478,6 +5849,21 @@ static void *stratum_rthread(void *userdata)
     if (unlikely(pool->removed))
       break;
 
+    /* Connect to where a client.reconnect pointed us, see parse_reconnect */
+    if (unlikely(pool->reconnect_pending)) {
+      pool->reconnect_pending = false;
+      if (!restart_stratum(pool)) {
+        pool_died(pool);
+        while (!restart_stratum(pool)) {
+          pool_failed(pool);
+          if (pool->removed)
+            goto out;
+          cgsleep_ms(30000);
+        }
+        stratum_resumed(pool);
+      }
+    }
+
     /* Check to see whether we need to maintain this connection
      * indefinitely or just bring it up when we switch to this
      * pool */
@@ -5546,35 +5932,207 @@ static void *stratum_rthread(void *userdata)
      * has not had its idle flag cleared */
     stratum_resumed(pool);
 
+    job = pool->swork.job;
     if (!parse_method(pool, s) && !parse_stratum_response(pool, s))
       applog(LOG_INFO, "Unknown stratum msg: %s", s);
-    else if (pool->swork.clean) {
-      struct work *work = make_work();
-
-      /* Generate a single work item to update the current
-       * block database */
-      pool->swork.clean = false;
-      gen_stratum_work(pool, work);
-      work->longpoll = true;
-      /* Return value doesn't matter. We're just informing
-       * that we may need to restart. */
-      test_work_current(work);
-      free_work(work);
+    else if (pool->swork.job != job) {
+      if (pool->swork.job->clean) {
+        struct work *work = make_work();
+
+        /* Generate a single work item to update the current
+         * block database */
+        gen_stratum_work(pool, work);
+        work->longpoll = true;
+        /* Return value doesn't matter. We're just informing
+         * that we may need to restart. */
+        test_work_current(work);
+        free_work(work);
+      }
+
+      /* After the block change above, which moves work_block on and would
+       * make everything generated before it stale */
+      fill_stratum_pregen(pool);
     }
-    free(s);
   }
 
 out:
   return NULL;
 }
 
+#define STRATUM_RETRY_SECS 5    /* Between resubmits of a share that failed to send */
+#define STRATUM_RETRY_LIMIT 120 /* Give up on a share this long after it was found */
+
+/* Build the mining.submit request for a share. Returns NULL if the pool's
+ * nonce2 can't be submitted. */
+static struct stratum_share *new_stratum_share(struct pool *pool, struct work *work)
+{
+  char noncehex[12], nonce2hex[33];
+  struct stratum_share *sshare;
+  uint32_t *hash32, nonce;
+  unsigned char nonce2[16];
+
+  if (unlikely(work->nonce2_len > 8)) {
+    applog(LOG_ERR, "%s asking for inappropriately long nonce2 length %d", get_pool_name(pool), (int)work->nonce2_len);
+    applog(LOG_ERR, "Not attempting to submit shares");
+    free_work(work);
+    return NULL;
+  }
+
+  sshare = (struct stratum_share *)calloc(sizeof(struct stratum_share), 1);
+  if (unlikely(!sshare))
+    quit(1, "Failed to calloc sshare in new_stratum_share");
+  hash32 = (uint32_t *)work->hash;
+
+  sshare->sshare_time = time(NULL);
+  /* This work item is freed in parse_stratum_response */
+  sshare->work = work;
+
+  applog(LOG_DEBUG, "stratum_sthread() algorithm = %s", pool->algorithm.name);
+
+  // Neoscrypt is little endian
+  if (pool->algorithm.type == ALGO_NEOSCRYPT) {
+    nonce = htobe32(*((uint32_t *)(work->data + 76)));
+    //*((uint32_t *)nonce2) = htole32(work->nonce2);
+  }
+  else if (pool->algorithm.type == ALGO_DECRED) {
+    nonce = *((uint32_t *)(work->data + 140));
+  }
+  else if (pool->algorithm.type == ALGO_LBRY) {
+    nonce = *((uint32_t *)(work->data + 108));
+  }
+  else if (pool->algorithm.type == ALGO_SIA) {
+    nonce = *((uint32_t *)(work->data + 32));
+  }
+  else if (pool->algorithm.type == ALGO_PASCAL) {
+    nonce = htobe32(*((uint32_t *)(work->data + 196)));
+  }
+  else {
+    nonce = *((uint32_t *)(work->data + 76));
+  }
+  __bin2hex(noncehex, (const unsigned char *)&nonce, 4);
+
+  *((uint64_t *)nonce2) = htole64(work->nonce2);
+  __bin2hex(nonce2hex, nonce2, work->nonce2_len);
+
+  /* Give the stratum share a unique id */
+  sshare->id = next_swork_id();
+
+  if (pool->algorithm.type == ALGO_DECRED && opt_vote) {
+    snprintf(sshare->msg, sizeof(sshare->msg),
+      "{\"params\": [\"%s\", \"%s\", \"%s\", \"%s\", \"%s\", \"%04x\"], \"id\": %d, \"method\": \"mining.submit\"}",
+      pool->rpc_user, work->job->job_id, nonce2hex, stratum_work_ntime(work), noncehex, (opt_vote << 1) | 1, sshare->id);
+  } else {
+    snprintf(sshare->msg, sizeof(sshare->msg),
+      "{\"params\": [\"%s\", \"%s\", \"%s\", \"%s\", \"%s\"], \"id\": %d, \"method\": \"mining.submit\"}",
+      pool->rpc_user, work->job->job_id, nonce2hex, stratum_work_ntime(work), noncehex, sshare->id);
+  }
+
+  applog(LOG_INFO, "Submitting share %08lx to %s", (long unsigned int)htole32(hash32[6]), get_pool_name(pool));
+
+  return sshare;
+}
+
+static void discard_stratum_share(struct pool *pool, struct stratum_share *sshare)
+{
+  applog(LOG_DEBUG, "Failed to submit stratum share, discarding");
+  free_work(sshare->work);
+  free(sshare);
+  pool->stale_shares++;
+  total_stale++;
+}
+
+/* Send a share and track it for the response. It goes into the pool's
+ * share table first, as the response can arrive before stratum_send
+ * returns, and no lock is held over the send so a slow socket only holds up
+ * this pool. Once it is in the table the rthread may free it, on a response
+ * or a disconnect, so the message is sent from a copy. If the send fails
+ * and the stratum pool nonce1 still matches, suggesting we may be able to
+ * resume, the share is put on retries to be sent again after
+ * STRATUM_RETRY_SECS. */
+static void send_stratum_share(struct pool *pool, struct stratum_share *sshare, struct list_head *retries)
+{
+  struct stratum_share *tracked;
+  char s[sizeof(sshare->msg)];
+  bool sessionid_match;
+  time_t now;
+  int id = sshare->id;
+  int ssdiff;
+
+  sshare->sshare_sent = time(NULL);
+  ssdiff = sshare->sshare_sent - sshare->sshare_time;
+  strcpy(s, sshare->msg);
+
+  mutex_lock(&pool->sshare_lock);
+  HASH_ADD_INT(pool->stratum_shares, id, sshare);
+  pool->sshares++;
+  mutex_unlock(&pool->sshare_lock);
+
+  /* sshare may be answered and freed by the rthread from here on */
+  if (likely(stratum_send(pool, s, strlen(s)))) {
+    if (pool_tclear(pool, &pool->submit_fail))
+        applog(LOG_WARNING, "%s communication resumed, submitting work", get_pool_name(pool));
+
+    if (opt_debug || ssdiff > 0) {
+      applog(LOG_INFO, "Pool %d stratum share submission lag time %d seconds",
+             pool->pool_no, ssdiff);
+    }
+    applog(LOG_DEBUG, "Successfully submitted, adding to stratum_shares db");
+    return;
+  }
+
+  /* Take it back, unless a disconnect already cleared it as lost */
+  mutex_lock(&pool->sshare_lock);
+  HASH_FIND_INT(pool->stratum_shares, &id, tracked);
+  if (tracked) {
+    HASH_DEL(pool->stratum_shares, tracked);
+    pool->sshares--;
+  }
+  mutex_unlock(&pool->sshare_lock);
+  if (!tracked)
+    return;
+
+  if (!pool_tset(pool, &pool->submit_fail) && cnx_needed(pool)) {
+    applog(LOG_WARNING, "%s stratum share submission failure", get_pool_name(pool));
+    total_ro++;
+    pool->remotefail_occasions++;
+  }
+
+  if (opt_lowmem) {
+    applog(LOG_DEBUG, "Lowmem option prevents resubmitting stratum share");
+    discard_stratum_share(pool, sshare);
+    return;
+  }
+
+  cg_rlock(&pool->data_lock);
+  sessionid_match = (pool->nonce1 && !strcmp(sshare->work->job->nonce1, pool->nonce1));
+  cg_runlock(&pool->data_lock);
+
+  if (!sessionid_match) {
+    applog(LOG_DEBUG, "No matching session id for resubmitting stratum share");
+    discard_stratum_share(pool, sshare);
+    return;
+  }
+
+  now = time(NULL);
+  if (now + STRATUM_RETRY_SECS >= sshare->sshare_time + STRATUM_RETRY_LIMIT) {
+    discard_stratum_share(pool, sshare);
+    return;
+  }
+  /* Every retry is due later than the ones already waiting */
+  sshare->sshare_retry = now + STRATUM_RETRY_SECS;
+  list_add_tail(&sshare->retry_node, retries);
+}
+
 /* Each pool has one stratum send thread for sending shares to avoid many
  * threads being created for submission since all sends need to be serialised
- * anyway. */
+ * anyway. Shares that failed to send wait on a list until their retry is
+ * due, while new shares keep being sent. */
 static void *stratum_sthread(void *userdata)
 {
   struct pool *pool = (struct pool *)userdata;
+  struct stratum_share *sshare, *tmp;
   char threadname[16];
+  LIST_HEAD(retries);
 
   pthread_detach(pthread_self());
 
@@ -5586,144 +6144,43 @@ static void *stratum_sthread(void *userdata)
     quit(1, "Failed to create stratum_q in stratum_sthread");
 
   while (42) {
-    char noncehex[12], nonce2hex[33], s[1024] = { 0 };
-    struct stratum_share *sshare;
-    uint32_t *hash32, nonce;
-    unsigned char nonce2[16];
+    struct timespec abstime, *wait = NULL;
     struct work *work;
-    bool submitted;
+    time_t now;
 
     if (unlikely(pool->removed)) {
       break;
     }
 
-    work = (struct work *)tq_pop(pool->stratum_q, NULL);
-    if (unlikely(!work))
-      quit(1, "Stratum q returned empty work");
-
-    if (unlikely(work->nonce2_len > 8)) {
-      applog(LOG_ERR, "%s asking for inappropriately long nonce2 length %d", get_pool_name(pool), (int)work->nonce2_len);
-      applog(LOG_ERR, "Not attempting to submit shares");
-      free_work(work);
-      continue;
+    /* Wait for new work no longer than until the first retry is due */
+    if (!list_empty(&retries)) {
+      sshare = list_entry(retries.next, struct stratum_share *, retry_node);
+      abstime.tv_sec = sshare->sshare_retry;
+      abstime.tv_nsec = 0;
+      wait = &abstime;
     }
 
-    // TODO: check for memory leaks
-    sshare = (struct stratum_share *)calloc(sizeof(struct stratum_share), 1);
-    hash32 = (uint32_t *)work->hash;
-    submitted = false;
-
-    sshare->sshare_time = time(NULL);
-    /* This work item is freed in parse_stratum_response */
-    sshare->work = work;
-
-    applog(LOG_DEBUG, "stratum_sthread() algorithm = %s", pool->algorithm.name);
-
-    // Neoscrypt is little endian
-    if (pool->algorithm.type == ALGO_NEOSCRYPT) {
-      nonce = htobe32(*((uint32_t *)(work->data + 76)));
-      //*((uint32_t *)nonce2) = htole32(work->nonce2);
-    }
-    else if (pool->algorithm.type == ALGO_DECRED) {
-      nonce = *((uint32_t *)(work->data + 140));
-    }
-    else if (pool->algorithm.type == ALGO_LBRY) {
-      nonce = *((uint32_t *)(work->data + 108));
-    }
-    else if (pool->algorithm.type == ALGO_SIA) {
-      nonce = *((uint32_t *)(work->data + 32));
-    }
-    else if (pool->algorithm.type == ALGO_PASCAL) {
-      nonce = htobe32(*((uint32_t *)(work->data + 196)));
-    }
-    else {
-      nonce = *((uint32_t *)(work->data + 76));
+    work = (struct work *)tq_pop(pool->stratum_q, wait);
+    if (work) {
+      sshare = new_stratum_share(pool, work);
+      if (sshare)
+        send_stratum_share(pool, sshare, &retries);
     }
-    __bin2hex(noncehex, (const unsigned char *)&nonce, 4);
-
-    *((uint64_t *)nonce2) = htole64(work->nonce2);
-    __bin2hex(nonce2hex, nonce2, work->nonce2_len);
-    memset(s, 0, 1024);
-
-    mutex_lock(&sshare_lock);
-    /* Give the stratum share a unique id */
-    sshare->id = swork_id++;
-    mutex_unlock(&sshare_lock);
-
-
-    if (pool->algorithm.type == ALGO_DECRED && opt_vote) {
-      snprintf(s, sizeof(s),
-        "{\"params\": [\"%s\", \"%s\", \"%s\", \"%s\", \"%s\", \"%04x\"], \"id\": %d, \"method\": \"mining.submit\"}",
-        pool->rpc_user, work->job_id, nonce2hex, work->ntime, noncehex, (opt_vote << 1) | 1, sshare->id);
-    } else {
-      snprintf(s, sizeof(s),
-        "{\"params\": [\"%s\", \"%s\", \"%s\", \"%s\", \"%s\"], \"id\": %d, \"method\": \"mining.submit\"}",
-        pool->rpc_user, work->job_id, nonce2hex, work->ntime, noncehex, sshare->id);
-   }
-
-    applog(LOG_INFO, "Submitting share %08lx to %s", (long unsigned int)htole32(hash32[6]), get_pool_name(pool));
-
-    /* Try resubmitting for up to 2 minutes if we fail to submit
-     * once and the stratum pool nonce1 still matches suggesting
-     * we may be able to resume. */
-    while (time(NULL) < sshare->sshare_time + 120) {
-      bool sessionid_match;
-
-      mutex_lock(&sshare_lock);
-      if (likely(stratum_send(pool, s, strlen(s)))) {
-        int ssdiff;
-
-        if (pool_tclear(pool, &pool->submit_fail))
-            applog(LOG_WARNING, "%s communication resumed, submitting work", get_pool_name(pool));
-
-        sshare->sshare_sent = time(NULL);
-        ssdiff = sshare->sshare_sent - sshare->sshare_time;
-        if (opt_debug || ssdiff > 0) {
-          applog(LOG_INFO, "Pool %d stratum share submission lag time %d seconds",
-                 pool->pool_no, ssdiff);
-        }
-
-        HASH_ADD_INT(stratum_shares, id, sshare);
-        pool->sshares++;
-        mutex_unlock(&sshare_lock);
-
-        applog(LOG_DEBUG, "Successfully submitted, adding to stratum_shares db");
-        submitted = true;
-        break;
-      }
-      else {
-        mutex_unlock(&sshare_lock);
-      }
-      if (!pool_tset(pool, &pool->submit_fail) && cnx_needed(pool)) {
-        applog(LOG_WARNING, "%s stratum share submission failure", get_pool_name(pool));
-        total_ro++;
-        pool->remotefail_occasions++;
-      }
-
-      if (opt_lowmem) {
-        applog(LOG_DEBUG, "Lowmem option prevents resubmitting stratum share");
-        break;
-      }
-
-      cg_rlock(&pool->data_lock);
-      sessionid_match = (pool->nonce1 && !strcmp(work->nonce1, pool->nonce1));
-      cg_runlock(&pool->data_lock);
+    else if (unlikely(!wait))
+      quit(1, "Stratum q returned empty work");
 
-      if (!sessionid_match) {
-        applog(LOG_DEBUG, "No matching session id for resubmitting stratum share");
+    now = time(NULL);
+    list_for_each_entry_safe(sshare, tmp, &retries, retry_node) {
+      if (sshare->sshare_retry > now)
         break;
-      }
-      /* Retry every 5 seconds */
-      sleep(5);
+      list_del(&sshare->retry_node);
+      send_stratum_share(pool, sshare, &retries);
     }
+  }
 
-    if (unlikely(!submitted)) {
-      applog(LOG_DEBUG, "Failed to submit stratum share, discarding");
-      free_work(work);
-      free(sshare);
-      pool->stale_shares++;
-      total_stale++;
-    }
+  list_for_each_entry_safe(sshare, tmp, &retries, retry_node) {
+    list_del(&sshare->retry_node);
+    discard_stratum_share(pool, sshare);
   }
 
   /* Freeze the work queue but don't free up its memory in case there is
@@ -5953,13 +6410,13 @@ static void pool_resus(struct pool *pool)
  * be handled. */
 static struct work *hash_pop(bool blocking)
 {
-  struct work *work = NULL, *tmp;
-  int hc;
+  struct work *work = NULL;
 
-  mutex_lock(stgd_lock);
-  if (!HASH_COUNT(staged_work)) {
+  staged_lock();
+  if (!staged_count) {
     if (!blocking)
       goto out_unlock;
+    staged_stats.pop_waits++;
     do {
       struct timespec then;
       struct timeval now;
@@ -5978,7 +6435,7 @@ static struct work *hash_pop(bool blocking)
         applog(LOG_WARNING, "Waiting for work to be available from pools.");
         event_notify("idle");
       }
-    } while (!HASH_COUNT(staged_work));
+    } while (!staged_count);
   }
 
   if (no_work) {
@@ -5986,29 +6443,21 @@ static struct work *hash_pop(bool blocking)
     no_work = false;
   }
 
-  hc = HASH_COUNT(staged_work);
-  /* Find clone work if possible, to allow masters to be reused */
-  if (hc > staged_rollable) {
-    HASH_ITER(hh, staged_work, work, tmp) {
-      if (!work_rollable(work))
-        break;
-    }
-  } else
-    work = staged_work;
-  HASH_DEL(staged_work, work);
-  if (work_rollable(work))
-    staged_rollable--;
+  /* Hand out clone work if possible, to allow masters to be reused */
+  if (!list_empty(&staged_fixed))
+    work = list_entry(staged_fixed.next, struct work *, staged_node);
+  else
+    work = list_entry(staged_rolling.next, struct work *, staged_node);
+  __staged_del(work);
+  staged_stats.pops++;
 
   /* Signal the getwork scheduler to look for more work */
   pthread_cond_signal(&gws_cond);
 
-  /* Signal hash_pop again in case there are mutliple hash_pop waiters */
-  pthread_cond_signal(&getq->cond);
-
   /* Keep track of last getwork grabbed */
   last_getwork = time(NULL);
 out_unlock:
-  mutex_unlock(stgd_lock);
+  staged_unlock();
 
   return work;
 }
@@ -6109,6 +6558,100 @@ void set_target_neoscrypt(unsigned char *target, double diff, const int thr_id)
   }
 }
 
+static const uint32_t sha256_iv[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+/* Padding block for a 64 byte SHA-256 message */
+static const uint32_t sha256_pad64[16] = {
+  0x80000000, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 512
+};
+
+/* Hash the coinbase for one nonce2, resuming from the midstate of the
+ * bytes before nonce2 cached by parse_notify. Pool data_lock must be held. */
+static void gen_coinbase_hash(struct pool *pool, uint64_t nonce2le, unsigned char *hash)
+{
+  void (*hashfn)(const unsigned char *, unsigned int, unsigned char *) = pool->algorithm.gen_hash;
+  size_t tail = pool->nonce2_offset + pool->n2size;
+  sph_sha256_context ctx;
+  unsigned char *cb;
+
+  if (likely(hashfn == gen_hash || hashfn == sha256)) {
+    memcpy(&ctx, &pool->cb_midstate, sizeof(ctx));
+    sph_sha256(&ctx, &nonce2le, pool->n2size);
+    sph_sha256(&ctx, pool->coinbase + tail, pool->swork.cb_len - tail);
+    sph_sha256_close(&ctx, hash);
+    if (hashfn == gen_hash) {
+      sph_sha256_init(&ctx);
+      sph_sha256(&ctx, hash, 32);
+      sph_sha256_close(&ctx, hash);
+    }
+    return;
+  }
+
+  /* Not SHA-256 based, hash a private copy of the whole coinbase */
+  cb = (unsigned char *)malloc(pool->swork.cb_len);
+  if (unlikely(!cb))
+    quit(1, "Failed to malloc coinbase in gen_coinbase_hash");
+  memcpy(cb, pool->coinbase, pool->swork.cb_len);
+  memcpy(cb + pool->nonce2_offset, &nonce2le, pool->n2size);
+  hashfn(cb, pool->swork.cb_len, hash);
+  free(cb);
+}
+
+/* One merkle level: double SHA-256 of root || branch. Values are kept as
+ * big endian words so levels chain without converting back to bytes. */
+static inline void merkle_step(uint32_t *root, const unsigned char *branch)
+{
+  uint32_t msg[16], state[8];
+  int i;
+
+  memcpy(msg, root, 32);
+  for (i = 0; i < 8; i++)
+    msg[8 + i] = be32toh(((const uint32_t *)branch)[i]);
+  memcpy(state, sha256_iv, 32);
+  sph_sha256_comp(msg, state);
+  sph_sha256_comp(sha256_pad64, state);
+
+  memcpy(msg, state, 32);
+  msg[8] = 0x80000000;
+  memset(msg + 9, 0, 6 * sizeof(uint32_t));
+  msg[15] = 256;
+  memcpy(root, sha256_iv, 32);
+  sph_sha256_comp(msg, root);
+}
+
+#define MERKLE_STEP(n) case n: merkle_step(words, branch[merkles - n])
+
+/* Fold the coinbase hash with the merkle branches into the merkle root.
+ * Unrolled for the usual depths up to 16 branches. */
+static void merkle_fold(unsigned char *root, unsigned char **branch, int merkles)
+{
+  uint32_t words[8];
+  int i;
+
+  for (i = 0; i < 8; i++)
+    words[i] = be32toh(((uint32_t *)root)[i]);
+
+  for (i = 0; merkles - i > 16; i++)
+    merkle_step(words, branch[i]);
+
+  switch (merkles - i) {
+    MERKLE_STEP(16); MERKLE_STEP(15); MERKLE_STEP(14); MERKLE_STEP(13);
+    MERKLE_STEP(12); MERKLE_STEP(11); MERKLE_STEP(10); MERKLE_STEP(9);
+    MERKLE_STEP(8); MERKLE_STEP(7); MERKLE_STEP(6); MERKLE_STEP(5);
+    MERKLE_STEP(4); MERKLE_STEP(3); MERKLE_STEP(2); MERKLE_STEP(1);
+    default: break;
+  }
+
+  for (i = 0; i < 8; i++)
+    ((uint32_t *)root)[i] = htobe32(words[i]);
+}
+
+#undef MERKLE_STEP
+
 /* Generates stratum based work based on the most recent notify information
  * from the pool. This will keep generating work while a pool is down so we use
  * other means to detect when the pool has died in stratum_thread */
@@ -6119,9 +6662,8 @@ static void gen_stratum_work(struct pool *pool, struct work *work)
   uint64_t nonce2le;
   int i, j;
 
-  cg_wlock(&pool->data_lock);
-
   if (pool->algorithm.type == ALGO_PASCAL) {
+    cg_wlock(&pool->data_lock);
 /* TODO: refactor this */
     for (i = 0; i < 56; i += 8) {
         if (((pool->nonce2 >>  i) & 0xff) < 0x2d) pool->nonce2 = (pool->nonce2 & (0xffffffffffffff00 << i)) + (0x002d2d2d2d2d2d2d >> (48 - i));
@@ -6129,28 +6671,23 @@ static void gen_stratum_work(struct pool *pool, struct work *work)
     }
     if (((pool->nonce2 >> 56) & 0xff) < 0x2d) pool->nonce2 = 0x2d2d2d2d2d2d2d2d;
     if (((pool->nonce2 >> 56) & 0xff) > 0xfe) pool->nonce2 = 0x2d2d2d2d2d2d2d2d;
+    work->nonce2 = pool->nonce2++;
+    cg_dwlock(&pool->data_lock);
+  } else {
+    /* The coinbase is no longer written per work item so a read lock is
+     * enough; parse_notify resets nonce2 under the write lock */
+    cg_rlock(&pool->data_lock);
+    work->nonce2 = __atomic_fetch_add(&pool->nonce2, 1, __ATOMIC_RELAXED);
   }
-  nonce2le = htole64(pool->nonce2);
-  if (pool->algorithm.type != ALGO_DECRED && pool->algorithm.type != ALGO_SIA) {
-    /* Update coinbase. Always use an LE encoded nonce2 to fill in values
-    * from left to right and prevent overflow errors with small n2sizes */
-    memcpy(pool->coinbase + pool->nonce2_offset, &nonce2le, pool->n2size);
-  }
-  work->nonce2 = pool->nonce2++;
+  /* Always use an LE encoded nonce2 to fill in values from left to right
+   * and prevent overflow errors with small n2sizes */
+  nonce2le = htole64(work->nonce2);
   work->nonce2_len = pool->n2size;
 
-  /* Downgrade to a read lock to read off the pool variables */
-  cg_dwlock(&pool->data_lock);
-
   if (pool->algorithm.type != ALGO_DECRED && pool->algorithm.type != ALGO_SIA && pool->algorithm.type != ALGO_PASCAL) {
     /* Generate merkle root */
-    pool->algorithm.gen_hash(pool->coinbase, pool->swork.cb_len, merkle_root);
-    memcpy(merkle_sha, merkle_root, 32);
-    for (i = 0; i < pool->swork.merkles; i++) {
-      memcpy(merkle_sha + 32, pool->swork.merkle_bin[i], 32);
-      gen_hash(merkle_sha, 64, merkle_root);
-      memcpy(merkle_sha, merkle_root, 32);
-    }
+    gen_coinbase_hash(pool, nonce2le, merkle_sha);
+    merkle_fold(merkle_sha, pool->swork.merkle_bin, pool->swork.merkles);
   }
 
   applog(LOG_DEBUG, "[THR%d] gen_stratum_work() - algorithm = %s", work->thr_id, pool->algorithm.name);
@@ -6209,6 +6746,7 @@ static void gen_stratum_work(struct pool *pool, struct work *work)
   else if (pool->algorithm.type == ALGO_PASCAL) {
     uint32_t temp;
     memcpy(work->data, pool->coinbase, pool->swork.cb_len);
+    memcpy(work->data + pool->nonce2_offset, &nonce2le, pool->n2size);
     hex2bin((unsigned char *)&temp, pool->swork.ntime, 4);
     /* Add the nbits (big endianess). */
     ((uint32_t *)work->data)[48] = be32toh(temp);
@@ -6224,14 +6762,10 @@ static void gen_stratum_work(struct pool *pool, struct work *work)
     memcpy(work->data + pool->merkle_offset, merkle_root, 32);
   }
 
-  /* Store the stratum work diff to check it still matches the pool's
-  * stratum diff when submitting shares */
-  work->sdiff = pool->swork.diff;
-
-  /* Copy parameters required for share submission */
-  work->job_id = strdup(pool->swork.job_id);
-  work->nonce1 = strdup(pool->nonce1);
-  work->ntime = strdup(pool->swork.ntime);
+  /* Reference the job for share submission. Its diff is stored to check
+   * it still matches the pool's stratum diff when submitting shares */
+  work->job = stratum_job_get(pool->swork.job);
+  work->sdiff = work->job->diff;
   cg_runlock(&pool->data_lock);
 
   if (opt_debug) {
@@ -6247,24 +6781,21 @@ static void gen_stratum_work(struct pool *pool, struct work *work)
         free(merkle_hash);
     }
     applog(LOG_DEBUG, "[THR%d] Generated stratum header %s", work->thr_id, header);
-    applog(LOG_DEBUG, "[THR%d] Work job_id %s nonce2 %"PRIu64" ntime %s", work->thr_id, work->job_id,
-           work->nonce2, work->ntime);
+    applog(LOG_DEBUG, "[THR%d] Work job_id %s nonce2 %"PRIu64" ntime %s", work->thr_id, work->job->job_id,
+           work->nonce2, work->job->ntime);
     free(header);
   }
 
-  // For Neoscrypt use set_target_neoscrypt() function
-  if (pool->algorithm.type == ALGO_NEOSCRYPT) {
-    set_target_neoscrypt(work->target, work->sdiff, work->thr_id);
-  } else {
-    if (pool->algorithm.calc_midstate) pool->algorithm.calc_midstate(work);
-    set_target(work->target, work->sdiff, pool->algorithm.diff_multiplier2, work->thr_id);
-  }
+  /* The target was derived from the diff once when the job was built */
+  memcpy(work->target, work->job->target, 32);
+  if (pool->algorithm.type != ALGO_NEOSCRYPT && pool->algorithm.calc_midstate)
+    pool->algorithm.calc_midstate(work);
 
   local_work++;
   work->pool = pool;
   work->stratum = true;
   work->blk.nonce = 0;
-  work->id = total_work++;
+  work->id = next_work_id();
   work->longpoll = false;
   work->getwork_mode = GETWORK_MODE_STRATUM;
   work->work_block = work_block;
@@ -6368,10 +6899,10 @@ static void apply_initial_gpu_settings(struct pool *pool)
     set_worksize(opt);
 */
   //manually apply algorithm
-  for (i = 0; i < nDevs; i++)
+  for (i = 0; i < total_devices; i++)
   {
-    applog(LOG_DEBUG, "Set GPU %d to %s", i, isnull(pool->algorithm.name, ""));
-    gpus[i].algorithm = pool->algorithm;
+    applog(LOG_DEBUG, "Set %s %d to %s", devices[i]->drv->name, devices[i]->device_id, isnull(pool->algorithm.name, ""));
+    devices[i]->algorithm = pool->algorithm;
   }
 /*
   #ifdef HAVE_ADL
@@ -6752,6 +7283,106 @@ static void mutex_unlock_cleanup_handler(void *mutex)
   mutex_unlock((pthread_mutex_t *) mutex);
 }
 
+/* Slot of the warm state for pool's settings: the one holding the same GPU
+ * settings or, if there is none, a free one. -1 when all are taken. */
+static int find_warm_slot(struct pool *pool, bool *warm)
+{
+  const unsigned long reset = (SWITCHER_SOFT_RESET | SWITCHER_HARD_RESET);
+  int i, slot = -1;
+
+  *warm = false;
+  for (i = 0; i < OPENCL_WARM_SLOTS; i++)
+  {
+    if(!hot_switch_pools[i])
+    {
+      if(slot < 0)
+        slot = i;
+    }
+    else if(!(compare_pool_settings(hot_switch_pools[i], pool) & reset) &&
+        !(compare_pool_settings(pool, hot_switch_pools[i]) & reset))
+    {
+      *warm = true;
+      return i;
+    }
+  }
+
+  return slot;
+}
+
+/* Park the GPU state built for oldpool's settings and swap back in the one
+ * for newpool's if it was kept warm. Threads of drivers that have no warm
+ * state are shut down as usual. Returns false if the GPU threads still
+ * need preparing. Must be called with all mining threads gathered. */
+static bool hot_switch_threads(struct pool *oldpool, struct pool *newpool)
+{
+  bool warm;
+  int i, slot;
+
+  for (i = 0; i < mining_threads; i++)
+  {
+    struct thr_info *thr = mining_thr[i];
+
+    if(thr->cgpu->drv->drv_id != DRIVER_opencl)
+      thr->cgpu->drv->thread_shutdown(thr);
+  }
+
+  if(hot_switch_slot < 0)
+  {
+    hot_switch_slot = find_warm_slot(oldpool, &warm);
+    hot_switch_pools[hot_switch_slot] = oldpool;
+  }
+
+  //all slots taken, start over
+  if((slot = find_warm_slot(newpool, &warm)) < 0)
+  {
+    applog(LOG_INFO, "Releasing %d warm GPU states", OPENCL_WARM_SLOTS - 1);
+    opencl_warm_clear();
+    memset(hot_switch_pools, 0, sizeof(hot_switch_pools));
+    hot_switch_slot = 0;
+    hot_switch_pools[0] = oldpool;
+    slot = 1;
+  }
+
+  applog(LOG_DEBUG, "Hot switch... Parking GPU state in slot %d", hot_switch_slot);
+  opencl_warm_park(mining_thr, mining_threads, hot_switch_slot);
+
+  if(warm && (warm = opencl_warm_resume(mining_thr, mining_threads, slot)))
+    applog(LOG_INFO, "Hot switch to warm GPU state for %s", isnull(get_pool_name(newpool), ""));
+  hot_switch_pools[slot] = newpool;
+  hot_switch_slot = slot;
+
+  return warm;
+}
+
+/* After a hot switch, prepare the threads that had no warm state */
+static void prepare_cold_threads(void)
+{
+  struct thr_info **cold;
+  int i, n = 0;
+
+  cold = (struct thr_info **)malloc(sizeof(struct thr_info *) * mining_threads);
+  if (unlikely(!cold))
+    quit(1, "Failed to malloc cold in prepare_cold_threads");
+
+  for (i = 0; i < mining_threads; i++)
+  {
+    if(mining_thr[i]->cgpu->drv->drv_id != DRIVER_opencl)
+      cold[n++] = mining_thr[i];
+  }
+  if(n)
+    prepare_mining_threads(cold, n, true);
+
+  free(cold);
+}
+
+/* Drop every warm state, for when the mining threads are rebuilt */
+static void clear_hot_switch(void)
+{
+  opencl_warm_clear();
+  memset(hot_switch_pools, 0, sizeof(hot_switch_pools));
+  hot_switch_slot = -1;
+}
+
 static void get_work_prepare_thread(struct thr_info *mythr, struct work *work)
 {
   int i;
@@ -6834,22 +7465,29 @@ static void get_work_prepare_thread(struct thr_info *mythr, struct work *work)
     applog(LOG_DEBUG, "Applying pool settings for %s...", isnull(get_pool_name(work->pool), ""));
     rd_lock(&mining_thr_lock);
 
-    // Shutdown all threads first (necessary)
+    bool warm = false;
+
+    // Shutdown all threads first (necessary), or park their state if hot switching
     if(opt_isset(pool_switch_options, SWITCHER_SOFT_RESET))
     {
-      applog(LOG_DEBUG, "Soft Reset... Shutdown threads...");
-      for (i = 0; i < mining_threads; i++)
+      if(opt_hot_switch)
+        warm = hot_switch_threads(pools[mythr->pool_no], work->pool);
+      else
       {
-        struct thr_info *thr = mining_thr[i];
-        thr->cgpu->drv->thread_shutdown(thr);
+        applog(LOG_DEBUG, "Soft Reset... Shutdown threads...");
+        for (i = 0; i < mining_threads; i++)
+        {
+          struct thr_info *thr = mining_thr[i];
+          thr->cgpu->drv->thread_shutdown(thr);
+        }
       }
     }
 
     // Reset stats (e.g. for working_diff to be set properly in hash_sole_work)
     zero_stats();
 
-    //apply switcher options
-    apply_switcher_options(pool_switch_options, work->pool);
+    //apply switcher options, a warm state already has all but the hardware ones
+    apply_switcher_options((warm ? (pool_switch_options & SWITCHER_APPLY_HW) : pool_switch_options), work->pool);
 
     //devices
     /*if(opt_isset(pool_switch_options, SWITCHER_APPLY_DEVICE))
@@ -6997,20 +7635,23 @@ static void get_work_prepare_thread(struct thr_info *mythr, struct work *work)
       thr = mining_thr[i];
       thr->pool_no = work->pool->pool_no; //set thread on new pool
 
-      //apply new algorithm if set
-      if(opt_isset(pool_switch_options, SWITCHER_APPLY_ALGO))
+      //apply new algorithm if set, a warm GPU state brought back its own
+      if(opt_isset(pool_switch_options, SWITCHER_APPLY_ALGO) &&
+          !(warm && thr->cgpu->drv->drv_id == DRIVER_opencl))
         thr->cgpu->algorithm = work->pool->algorithm;
 
-      if(opt_isset(pool_switch_options, SWITCHER_SOFT_RESET))
-      {
-        thr->cgpu->drv->thread_prepare(thr);
-        thr->cgpu->drv->thread_init(thr);
-      }
-
       // Necessary because algorithms can have dramatically different diffs
       thr->cgpu->drv->working_diff = 1;
     }
 
+    if(opt_isset(pool_switch_options, SWITCHER_SOFT_RESET))
+    {
+      if(warm)
+        prepare_cold_threads();
+      else
+        prepare_mining_threads(mining_thr, mining_threads, true);
+    }
+
     rd_unlock(&mining_thr_lock);
     mutex_unlock(&algo_switch_lock);
 
@@ -7180,8 +7821,8 @@ void inc_hw_errors(struct thr_info *thr)
   thr->cgpu->drv->hw_error(thr);
 }
 
-/* Fills in the work nonce and builds the output data in work->hash */
-static void rebuild_nonce(struct work *work, uint32_t nonce)
+/* Fills in the work nonce without hashing */
+void set_work_nonce(struct work *work, uint32_t nonce)
 {
   uint32_t nonce_pos = 76;
   if (work->pool->algorithm.type == ALGO_CRE) nonce_pos = 140;
@@ -7193,18 +7834,22 @@ static void rebuild_nonce(struct work *work, uint32_t nonce)
   uint32_t *work_nonce = (uint32_t *)(work->data + nonce_pos);
 
   *work_nonce = htole32(nonce);
+}
+
+/* Fills in the work nonce and builds the output data in work->hash */
+static void rebuild_nonce(struct work *work, uint32_t nonce)
+{
+  set_work_nonce(work, nonce);
 
   work->pool->algorithm.regenhash(work);
 }
 
-/* For testing a nonce against diff 1 */
-bool test_nonce(struct work *work, uint32_t nonce)
+/* Checks the hash already in work->hash against diff 1 */
+static bool hash_meets_diff1(struct work *work)
 {
   uint32_t *hash_32 = (uint32_t *)(work->hash + 28);
   uint32_t diff1targ;
 
-  rebuild_nonce(work, nonce);
-
   // for Neoscrypt, the diff1targ value is in work->target
   if (work->pool->algorithm.type == ALGO_NEOSCRYPT || work->pool->algorithm.type == ALGO_PLUCK
     || work->pool->algorithm.type == ALGO_YESCRYPT || work->pool->algorithm.type == ALGO_YESCRYPT_MULTI) {
@@ -7217,6 +7862,14 @@ bool test_nonce(struct work *work, uint32_t nonce)
   return (le32toh(*hash_32) <= diff1targ);
 }
 
+/* For testing a nonce against diff 1 */
+bool test_nonce(struct work *work, uint32_t nonce)
+{
+  rebuild_nonce(work, nonce);
+
+  return hash_meets_diff1(work);
+}
+
 static void update_work_stats(struct thr_info *thr, struct work *work)
 {
   double test_diff = current_diff;
@@ -7270,6 +7923,47 @@ bool submit_nonce(struct thr_info *thr, struct work *work, uint32_t nonce)
   return false;
 }
 
+#define NONCE_BATCH 64
+
+/* Submits every nonce a device found for one work item. Algorithms with a
+ * regenhash_batch hash them all in one call, sharing the work prefix. Returns
+ * the number of nonces that were valid shares */
+int submit_nonces(struct thr_info *thr, struct work *work, const uint32_t *nonces, int count)
+{
+  unsigned char hashes[NONCE_BATCH * 32];
+  int i, n, valid = 0;
+
+  if (!work->pool->algorithm.regenhash_batch) {
+    for (i = 0; i < count; i++) {
+      if (submit_nonce(thr, work, nonces[i]))
+        valid++;
+    }
+    return valid;
+  }
+
+  while (count > 0) {
+    n = MIN(count, NONCE_BATCH);
+    work->pool->algorithm.regenhash_batch(work, nonces, hashes, n);
+
+    for (i = 0; i < n; i++) {
+      set_work_nonce(work, nonces[i]);
+      memcpy(work->hash, hashes + i * 32, 32);
+
+      if (hash_meets_diff1(work)) {
+        submit_tested_work(thr, work);
+        valid++;
+      }
+      else
+        inc_hw_errors(thr);
+    }
+
+    nonces += n;
+    count -= n;
+  }
+
+  return valid;
+}
+
 static inline bool abandon_work(struct work *work, struct timeval *wdiff, uint64_t hashes)
 {
   if (wdiff->tv_sec > opt_scantime ||
@@ -8600,6 +9294,80 @@ static void probe_pools(void)
   }
 }
 
+struct prepare_batch {
+  struct thr_info **thr;
+  int count;
+  int next;       /* First thread whose device has not been claimed */
+  bool init;
+  pthread_mutex_t lock;
+};
+
+static void *prepare_worker(void *userdata)
+{
+  struct prepare_batch *batch = (struct prepare_batch *)userdata;
+
+  while (42) {
+    int i, end;
+
+    /* Claim all the threads of the next device */
+    mutex_lock(&batch->lock);
+    i = end = batch->next;
+    while (end < batch->count && batch->thr[end]->cgpu == batch->thr[i]->cgpu)
+      end++;
+    batch->next = end;
+    mutex_unlock(&batch->lock);
+
+    if (i >= batch->count)
+      break;
+
+    for (; i < end; i++) {
+      struct thr_info *thr = batch->thr[i];
+
+      if (!thr->cgpu->drv->thread_prepare(thr)) {
+        applog(LOG_ERR, "thread_prepare failed for thread %d", thr->id);
+        continue;
+      }
+      if (batch->init)
+        thr->cgpu->drv->thread_init(thr);
+    }
+  }
+
+  return NULL;
+}
+
+/* Prepare, and optionally init, a run of mining threads. This is where GPU
+ * kernels get loaded or compiled, so different devices are prepared in
+ * parallel on up to opt_kernel_build_threads threads. The threads of one
+ * device, which are adjacent, are still prepared in order by one worker. */
+static void prepare_mining_threads(struct thr_info **thr, int count, bool init)
+{
+  struct prepare_batch batch;
+  pthread_t *workers;
+  int i, n = MIN(opt_kernel_build_threads, count);
+
+  batch.thr = thr;
+  batch.count = count;
+  batch.next = 0;
+  batch.init = init;
+  mutex_init(&batch.lock);
+
+  workers = (pthread_t *)alloca(sizeof(pthread_t) * (n + 1));
+  for (i = 1; i < n; i++) {
+    if (unlikely(pthread_create(&workers[i], NULL, prepare_worker, &batch))) {
+      applog(LOG_WARNING, "Failed to create thread prepare worker %d", i);
+      break;
+    }
+  }
+  n = i;
+
+  /* This thread does its share too */
+  prepare_worker(&batch);
+  for (i = 1; i < n; i++)
+    pthread_join(workers[i], NULL);
+
+  mutex_destroy(&batch.lock);
+}
+
 static void restart_mining_threads(unsigned int new_n_threads)
 {
   struct thr_info *thr;
@@ -8633,6 +9401,7 @@ static void restart_mining_threads(unsigned int new_n_threads)
         thr->cgpu->drv->thread_shutdown(thr);
         thr->cgpu->shutdown = false;
     }
+    clear_hot_switch();
     rd_unlock(&mining_thr_lock);
   }
 
@@ -8704,13 +9473,9 @@ static void restart_mining_threads(unsigned int new_n_threads)
 
       cgtime(&thr->last);
       cgpu->thr[j] = thr;
-
-      if (!cgpu->drv->thread_prepare(thr)) {
-        applog(LOG_ERR, "thread_prepare failed for thread %d", thr->id);
-        continue;
-      }
     }
   }
+  prepare_mining_threads(mining_thr, k, false);
   rd_unlock(&devices_lock);
   wr_unlock(&mining_thr_lock);
 
@@ -8787,7 +9552,6 @@ int main(int argc, char *argv[])
   mutex_init(&stats_lock);
   mutex_init(&sharelog_lock);
   cglock_init(&ch_lock);
-  mutex_init(&sshare_lock);
   rwlock_init(&blk_lock);
   rwlock_init(&netacc_lock);
   rwlock_init(&mining_thr_lock);
@@ -8886,6 +9650,9 @@ int main(int argc, char *argv[])
   //load default profile if specified in config
   load_default_profile();
 
+  if (opt_hash_bench)
+    exit(hash_bench());
+
 #ifdef HAVE_CURSES
   if (opt_realquiet || opt_display_devs)
     use_curses = false;
@@ -8929,8 +9696,10 @@ int main(int argc, char *argv[])
   /* Use the DRIVER_PARSE_COMMANDS macro to fill all the device_drvs */
   DRIVER_PARSE_COMMANDS(DRIVER_FILL_DEVICE_DRV)
 
-  // this will set total_devices
+  // this will set total_devices, CPUs and simulated devices go after the GPUs so GPU numbers never change
   opencl_drv.drv_detect();
+  cpu_drv.drv_detect();
+  sim_drv.drv_detect();
 
   if (opt_display_devs) {
     applog(LOG_ERR, "Devices detected:");
@@ -9171,11 +9940,11 @@ int main(int argc, char *argv[])
   /* Once everything is set up, main() becomes the getwork scheduler */
   while (42) {
     int ts, max_staged = opt_queue;
+    struct work *work, *pregen;
     struct pool *pool, *cp;
     bool lagging = false;
     struct timespec then;
     struct timeval now;
-    struct work *work;
 
     if (opt_work_update)
       signal_work_update();
@@ -9191,7 +9960,7 @@ int main(int argc, char *argv[])
     then.tv_sec = now.tv_sec + 2;
     then.tv_nsec = now.tv_usec * 1000;
 
-    mutex_lock(stgd_lock);
+    staged_lock();
     ts = __total_staged();
 
     if (!pool_localgen(cp) && !ts && !opt_fail_only)
@@ -9202,7 +9971,7 @@ int main(int argc, char *argv[])
       pthread_cond_timedwait(&gws_cond, stgd_lock, &then);
       ts = __total_staged();
     }
-    mutex_unlock(stgd_lock);
+    staged_unlock();
 
     if (ts > max_staged) {
       /* Keeps slowly generating work even if it's not being
@@ -9239,8 +10008,15 @@ retry:
           goto retry;
         }
       }
-      gen_stratum_work(pool, work);
-      applog(LOG_DEBUG, "Generated stratum work");
+      pregen = pop_stratum_pregen(pool);
+      if (pregen) {
+        free_work(work);
+        work = pregen;
+        applog(LOG_DEBUG, "Using pre-generated stratum work");
+      } else {
+        gen_stratum_work(pool, work);
+        applog(LOG_DEBUG, "Generated stratum work");
+      }
       stage_work(work);
       continue;
     }
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+
+# This program is free software; you can redistribute it and/or modify it under
+# the terms of the GNU General Public License as published by the Free Software
+# Foundation; either version 3 of the License, or (at your option) any later
+# version.  See COPYING for more details.
+
+# Compare --kernel-fuse settings of an X11/X13/X14/X15 chain on the same
+# device. Each setting mines against a local stratum-test-server.py for a
+# while and the hashrate after the warmup is read back through the API.
+# Hardware errors mean a fused kernel hashed differently from the CPU check.
+# Arguments after -- go to sgminer, e.g. to pick a CPU OpenCL runtime:
+#
+# ./tools/kernel-fuse-bench.py --algorithm x11 none 0-1,2-4,5-7 all -- \
+#     --device-type cpu -I 12
+
+import argparse
+import json
+import os
+import socket
+import subprocess
+import sys
+import time
+
+
+def api(port, command):
+    sock = socket.create_connection(("127.0.0.1", port), timeout=5)
+    try:
+        sock.sendall(json.dumps({"command": command}).encode())
+        data = b""
+        while True:
+            more = sock.recv(4096)
+            if not more:
+                break
+            data += more
+    finally:
+        sock.close()
+    return json.loads(data.decode().rstrip("\x00"))
+
+
+def summary(port):
+    return api(port, "summary")["SUMMARY"][0]
+
+
+def wait_api(port, proc, timeout):
+    end = time.time() + timeout
+    while time.time() < end:
+        if proc.poll() is not None:
+            return False
+        try:
+            summary(port)
+            return True
+        except (OSError, ValueError):
+            time.sleep(1)
+    return False
+
+
+def run(args, fuse, extra):
+    cmd = [args.sgminer, "-o", "stratum+tcp://127.0.0.1:%d" % args.port, "-u", "bench", "-p", "x",
+           "--algorithm", args.algorithm, "--kernel-fuse", fuse, "--text-only",
+           "--api-listen", "--api-port", str(args.api_port)] + extra
+    log = open(os.devnull, "w") if not args.verbose else None
+    proc = subprocess.Popen(cmd, stdout=log, stderr=log)
+    try:
+        if not wait_api(args.api_port, proc, args.startup):
+            return None
+        # Kernels are built and the intensity has settled after the warmup
+        time.sleep(args.warmup)
+        start = summary(args.api_port)
+        time.sleep(args.time)
+        end = summary(args.api_port)
+    finally:
+        proc.terminate()
+        try:
+            proc.wait(10)
+        except subprocess.TimeoutExpired:
+            proc.kill()
+            proc.wait()
+    secs = end["Elapsed"] - start["Elapsed"]
+    mhs = (end["Total MH"] - start["Total MH"]) / secs if secs > 0 else 0
+    return mhs, end["Accepted"] - start["Accepted"], end["Hardware Errors"]
+
+
+def main():
+    argv = sys.argv[1:]
+    extra = []
+    if "--" in argv:
+        extra = argv[argv.index("--") + 1:]
+        argv = argv[:argv.index("--")]
+
+    parser = argparse.ArgumentParser(description="Compare --kernel-fuse settings of a chain algorithm")
+    parser.add_argument("fuse", nargs="+", help="--kernel-fuse values to compare, e.g. none 0-1,2-4,5-7 all")
+    parser.add_argument("--algorithm", default="x11")
+    parser.add_argument("--sgminer", default="./sgminer")
+    parser.add_argument("--port", type=int, default=3334, help="stratum test server port (default: 3334)")
+    parser.add_argument("--api-port", type=int, default=4029, help="sgminer API port (default: 4029)")
+    parser.add_argument("--startup", type=float, default=120, help="seconds allowed for the API to come up (default: 120)")
+    parser.add_argument("--warmup", type=float, default=30, help="seconds before measuring (default: 30)")
+    parser.add_argument("--time", type=float, default=60, help="seconds measured per setting (default: 60)")
+    parser.add_argument("--verbose", action="store_true", help="show the sgminer output")
+    args = parser.parse_args(argv)
+
+    server_script = os.path.join(os.path.dirname(os.path.abspath(__file__)), "stratum-test-server.py")
+    server = subprocess.Popen([sys.executable, server_script, "--port", str(args.port), "--interval", "30",
+                               "--report", "3600"], stdout=subprocess.DEVNULL)
+    results = []
+    try:
+        time.sleep(1)
+        for fuse in args.fuse:
+            print("%s --kernel-fuse %s ..." % (args.algorithm, fuse), flush=True)
+            results.append((fuse, run(args, fuse, extra)))
+    finally:
+        server.terminate()
+        server.wait()
+
+    base = results[0][1][0] if results[0][1] else 0
+    print("%-20s %12s %8s %9s %8s" % ("kernel-fuse", "MH/s", "vs first", "accepted", "hw errs"))
+    for fuse, result in results:
+        if result is None:
+            print("%-20s %12s" % (fuse, "failed"))
+            continue
+        mhs, accepted, hw = result
+        print("%-20s %12.4f %7.1f%% %9d %8d" % (fuse, mhs, 100 * mhs / base if base else 0, accepted, hw))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
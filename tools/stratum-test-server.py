@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+
+# This program is free software; you can redistribute it and/or modify it under
+# the terms of the GNU General Public License as published by the Free Software
+# Foundation; either version 3 of the License, or (at your option) any later
+# version.  See COPYING for more details.
+
+# Local stratum server for load testing sgminer, usually together with the
+# simulated devices (--sim-devices). It sends a new job every --interval
+# seconds and accepts every share for a job it still knows, without checking
+# the hash: sgminer has already checked it against the target before sending.
+#
+# ./tools/stratum-test-server.py --port 3333 --interval 5
+# ./sgminer -o stratum+tcp://127.0.0.1:3333 -u test -p x --algorithm whirlpoolx \
+#     --sim-devices 100 --sim-hashrate 2000 --text-only
+
+import argparse
+import binascii
+import json
+import os
+import socketserver
+import struct
+import sys
+import threading
+import time
+
+JOBS_KEPT = 8
+
+
+def rand_hex(size):
+    return binascii.hexlify(os.urandom(size)).decode()
+
+
+class Stats(object):
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.start = time.time()
+        self.clients = 0
+        self.jobs = 0
+        self.accepted = 0
+        self.stale = 0
+        self.duplicate = 0
+        self.first_share = []     # seconds from notify to the first share of each job
+        self.last_accepted = 0
+        self.last_report = self.start
+
+    def report(self, final=False):
+        with self.lock:
+            now = time.time()
+            interval = now - self.last_report
+            rate = (self.accepted - self.last_accepted) / interval if interval > 0 else 0
+            self.last_accepted = self.accepted
+            self.last_report = now
+            elapsed = now - self.start
+            line = "%d clients, %d jobs, %d accepted (%.1f/s, %.1f/s overall), %d stale, %d duplicate" % (
+                self.clients, self.jobs, self.accepted, rate,
+                self.accepted / elapsed if elapsed > 0 else 0, self.stale, self.duplicate)
+            if self.first_share:
+                line += ", notify to first share %.1f ms avg %.1f ms max" % (
+                    1000 * sum(self.first_share) / len(self.first_share), 1000 * max(self.first_share))
+        print(("Final: " if final else "") + line, flush=True)
+
+
+class Jobs(object):
+    def __init__(self, args):
+        self.args = args
+        self.lock = threading.Lock()
+        self.next_id = 0
+        self.jobs = {}            # job id -> [time sent, first share seen]
+        self.order = []
+        self.prev_hash = rand_hex(32)
+        self.current = None
+
+    def new_job(self, clean):
+        with self.lock:
+            self.next_id += 1
+            job_id = "%x" % self.next_id
+            if clean:
+                self.prev_hash = rand_hex(32)
+            merkles = [rand_hex(32) for _ in range(self.args.merkles)]
+            # A coinbase transaction with room for extranonce1 and extranonce2
+            coinb1 = "01000000010000000000000000000000000000000000000000000000000000000000000000ffffffff20" + rand_hex(4)
+            coinb2 = "ffffffff0100f2052a010000001976a914" + rand_hex(20) + "88ac00000000"
+            ntime = "%08x" % int(time.time())
+            self.current = [job_id, self.prev_hash, coinb1, coinb2, merkles, "20000000", "1d00ffff", ntime, clean]
+            self.jobs[job_id] = [time.time(), False]
+            self.order.append(job_id)
+            while len(self.order) > JOBS_KEPT:
+                del self.jobs[self.order.pop(0)]
+            return self.current
+
+    def share(self, job_id, accepted=True):
+        """Returns None for an unknown job, else the seconds from its notify
+        if this is its first accepted share, else False"""
+        with self.lock:
+            job = self.jobs.get(job_id)
+            if job is None:
+                return None
+            if job[1] or not accepted:
+                return False
+            job[1] = True
+            return time.time() - job[0]
+
+
+class Handler(socketserver.StreamRequestHandler):
+    def setup(self):
+        socketserver.StreamRequestHandler.setup(self)
+        self.send_lock = threading.Lock()
+        self.subscribed = False
+        self.seen = set()
+        server = self.server
+        with server.lock:
+            server.extranonce += 1
+            self.extranonce1 = binascii.hexlify(struct.pack(">I", server.extranonce)).decode()
+            server.handlers.add(self)
+        with server.stats.lock:
+            server.stats.clients += 1
+
+    def finish(self):
+        with self.server.lock:
+            self.server.handlers.discard(self)
+        with self.server.stats.lock:
+            self.server.stats.clients -= 1
+        socketserver.StreamRequestHandler.finish(self)
+
+    def send(self, msg):
+        data = (json.dumps(msg) + "\n").encode()
+        with self.send_lock:
+            try:
+                self.wfile.write(data)
+                self.wfile.flush()
+            except OSError:
+                pass
+
+    def notify(self, job):
+        self.send({"id": None, "method": "mining.notify", "params": job})
+
+    def reply(self, msg_id, result, error=None):
+        self.send({"id": msg_id, "result": result, "error": error})
+
+    def handle(self):
+        try:
+            for line in self.rfile:
+                self.message(line)
+        except OSError:
+            pass
+
+    def message(self, line):
+        server = self.server
+        try:
+            msg = json.loads(line.decode())
+        except ValueError:
+            return
+        method = msg.get("method")
+        msg_id = msg.get("id")
+        params = msg.get("params") or []
+
+        if method == "mining.subscribe":
+            self.reply(msg_id, [[["mining.set_difficulty", "1"], ["mining.notify", "1"]],
+                                self.extranonce1, server.args.extranonce2_size])
+            self.send({"id": None, "method": "mining.set_difficulty", "params": [server.args.difficulty]})
+            self.subscribed = True
+            if server.jobs.current:
+                self.notify(server.jobs.current)
+        elif method in ("mining.authorize", "mining.extranonce.subscribe"):
+            self.reply(msg_id, True)
+        elif method == "mining.submit" and len(params) >= 5:
+            key = tuple(params[1:5])
+            duplicate = key in self.seen
+            first = server.jobs.share(params[1], not duplicate)
+            with server.stats.lock:
+                if first is None:
+                    server.stats.stale += 1
+                elif duplicate:
+                    server.stats.duplicate += 1
+                else:
+                    server.stats.accepted += 1
+                    if first is not False:
+                        server.stats.first_share.append(first)
+            if first is None:
+                self.reply(msg_id, None, [21, "Job not found", None])
+            elif duplicate:
+                self.reply(msg_id, None, [22, "Duplicate share", None])
+            else:
+                self.seen.add(key)
+                self.reply(msg_id, True)
+        elif msg_id is not None:
+            self.reply(msg_id, None, [20, "Unsupported method", None])
+
+
+class Server(socketserver.ThreadingMixIn, socketserver.TCPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+    def __init__(self, args):
+        socketserver.TCPServer.__init__(self, (args.host, args.port), Handler)
+        self.args = args
+        self.lock = threading.Lock()
+        self.handlers = set()
+        self.extranonce = 0
+        self.stats = Stats()
+        self.jobs = Jobs(args)
+
+    def broadcast(self, job):
+        with self.lock:
+            handlers = [h for h in self.handlers if h.subscribed]
+        for h in handlers:
+            h.notify(job)
+
+
+def notifier(server, args):
+    count = 0
+    while True:
+        count += 1
+        job = server.jobs.new_job(args.clean_every > 0 and count % args.clean_every == 0)
+        with server.stats.lock:
+            server.stats.jobs += 1
+        server.broadcast(job)
+        time.sleep(args.interval)
+
+
+def reporter(server, args):
+    while True:
+        time.sleep(args.report)
+        server.stats.report()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Local stratum server for load testing sgminer")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=3333)
+    parser.add_argument("--difficulty", type=float, default=1, help="share difficulty (default: 1)")
+    parser.add_argument("--interval", type=float, default=10, help="seconds between jobs (default: 10)")
+    parser.add_argument("--clean-every", type=int, default=1,
+                        help="every Nth job is a new block with clean_jobs set, 0 for never (default: 1)")
+    parser.add_argument("--merkles", type=int, default=4, help="merkle branches per job (default: 4)")
+    parser.add_argument("--extranonce2-size", type=int, default=4)
+    parser.add_argument("--report", type=float, default=10, help="seconds between reports (default: 10)")
+    args = parser.parse_args()
+
+    server = Server(args)
+    for target in (notifier, reporter):
+        thread = threading.Thread(target=target, args=(server, args))
+        thread.daemon = True
+        thread.start()
+
+    print("Listening on %s:%d, difficulty %g, a job every %gs" % (args.host, args.port, args.difficulty, args.interval),
+          flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    server.stats.report(final=True)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
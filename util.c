@@ -1298,6 +1298,19 @@ retry:
   return SEND_OK;
 }
 
+/* A failed send may come from a thread other than the one reading the pool,
+ * which can be parsing a line that recv_line returned from the sockbuf. So
+ * the socket is only shut down here: the reader sees it closed and suspends
+ * the pool itself, clearing the sockbuf from its own thread. */
+static void fail_stratum_send(struct pool *pool)
+{
+  mutex_lock(&pool->stratum_lock);
+  pool->stratum_active = pool->stratum_notify = false;
+  if (pool->sock)
+    shutdown(pool->sock, SHUT_RDWR);
+  mutex_unlock(&pool->stratum_lock);
+}
+
 bool stratum_send(struct pool *pool, char *s, ssize_t len)
 {
   enum send_ret ret = SEND_INACTIVE;
@@ -1317,11 +1330,11 @@ bool stratum_send(struct pool *pool, char *s, ssize_t len)
       break;
     case SEND_SELECTFAIL:
       applog(LOG_DEBUG, "Write select failed on %s sock", get_pool_name(pool));
-      suspend_stratum(pool);
+      fail_stratum_send(pool);
       break;
     case SEND_SENDFAIL:
       applog(LOG_DEBUG, "Failed to send in stratum_send");
-      suspend_stratum(pool);
+      fail_stratum_send(pool);
       break;
     case SEND_INACTIVE:
       applog(LOG_DEBUG, "Stratum send failed due to no pool stratum_active");
@@ -1350,7 +1363,7 @@ static bool socket_full(struct pool *pool, int wait)
 /* Check to see if Santa's been good to you */
 bool sock_full(struct pool *pool)
 {
-  if (strlen(pool->sockbuf))
+  if (pool->sockbuf_tail > pool->sockbuf_head)
     return true;
 
   return (socket_full(pool, 0));
@@ -1358,7 +1371,8 @@ bool sock_full(struct pool *pool)
 
 static void clear_sockbuf(struct pool *pool)
 {
-  strcpy(pool->sockbuf, "");
+  pool->sockbuf_head = pool->sockbuf_tail = pool->sockbuf_scan = 0;
+  pool->sockbuf[0] = '\0';
 }
 
 static void clear_sock(struct pool *pool)
@@ -1377,36 +1391,77 @@ static void clear_sock(struct pool *pool)
   clear_sockbuf(pool);
 }
 
-/* Make sure the pool sockbuf is large enough to cope with any coinbase size
- * by reallocing it to a large enough size rounded up to a multiple of RBUFSIZE
- * and zeroing the new memory */
-static void recalloc_sock(struct pool *pool, size_t len)
+/* Make room for another RECVSIZE recv at the tail of the pool sockbuf. Unread
+ * data is only moved back to the start once the tail reaches the end, and the
+ * buffer is doubled when even that isn't enough to cope with a large coinbase */
+static void reserve_sockbuf(struct pool *pool)
 {
-  size_t old, newlen;
+  size_t used, newlen;
+
+  if (pool->sockbuf_size - pool->sockbuf_tail > RECVSIZE)
+    return;
 
-  old = strlen(pool->sockbuf);
-  newlen = old + len + 1;
-  if (newlen < pool->sockbuf_size)
+  used = pool->sockbuf_tail - pool->sockbuf_head;
+  if (pool->sockbuf_head) {
+    memmove(pool->sockbuf, pool->sockbuf + pool->sockbuf_head, used);
+    pool->sockbuf_scan -= pool->sockbuf_head;
+    pool->sockbuf_head = 0;
+    pool->sockbuf_tail = used;
+  }
+  if (pool->sockbuf_size - used > RECVSIZE)
     return;
-  newlen = newlen + (RBUFSIZE - (newlen % RBUFSIZE));
+
+  newlen = pool->sockbuf_size * 2;
   // Avoid potentially recursive locking
-  // applog(LOG_DEBUG, "Recallocing pool sockbuf to %d", new);
+  // applog(LOG_DEBUG, "Reallocing pool sockbuf to %d", newlen);
   pool->sockbuf = (char *)realloc(pool->sockbuf, newlen);
   if (!pool->sockbuf)
     quithere(1, "Failed to realloc pool sockbuf");
-  memset(pool->sockbuf + old, 0, newlen - old);
   pool->sockbuf_size = newlen;
 }
 
-/* Peeks at a socket to find the first end of line and then reads just that
- * from the socket and returns that as a malloced char */
+/* Find the next complete line in the sockbuf, resuming the newline scan where
+ * the last one stopped. The line is terminated in place. */
+static char *sockbuf_line(struct pool *pool, size_t *len)
+{
+  char *line, *eol;
+
+  while (pool->sockbuf_head < pool->sockbuf_tail) {
+    if (pool->sockbuf_scan < pool->sockbuf_head)
+      pool->sockbuf_scan = pool->sockbuf_head;
+    eol = (char *)memchr(pool->sockbuf + pool->sockbuf_scan, '\n',
+             pool->sockbuf_tail - pool->sockbuf_scan);
+    if (!eol) {
+      pool->sockbuf_scan = pool->sockbuf_tail;
+      return NULL;
+    }
+
+    line = pool->sockbuf + pool->sockbuf_head;
+    *eol = '\0';
+    *len = eol - line;
+    pool->sockbuf_head = pool->sockbuf_scan = eol + 1 - pool->sockbuf;
+    if (pool->sockbuf_head == pool->sockbuf_tail)
+      pool->sockbuf_head = pool->sockbuf_tail = pool->sockbuf_scan = 0;
+    /* Skip blank lines */
+    if (*len)
+      return line;
+  }
+
+  return NULL;
+}
+
+/* Reads from the socket until there is a complete line in the pool sockbuf and
+ * returns it. The line is not copied: it is only valid until the next call to
+ * recv_line on the pool and must not be freed, so nothing that handles a line
+ * may read from the pool's socket itself. */
 char *recv_line(struct pool *pool)
 {
-  char *tok, *sret = NULL;
-  ssize_t len, buflen;
+  char *sret = NULL;
+  size_t len = 0;
   int waited = 0;
 
-  if (!strstr(pool->sockbuf, "\n")) {
+  sret = sockbuf_line(pool, &len);
+  if (!sret) {
     struct timeval rstart, now;
 
     cgtime(&rstart);
@@ -1416,12 +1471,11 @@ char *recv_line(struct pool *pool)
     }
 
     do {
-      char s[RBUFSIZE];
-      size_t slen;
       ssize_t n;
 
-      memset(s, 0, RBUFSIZE);
-      n = recv(pool->sock, s, RECVSIZE, 0);
+      reserve_sockbuf(pool);
+      n = recv(pool->sock, pool->sockbuf + pool->sockbuf_tail,
+         pool->sockbuf_size - pool->sockbuf_tail - 1, 0);
       if (!n) {
         applog(LOG_DEBUG, "Socket closed waiting in recv_line");
         suspend_stratum(pool);
@@ -1435,29 +1489,15 @@ char *recv_line(struct pool *pool)
           suspend_stratum(pool);
           break;
         }
-      } else {
-        slen = strlen(s);
-        recalloc_sock(pool, slen);
-        strcat(pool->sockbuf, s);
-      }
-    } while (waited < DEFAULT_SOCKWAIT && !strstr(pool->sockbuf, "\n"));
+      } else
+        pool->sockbuf_tail += n;
+    } while (!(sret = sockbuf_line(pool, &len)) && waited < DEFAULT_SOCKWAIT);
   }
 
-  buflen = strlen(pool->sockbuf);
-
-  if ((tok = strtok(pool->sockbuf, "\n")) == NULL) {
-    applog(LOG_DEBUG, "Failed to parse a \\n terminated string in recv_line: buffer = %s", pool->sockbuf);
+  if (!sret) {
+    applog(LOG_DEBUG, "Failed to parse a \\n terminated string in recv_line");
     goto out;
   }
-  sret = strdup(tok);
-  len = strlen(sret);
-
-  /* Copy what's left in the buffer after the \n, including the
-   * terminating \0 */
-  if (buflen > len + 1)
-    memmove(pool->sockbuf, pool->sockbuf + len + 1, buflen - len + 1);
-  else
-    strcpy(pool->sockbuf, "");
 
   pool->sgminer_pool_stats.times_received++;
   pool->sgminer_pool_stats.bytes_received += len;
@@ -1500,6 +1540,57 @@ static char *json_array_string(json_t *val, unsigned int entry)
   return NULL;
 }
 
+/* Take a reference on a stratum job */
+struct stratum_job *stratum_job_get(struct stratum_job *job)
+{
+  if (job)
+    __atomic_add_fetch(&job->refcount, 1, __ATOMIC_RELAXED);
+  return job;
+}
+
+/* Drop a reference on a stratum job, freeing it with the last one */
+void stratum_job_put(struct stratum_job *job)
+{
+  if (!job || __atomic_sub_fetch(&job->refcount, 1, __ATOMIC_ACQ_REL))
+    return;
+  free(job->job_id);
+  free(job->nonce1);
+  free(job->ntime);
+  free(job);
+}
+
+/* Build the job descriptor from the pool's current notify and difficulty.
+ * Must be called with the pool data_lock held for writing. */
+static struct stratum_job *stratum_job_new(struct pool *pool, bool clean)
+{
+  struct stratum_job *job = (struct stratum_job *)calloc(1, sizeof(struct stratum_job));
+
+  if (unlikely(!job))
+    quithere(1, "Failed to calloc stratum job");
+  job->refcount = 1;
+  job->job_id = strdup(pool->swork.job_id);
+  job->nonce1 = strdup(pool->nonce1);
+  job->ntime = strdup(pool->swork.ntime);
+  job->diff = pool->swork.diff;
+  copy_time(&job->tv_notify, &pool->swork.tv_notify);
+  if (pool->algorithm.type == ALGO_NEOSCRYPT)
+    set_target_neoscrypt(job->target, job->diff, 0);
+  else
+    set_target(job->target, job->diff, pool->algorithm.diff_multiplier2, 0);
+  job->clean = clean;
+
+  return job;
+}
+
+/* Publish a new job; stale_work compares against it without the lock */
+static void stratum_job_replace(struct pool *pool, struct stratum_job *job)
+{
+  struct stratum_job *old = pool->swork.job;
+
+  __atomic_store_n(&pool->swork.job, job, __ATOMIC_RELEASE);
+  stratum_job_put(old);
+}
+
 static char *blank_merkel = "0000000000000000000000000000000000000000000000000000000000000000";
 
 static bool parse_notify(struct pool *pool, json_t *val)
@@ -1510,8 +1601,10 @@ static bool parse_notify(struct pool *pool, json_t *val)
   unsigned char *cb1, *cb2;
   bool clean, ret = false, has_trie = false;
   int merkles, i = 0;
+  struct timeval tv_notify;
   json_t *arr;
 
+  cgtime(&tv_notify);
   has_trie = json_array_size(val) == 10;
 
   job_id = json_array_string(val, i++);
@@ -1567,7 +1660,7 @@ static bool parse_notify(struct pool *pool, json_t *val)
   pool->swork.bbversion = bbversion;
   pool->swork.nbit = nbit;
   pool->swork.ntime = ntime;
-  pool->swork.clean = clean;
+  copy_time(&pool->swork.tv_notify, &tv_notify);
   if (pool->next_diff > 0) {
     pool->swork.diff = pool->next_diff;
   }
@@ -1635,6 +1728,11 @@ static bool parse_notify(struct pool *pool, json_t *val)
   memcpy(pool->coinbase + cb1_len, pool->nonce1bin, pool->n1_len);
   // NOTE: gap for nonce2, filled at work generation time
   memcpy(pool->coinbase + cb1_len + pool->n1_len + pool->n2size, cb2, cb2_len);
+  /* Everything before nonce2 is fixed for this job so work generation
+   * only has to hash nonce2 and the remainder of the coinbase */
+  sph_sha256_init(&pool->cb_midstate);
+  sph_sha256(&pool->cb_midstate, pool->coinbase, pool->nonce2_offset);
+  stratum_job_replace(pool, stratum_job_new(pool, clean));
   cg_wunlock(&pool->data_lock);
 
   if (opt_protocol) {
@@ -1681,6 +1779,10 @@ static bool parse_diff(struct pool *pool, json_t *val)
   } else {
     old_diff = pool->swork.diff;
     pool->next_diff = pool->swork.diff = diff;
+    /* Jobs are immutable so the current one is reissued at the new
+     * difficulty */
+    if (pool->swork.job && old_diff != diff)
+      stratum_job_replace(pool, stratum_job_new(pool, false));
   }
   cg_wunlock(&pool->data_lock);
 
@@ -1779,10 +1881,10 @@ static bool parse_reconnect(struct pool *pool, json_t *val)
   free(tmp);
   mutex_unlock(&pool->stratum_lock);
 
-  if (!restart_stratum(pool)) {
-    pool_failed(pool);
-    return false;
-  }
+  /* Restarting reads from the socket, which would overwrite the line from
+   * recv_line that our caller is still using, so the stratum rthread does
+   * it once it is done with the line */
+  pool->reconnect_pending = true;
 
   return true;
 }
@@ -1907,7 +2009,7 @@ bool subscribe_extranonce(struct pool *pool)
   json_error_t err;
   bool ret = false;
 
-  sprintf(s, "{\"id\": %d, \"method\": \"mining.extranonce.subscribe\", \"params\": []}", swork_id++);
+  sprintf(s, "{\"id\": %d, \"method\": \"mining.extranonce.subscribe\", \"params\": []}", next_swork_id());
 
   if (!stratum_send(pool, s, strlen(s))) {
     return ret;
@@ -1923,19 +2025,13 @@ bool subscribe_extranonce(struct pool *pool)
     }
 
     sret = recv_line(pool);
-    if (!sret) {
+    if (!sret)
       return ret;
-    }
-    else if (parse_method(pool, sret)) {
-      free(sret);
-    }
-    else {
+    if (!parse_method(pool, sret))
       break;
-    }
   }
 
   val = JSON_LOADS(sret, &err);
-  free(sret);
   res_val = json_object_get(val, "result");
   err_val = json_object_get(val, "error");
 
@@ -1982,7 +2078,7 @@ bool auth_stratum(struct pool *pool)
   bool ret = false;
 
   sprintf(s, "{\"id\": %d, \"method\": \"mining.authorize\", \"params\": [\"%s\", \"%s\"]}",
-    swork_id++, pool->rpc_user, pool->rpc_pass);
+    next_swork_id(), pool->rpc_user, pool->rpc_pass);
 
   if (!stratum_send(pool, s, strlen(s))) {
     return ret;
@@ -1992,19 +2088,13 @@ bool auth_stratum(struct pool *pool)
   while (42) {
     sret = recv_line(pool);
 
-    if (!sret) {
+    if (!sret)
       return ret;
-    }
-    else if (parse_method(pool, sret)) {
-      free(sret);
-    }
-    else {
+    if (!parse_method(pool, sret))
       break;
-    }
   }
 
   val = JSON_LOADS(sret, &err);
-  free(sret);
   res_val = json_object_get(val, "result");
   err_val = json_object_get(val, "error");
 
@@ -2481,12 +2571,12 @@ resend:
   if (recvd) {
     /* Get rid of any crap lying around if we're resending */
     clear_sock(pool);
-    sprintf(s, "{\"id\": %d, \"method\": \"mining.subscribe\", \"params\": []}", swork_id++);
+    sprintf(s, "{\"id\": %d, \"method\": \"mining.subscribe\", \"params\": []}", next_swork_id());
   } else {
     if (pool->sessionid)
-      sprintf(s, "{\"id\": %d, \"method\": \"mining.subscribe\", \"params\": [\""PACKAGE"/"CGMINER_VERSION"\", \"%s\"]}", swork_id++, pool->sessionid);
+      sprintf(s, "{\"id\": %d, \"method\": \"mining.subscribe\", \"params\": [\""PACKAGE"/"CGMINER_VERSION"\", \"%s\"]}", next_swork_id(), pool->sessionid);
     else
-      sprintf(s, "{\"id\": %d, \"method\": \"mining.subscribe\", \"params\": [\""PACKAGE"/"CGMINER_VERSION"\"]}", swork_id++);
+      sprintf(s, "{\"id\": %d, \"method\": \"mining.subscribe\", \"params\": [\""PACKAGE"/"CGMINER_VERSION"\"]}", next_swork_id());
   }
 
   if (__stratum_send(pool, s, strlen(s)) != SEND_OK) {
@@ -2506,7 +2596,6 @@ resend:
   recvd = true;
 
   val = JSON_LOADS(sret, &err);
-  free(sret);
   if (!val) {
     applog(LOG_INFO, "JSON decode failed(%d): %s", err.line, err.text);
     goto out;
@@ -2609,7 +2698,8 @@ bool restart_stratum(struct pool *pool)
 {
   applog(LOG_DEBUG, "Restarting stratum on pool %s", get_pool_name(pool));
 
-  if (pool->stratum_active)
+  /* A failed send leaves the socket shut down but open */
+  if (pool->stratum_active || pool->sock)
     suspend_stratum(pool);
   if (!initiate_stratum(pool))
     return false;
@@ -2681,6 +2771,17 @@ void *realloc_strcat(char *ptr, char *s)
   return ret;
 }
 
+/* Move from over to, replacing it in one step. Windows' rename() refuses an
+ * existing destination. */
+bool replace_file(const char *from, const char *to)
+{
+#ifdef WIN32
+  return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  return rename(from, to) == 0;
+#endif
+}
+
 void RenameThread(const char* name)
 {
   char buf[16];
@@ -104,6 +104,7 @@ typedef struct timespec cgtimer_t;
 
 struct thr_info;
 struct pool;
+struct stratum_job;
 enum dev_reason;
 struct cgpu_info;
 int thr_info_create(struct thr_info *thr, pthread_attr_t *attr, void *(*start) (void *), void *arg);
@@ -135,6 +136,8 @@ bool stratum_send(struct pool *pool, char *s, ssize_t len);
 bool sock_full(struct pool *pool);
 char *recv_line(struct pool *pool);
 bool parse_method(struct pool *pool, char *s);
+struct stratum_job *stratum_job_get(struct stratum_job *job);
+void stratum_job_put(struct stratum_job *job);
 bool extract_sockaddr(char *url, char **sockaddr_url, char **sockaddr_port);
 bool auth_stratum(struct pool *pool);
 bool subscribe_extranonce(struct pool *pool);
@@ -143,6 +146,7 @@ bool restart_stratum(struct pool *pool);
 void suspend_stratum(struct pool *pool);
 void dev_error(struct cgpu_info *dev, enum dev_reason reason);
 void *realloc_strcat(char *ptr, char *s);
+bool replace_file(const char *from, const char *to);
 void RenameThread(const char* name);
 void _cgsem_init(cgsem_t *cgsem, const char *file, const char *func, const int line);
 void _cgsem_post(cgsem_t *cgsem, const char *file, const char *func, const int line);